@@ -0,0 +1,12 @@
+// File generated by tests/Makefile.inc
+// Do not change
+#include <config.src.h>
+
+#undef CONFIG_CONSOLE_CBMEM
+#define CONFIG_CONSOLE_CBMEM 0
+
+#ifdef __clang__
+#pragma clang system_header
+#endif
+#ifdef __TEST_SRCOBJ__
+#endif
@@ -0,0 +1,9 @@
+// File generated by tests/Makefile.inc
+// Do not change
+#include <config.src.h>
+
+#ifdef __clang__
+#pragma clang system_header
+#endif
+#ifdef __TEST_SRCOBJ__
+#endif
@@ -0,0 +1,26 @@
+// File generated by tests/Makefile.inc
+// Do not change
+#include <config.src.h>
+
+#undef CONFIG_ARCH_X86
+#define CONFIG_ARCH_X86 0
+
+#undef CONFIG_COLLECT_TIMESTAMPS
+#define CONFIG_COLLECT_TIMESTAMPS 0
+
+#undef CONFIG_NO_CBFS_MCACHE
+#define CONFIG_NO_CBFS_MCACHE 1
+
+#undef CONFIG_NO_CBFS_MCACHE
+#define CONFIG_NO_CBFS_MCACHE 0
+
+#ifdef __clang__
+#pragma clang system_header
+#endif
+#ifdef __TEST_SRCOBJ__
+#pragma weak cbfs_get_boot_device
+#pragma weak cbfs_lookup
+#pragma weak cbfs_mcache_lookup
+#pragma weak mem_pool_alloc
+#pragma weak mem_pool_free
+#endif
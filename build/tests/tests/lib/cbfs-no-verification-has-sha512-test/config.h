@@ -0,0 +1,29 @@
+// File generated by tests/Makefile.inc
+// Do not change
+#include <config.src.h>
+
+#undef CONFIG_COLLECT_TIMESTAMPS
+#define CONFIG_COLLECT_TIMESTAMPS 0
+
+#undef CONFIG_CBFS_VERIFICATION
+#define CONFIG_CBFS_VERIFICATION 1
+
+#undef CONFIG_NO_CBFS_MCACHE
+#define CONFIG_NO_CBFS_MCACHE 1
+
+#undef VB2_SUPPORT_SHA512
+#define VB2_SUPPORT_SHA512 0
+
+#undef CONFIG_CBFS_VERIFICATION
+#define CONFIG_CBFS_VERIFICATION 0
+
+#undef VB2_SUPPORT_SHA512
+#define VB2_SUPPORT_SHA512 1
+
+#ifdef __clang__
+#pragma clang system_header
+#endif
+#ifdef __TEST_SRCOBJ__
+#pragma weak cbfs_get_boot_device
+#pragma weak cbfs_lookup
+#endif
@@ -0,0 +1,12 @@
+// File generated by tests/Makefile.inc
+// Do not change
+#include <config.src.h>
+
+#undef CONFIG_CBMEM_STAGE_CACHE
+#define CONFIG_CBMEM_STAGE_CACHE 1
+
+#ifdef __clang__
+#pragma clang system_header
+#endif
+#ifdef __TEST_SRCOBJ__
+#endif
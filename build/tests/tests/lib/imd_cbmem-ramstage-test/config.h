@@ -0,0 +1,10 @@
+// File generated by tests/Makefile.inc
+// Do not change
+#include <config.src.h>
+
+#ifdef __clang__
+#pragma clang system_header
+#endif
+#ifdef __TEST_SRCOBJ__
+#pragma weak cbmem_top_chipset
+#endif
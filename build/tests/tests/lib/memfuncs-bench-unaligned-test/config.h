@@ -0,0 +1,12 @@
+// File generated by tests/Makefile.inc
+// Do not change
+#include <config.src.h>
+
+#undef CONFIG_HAVE_EFFICIENT_UNALIGNED_ACCESS
+#define CONFIG_HAVE_EFFICIENT_UNALIGNED_ACCESS 1
+
+#ifdef __clang__
+#pragma clang system_header
+#endif
+#ifdef __TEST_SRCOBJ__
+#endif
@@ -0,0 +1,22 @@
+// File generated by tests/Makefile.inc
+// Do not change
+#include <config.src.h>
+
+#undef CONFIG_SPD_CACHE_FMAP_NAME
+#define CONFIG_SPD_CACHE_FMAP_NAME "RW_SPD_CACHE"
+
+#undef CONFIG_DIMM_MAX
+#define CONFIG_DIMM_MAX 4
+
+#undef CONFIG_DIMM_SPD_SIZE
+#define CONFIG_DIMM_SPD_SIZE 512
+
+#undef CONFIG_BOOT_DEVICE_MEMORY_MAPPED
+#define CONFIG_BOOT_DEVICE_MEMORY_MAPPED 1
+
+#ifdef __clang__
+#pragma clang system_header
+#endif
+#ifdef __TEST_SRCOBJ__
+#pragma weak fmap_locate_area_as_rdev
+#endif
@@ -0,0 +1,13 @@
+// File generated by tests/Makefile.inc
+// Do not change
+#include <config.src.h>
+
+#ifdef __clang__
+#pragma clang system_header
+#endif
+#ifdef __TEST_SRCOBJ__
+#pragma weak _cbfs_alloc
+#pragma weak cbfs_unmap
+#pragma weak vb2api_get_locale_id
+#pragma weak vboot_get_context
+#endif
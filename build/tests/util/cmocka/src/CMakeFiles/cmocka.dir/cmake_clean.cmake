@@ -0,0 +1,11 @@
+file(REMOVE_RECURSE
+  "CMakeFiles/cmocka.dir/cmocka.c.o"
+  "CMakeFiles/cmocka.dir/cmocka.c.o.d"
+  "libcmocka.pdb"
+  "libcmocka.so"
+)
+
+# Per-language clean rules from dependency scanning.
+foreach(lang C)
+  include(CMakeFiles/cmocka.dir/cmake_clean_${lang}.cmake OPTIONAL)
+endforeach()
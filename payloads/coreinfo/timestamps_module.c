@@ -7,6 +7,8 @@
 
 #define LINES_SHOWN 19
 #define TAB_WIDTH 2
+/* Far more than coreboot ever links, only there to stop on a corrupted chain. */
+#define MAX_CHUNKS 256
 
 /* Globals that are used for tracking screen state */
 static char *g_buf;
@@ -129,6 +131,21 @@ static uint64_t timestamp_print_entry(char *buffer, size_t size, uint32_t *cur,
 	return step_time;
 }
 
+/* A table that coreboot had to grow continues in further chunks. */
+static const struct timestamp_table *timestamp_next_chunk(const struct timestamp_table *ts)
+{
+	const struct timestamp_entry *last;
+
+	if (!ts->num_entries)
+		return NULL;
+
+	last = &ts->entries[ts->num_entries - 1];
+	if (last->entry_id != TS_TABLE_CONTINUATION)
+		return NULL;
+
+	return phys_to_virt(last->entry_stamp);
+}
+
 static int timestamps_module_init(void)
 {
 	/* Make sure that lib_sysinfo is initialized */
@@ -144,26 +161,48 @@ static int timestamps_module_init(void)
 
 	/* Extract timestamps information */
 	u64 base_time = timestamps->base_time;
-	u16 max_entries = timestamps->max_entries;
-	u32 n_entries = timestamps->num_entries;
+	u32 n_entries = 0;
+	u64 dropped = 0;
 
 	timestamp_set_tick_freq(timestamps->tick_freq_mhz);
 
+	const struct timestamp_table *chunk;
+	u32 n_chunks = 0;
 	char *buffer;
 	u32 buff_cur = 0;
 	uint64_t prev_stamp;
 	uint64_t total_time;
 
-	/* Allocate a buffer big enough to contain all of the possible
+	/* Count the timestamps in all chunks. Links to further chunks and dropped
+	 * counts aren't timestamps. */
+	for (chunk = timestamps; chunk; chunk = timestamp_next_chunk(chunk)) {
+		if (++n_chunks > MAX_CHUNKS)
+			return -1;
+
+		for (u32 i = 0; i < chunk->num_entries; i++) {
+			const struct timestamp_entry *tse = &chunk->entries[i];
+
+			if (tse->entry_id == TS_TABLE_DROPPED)
+				dropped += tse->entry_stamp;
+			else if (tse->entry_id != TS_TABLE_CONTINUATION)
+				n_entries++;
+		}
+	}
+
+	/* Allocate a buffer big enough to contain all of the
 	 * entries plus the other information (number entries, total time). */
-	buffer = malloc((max_entries + 4) * SCREEN_X * sizeof(char));
+	buffer = malloc((n_entries + 5) * SCREEN_X * sizeof(char));
 
 	if (buffer == NULL)
 		return -3;
 
 	/* Write the content */
-	buff_cur += snprintf(buffer, SCREEN_X, "%d entries total:\n\n",
-			n_entries);
+	if (dropped)
+		buff_cur += snprintf(buffer, SCREEN_X, "%d entries total, %llu dropped:\n\n",
+				n_entries, dropped);
+	else
+		buff_cur += snprintf(buffer, SCREEN_X, "%d entries total:\n\n",
+				n_entries);
 
 	prev_stamp = 0;
 	timestamp_print_entry(buffer, SCREEN_X, &buff_cur, 0, base_time,
@@ -171,14 +210,20 @@ static int timestamps_module_init(void)
 	prev_stamp = base_time;
 
 	total_time = 0;
-	for (u32 i = 0; i < n_entries; i++) {
-		uint64_t stamp;
-		const struct timestamp_entry *tse = &timestamps->entries[i];
-
-		stamp = tse->entry_stamp + base_time;
-		total_time += timestamp_print_entry(buffer, SCREEN_X,
-				&buff_cur, tse->entry_id, stamp, prev_stamp);
-		prev_stamp = stamp;
+	for (chunk = timestamps; chunk; chunk = timestamp_next_chunk(chunk)) {
+		for (u32 i = 0; i < chunk->num_entries; i++) {
+			uint64_t stamp;
+			const struct timestamp_entry *tse = &chunk->entries[i];
+
+			if (tse->entry_id == TS_TABLE_CONTINUATION ||
+			    tse->entry_id == TS_TABLE_DROPPED)
+				continue;
+
+			stamp = tse->entry_stamp + base_time;
+			total_time += timestamp_print_entry(buffer, SCREEN_X,
+					&buff_cur, tse->entry_id, stamp, prev_stamp);
+			prev_stamp = stamp;
+		}
 	}
 
 	buff_cur += snprintf(buffer + buff_cur, SCREEN_X, "\nTotal Time: ");
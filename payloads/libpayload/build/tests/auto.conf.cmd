@@ -0,0 +1,16 @@
+deps_config := \
+	arch/mock/Kconfig \
+	arch/x86/Kconfig \
+	arch/arm64/Kconfig \
+	arch/arm/Kconfig \
+	drivers/usb/Kconfig \
+	drivers/storage/Kconfig \
+	drivers/timer/Kconfig \
+	vboot/Kconfig \
+	libcbfs/Kconfig \
+	/root/repo/payloads/libpayload/Kconfig \
+
+build/tests/auto.conf: $(deps_config)
+
+
+$(deps_config): ;
@@ -0,0 +1,119 @@
+/*
+ * Automatically generated file; DO NOT EDIT.
+ * Libpayload Configuration
+ */
+#define CONFIG_LP_PC_KEYBOARD_LAYOUT_US 0
+#define CONFIG_LP_EXPERIMENTAL 0
+#define CONFIG_LP_LITTLE_ENDIAN 1
+#define CONFIG_LP_ENABLE_APIC 0
+#define CONFIG_LP_USB_UHCI 0
+#define CONFIG_LP_PC_KEYBOARD_TRANSLATION 0
+#define CONFIG_LP_LZ4 1
+#define CONFIG_LP_USB_EHCI 1
+#define CONFIG_LP_MOUSE_CURSOR 0
+#define CONFIG_LP_USB 1
+#define CONFIG_LP_RTC_PORT_EXTENDED_VIA 0
+#define CONFIG_LP_SERIAL_CONSOLE 1
+#define CONFIG_LP_VGA_VIDEO_CONSOLE 0
+#define CONFIG_LP_BIG_ENDIAN 0
+#define CONFIG_LP_USB_EHCI_HOSTPC_ROOT_HUB_TT 0
+#define CONFIG_LP_QCS405_SERIAL_CONSOLE 0
+#define CONFIG_LP_IGNORE_UNKNOWN_INTERRUPTS 0
+#define CONFIG_LP_IO_ADDRESS_SPACE 0
+#define CONFIG_LP_COMPILER_LLVM_CLANG 0
+#define CONFIG_LP_NVRAM 0
+#define CONFIG_LP_VBOOT_CBFS_INTEGRATION 0
+#define CONFIG_LP_S5P_SERIAL_CONSOLE 0
+#define CONFIG_LP_LTO 0
+#define CONFIG_LP_LIBC 1
+#define CONFIG_LP_ARCH_MOCK 1
+#define CONFIG_LP_ARCH_X86 0
+#define CONFIG_LP_STORAGE_NVME 0
+#define CONFIG_LP_PC_KEYBOARD 0
+#define CONFIG_LP_PCI_IO_OPS 0
+#define CONFIG_LP_PDCURSES 1
+#define CONFIG_LP_DEVELOPER 0
+#define CONFIG_LP_USB_GEN_HUB 1
+#define CONFIG_LP_GEODELX_VIDEO_CONSOLE 0
+#define CONFIG_LP_CBFS 1
+#define CONFIG_LP_COMPILER_GCC 1
+#define CONFIG_LP_USB_PCI 0
+#define CONFIG_LP_HEAP_SIZE 131072
+#define CONFIG_LP_DIE_ON_UNKNOWN_INTERRUPT 0
+#define CONFIG_LP_PCIE_MEDIATEK 0
+#define CONFIG_LP_STACK_SIZE 16384
+#define CONFIG_LP_VBOOT_X86_SHA_EXT 0
+#define CONFIG_LP_COREBOOT_VIDEO_CENTERED 0
+#define CONFIG_LP_TIMER_RDTSC 0
+#define CONFIG_LP_IPQ806X_SERIAL_CONSOLE 0
+#define CONFIG_LP_8250_SERIAL_CONSOLE 0
+#define CONFIG_LP_TIMER_GENERIC_HIGH_REG 0x0
+#define CONFIG_LP_DMA_LIM_EXCL 0
+#define CONFIG_LP_SPEAKER 0
+#define CONFIG_LP_USB_HID 1
+#define CONFIG_LP_LOG_UNKNOWN_INTERRUPTS 0
+#define CONFIG_LP_VIDEO_CONSOLE 1
+#define CONFIG_LP_UDC_CI 0
+#define CONFIG_LP_IPQ40XX_SERIAL_CONSOLE 0
+#define CONFIG_LP_QUALCOMM_QUPV3_SERIAL_CONSOLE 0
+#define CONFIG_LP_PL011_SERIAL_CONSOLE 0
+#define CONFIG_LP_GPL 0
+#define CONFIG_LP_USB_XHCI_MTK_QUIRK 0
+#define CONFIG_LP_TIMER_MCT 0
+#define CONFIG_LP_PC_KEYBOARD_LAYOUT_DE 0
+#define CONFIG_LP_MEMMAP_RAM_ONLY 0
+#define CONFIG_LP_SERIAL_SET_SPEED 0
+#define CONFIG_LP_TIMER_IPQ806X 0
+#define CONFIG_LP_VBOOT_SHA_ARMV8_CE 0
+#define CONFIG_LP_PCI 0
+#define CONFIG_LP_COREBOOT_VIDEO_CONSOLE 0
+#define CONFIG_LP_CBMEM_CONSOLE 1
+#define CONFIG_LP_TIMER_GENERIC_REG 0x0
+#define CONFIG_LP_TIMER_RK3399 0
+#define CONFIG_LP_DEBUG_CBFS 0
+#define CONFIG_LP_BASE_ADDRESS 0x00000000
+#define CONFIG_LP_VBOOT_LIB 0
+#define CONFIG_LP_TIMER_IPQ40XX 0
+#define CONFIG_LP_REMOTEGDB 0
+#define CONFIG_LP_TINYCURSES 0
+#define CONFIG_LP_USB_DWC2 0
+#define CONFIG_LP_SKIP_CONSOLE_INIT 0
+#define CONFIG_LP_SERIAL_ACS_FALLBACK 0
+#define CONFIG_LP_TIMER_ARM64_ARCH 0
+#define CONFIG_LP_FONT_SCALE_FACTOR 0
+#define CONFIG_LP_USB_HUB 1
+#define CONFIG_LP_STORAGE_AHCI_ONLY_TESTED 0
+#define CONFIG_LP_USB_XHCI 1
+#define CONFIG_LP_CHROMEOS 0
+#define CONFIG_LP_ARM64_A53_ERRATUM_843419 0
+#define CONFIG_LP_ARCH_MOCK_BIG_ENDIAN 0
+#define CONFIG_LP_USB_MSC 1
+#define CONFIG_LP_CBGFX_FAST_RESAMPLE 0
+#define CONFIG_LP_STORAGE_ATAPI 1
+#define CONFIG_LP_DEBUG_MALLOC 0
+#define CONFIG_LP_ARCH_ARM 0
+#define CONFIG_LP_CURSES 1
+#define CONFIG_LP_TIMER_MTK_V2 0
+#define CONFIG_LP_VBOOT_TPM2_MODE 0
+#define CONFIG_LP_MULTIBOOT 0
+#define CONFIG_LP_SERIAL_IOBASE 0
+#define CONFIG_LP_TIMER_MTK 0
+#define CONFIG_LP_STORAGE_64BIT_LBA 1
+#define CONFIG_LP_STORAGE 1
+#define CONFIG_LP_PC_MOUSE 0
+#define CONFIG_LP_USB_OHCI 1
+#define CONFIG_LP_TIMER_RK3288 0
+#define CONFIG_LP_SERIAL_BAUD_RATE 0
+#define CONFIG_LP_PC_I8042 0
+#define CONFIG_LP_ENABLE_CBFS_FALLBACK 0
+#define CONFIG_LP_ARCH_ARM64 0
+#define CONFIG_LP_LZMA 1
+#define CONFIG_LP_TIMER_NONE 1
+#define CONFIG_LP_TIMER_GENERIC_HZ 0
+#define CONFIG_LP_STORAGE_AHCI 0
+#define CONFIG_LP_CBFS_VERIFICATION 0
+#define CONFIG_LP_UDC_DWC2 0
+#define CONFIG_LP_PCIE_QCOM 0
+#define CONFIG_LP_TIMER_TEGRA_1US 0
+#define CONFIG_LP_STORAGE_ATA 1
+#define CONFIG_LP_UDC 0
@@ -0,0 +1,17 @@
+// File generated by tests/Makefile.inc
+// Do not change
+#ifndef TEST_LIBPAYLOAD_CONFIG_H_
+#define TEST_LIBPAYLOAD_CONFIG_H_
+#include <libpayload-config.src.h>
+
+#ifdef __clang__
+#pragma clang system_header
+#endif
+
+#ifdef __TEST_SRCOBJ__
+#pragma weak inb
+#pragma weak outb
+#pragma weak arch_ndelay
+#endif
+
+#endif
@@ -0,0 +1,14 @@
+// File generated by tests/Makefile.inc
+// Do not change
+#ifndef TEST_LIBPAYLOAD_CONFIG_H_
+#define TEST_LIBPAYLOAD_CONFIG_H_
+#include <libpayload-config.src.h>
+
+#ifdef __clang__
+#pragma clang system_header
+#endif
+
+#ifdef __TEST_SRCOBJ__
+#endif
+
+#endif
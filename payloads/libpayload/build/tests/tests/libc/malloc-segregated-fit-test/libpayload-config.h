@@ -0,0 +1,26 @@
+// File generated by tests/Makefile.inc
+// Do not change
+#ifndef TEST_LIBPAYLOAD_CONFIG_H_
+#define TEST_LIBPAYLOAD_CONFIG_H_
+#include <libpayload-config.src.h>
+
+#undef CONFIG_LP_MALLOC_FIRST_FIT
+#define CONFIG_LP_MALLOC_FIRST_FIT 1
+
+#undef CONFIG_LP_MALLOC_SEGREGATED_FIT
+#define CONFIG_LP_MALLOC_SEGREGATED_FIT 0
+
+#undef CONFIG_LP_MALLOC_FIRST_FIT
+#define CONFIG_LP_MALLOC_FIRST_FIT 0
+
+#undef CONFIG_LP_MALLOC_SEGREGATED_FIT
+#define CONFIG_LP_MALLOC_SEGREGATED_FIT 1
+
+#ifdef __clang__
+#pragma clang system_header
+#endif
+
+#ifdef __TEST_SRCOBJ__
+#endif
+
+#endif
@@ -0,0 +1,23 @@
+// File generated by tests/Makefile.inc
+// Do not change
+#ifndef TEST_LIBPAYLOAD_CONFIG_H_
+#define TEST_LIBPAYLOAD_CONFIG_H_
+#include <libpayload-config.src.h>
+
+#undef CONFIG_LP_ENABLE_CBFS_FALLBACK
+#define CONFIG_LP_ENABLE_CBFS_FALLBACK 0
+
+#undef CONFIG_LP_LZ4
+#define CONFIG_LP_LZ4 1
+
+#undef CONFIG_LP_LZMA
+#define CONFIG_LP_LZMA 1
+
+#ifdef __clang__
+#pragma clang system_header
+#endif
+
+#ifdef __TEST_SRCOBJ__
+#endif
+
+#endif
@@ -0,0 +1,32 @@
+// File generated by tests/Makefile.inc
+// Do not change
+#ifndef TEST_LIBPAYLOAD_CONFIG_H_
+#define TEST_LIBPAYLOAD_CONFIG_H_
+#include <libpayload-config.src.h>
+
+#undef CONFIG_LP_CBFS_VERIFICATION
+#define CONFIG_LP_CBFS_VERIFICATION 1
+
+#undef VB2_SUPPORT_SHA512
+#define VB2_SUPPORT_SHA512 0
+
+#undef VB2_SUPPORT_SHA512
+#define VB2_SUPPORT_SHA512 1
+
+#undef CONFIG_LP_CBFS_VERIFICATION
+#define CONFIG_LP_CBFS_VERIFICATION 0
+
+#undef CONFIG_LP_CBFS_VERIFICATION
+#define CONFIG_LP_CBFS_VERIFICATION 0
+
+#undef VB2_SUPPORT_SHA512
+#define VB2_SUPPORT_SHA512 1
+
+#ifdef __clang__
+#pragma clang system_header
+#endif
+
+#ifdef __TEST_SRCOBJ__
+#endif
+
+#endif
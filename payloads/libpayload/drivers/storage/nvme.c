@@ -21,10 +21,32 @@
 #define NVME_CC_IOSQES	(6 << 16)
 #define NVME_CC_IOCQES	(4 << 20)
 
-#define NVME_QUEUE_SIZE 2
+#define NVME_ADMIN_QUEUE_SIZE 2
+#define NVME_IO_QUEUE_SIZE 8
 #define NVME_SQ_ENTRY_SIZE 64
 #define NVME_CQ_ENTRY_SIZE 16
 
+/* A PRP list page holds 512 entries, we don't chain lists. */
+#define NVME_PRP_LIST_ENTRIES (0x1000 / sizeof(uint64_t))
+
+enum nvme_slot_state {
+	NVME_SLOT_FREE = 0,
+	NVME_SLOT_BUSY,		/* Submitted, not completed yet */
+	NVME_SLOT_DONE,		/* Completed, not reaped by its owner yet */
+};
+
+/*
+ * Every read in flight on the I/O queue owns a slot. The slot index is used as command
+ * identifier, so completions can be matched to it whatever order they arrive in.
+ */
+struct nvme_slot {
+	uint64_t *prp_list;
+	size_t offset;		/* First block, relative to the start of a synchronous read */
+	uint8_t state;
+	bool async;		/* Submitted through read_submit512(), reaped by read_poll() */
+	int status;
+};
+
 struct nvme_dev {
 	storage_dev_t storage_dev;
 
@@ -35,9 +57,13 @@ struct nvme_dev {
 		uint32_t *bell;
 		uint16_t idx; // bool pos 0 or 1
 		uint16_t round; // bool round 0 or 1+0xd
+		uint16_t size;
 	} queue[4];
 
-	uint64_t *prp_list;
+	/* The I/O queue always keeps one entry free, so it can't fill up. */
+	struct nvme_slot slots[NVME_IO_QUEUE_SIZE - 1];
+	unsigned int io_slots;
+	size_t max_blocks;	/* Largest transfer in 512-byte blocks */
 };
 
 
@@ -70,14 +96,14 @@ static int nvme_cmd(
 
 	void *s_entry = nvme->queue[sq].base + (nvme->queue[sq].idx * NVME_SQ_ENTRY_SIZE);
 	memcpy(s_entry, cmd, NVME_SQ_ENTRY_SIZE);
-	nvme->queue[sq].idx = (nvme->queue[sq].idx + 1) & (NVME_QUEUE_SIZE - 1);
+	nvme->queue[sq].idx = (nvme->queue[sq].idx + 1) % nvme->queue[sq].size;
 	write32(nvme->queue[sq].bell, nvme->queue[sq].idx);
 
 	struct nvme_c_queue_entry *c_entry = nvme->queue[cq].base +
 		(nvme->queue[cq].idx * NVME_CQ_ENTRY_SIZE);
 	while (((read32(&c_entry->dw[3]) >> 16) & 0x1) == nvme->queue[cq].round)
 		;
-	nvme->queue[cq].idx = (nvme->queue[cq].idx + 1) & (NVME_QUEUE_SIZE - 1);
+	nvme->queue[cq].idx = (nvme->queue[cq].idx + 1) % nvme->queue[cq].size;
 	write32(nvme->queue[cq].bell, nvme->queue[cq].idx);
 	if (nvme->queue[cq].idx == 0)
 		nvme->queue[cq].round = (nvme->queue[cq].round + 1) & 1;
@@ -136,6 +162,16 @@ static int delete_admin_queues(struct nvme_dev *nvme)
 	return 0;
 }
 
+static void free_prp_lists(struct nvme_dev *nvme)
+{
+	unsigned int slot;
+
+	for (slot = 0; slot < ARRAY_SIZE(nvme->slots); ++slot) {
+		free(nvme->slots[slot].prp_list);
+		nvme->slots[slot].prp_list = NULL;
+	}
+}
+
 static void nvme_detach_device(struct storage_dev *dev)
 {
 	struct nvme_dev *nvme = (struct nvme_dev *)dev;
@@ -167,16 +203,35 @@ static void nvme_detach_device(struct storage_dev *dev)
 	uint16_t command = pci_read_config16(nvme->pci_dev, PCI_COMMAND);
 	pci_write_config16(nvme->pci_dev, PCI_COMMAND, command & ~PCI_COMMAND_MASTER);
 
-	free(nvme->prp_list);
+	free_prp_lists(nvme);
 }
 
-static int nvme_read(struct nvme_dev *nvme, unsigned char *buffer, uint64_t base, uint16_t count)
+/*
+ * Returns the slot of the queued read, or -1 if it's too large or no slot is free.
+ * Asynchronous reads never take the last free slot. It stays reserved for synchronous
+ * reads, which otherwise couldn't make progress while the caller holds every slot with
+ * reads it hasn't reaped yet.
+ */
+static int nvme_submit_read(struct nvme_dev *nvme, unsigned char *buffer, uint64_t base,
+			    size_t count, bool async)
 {
-	if (count == 0 || count > 512)
+	unsigned int slot, free_slots = 0, first_free = nvme->io_slots;
+
+	if (count == 0 || count > nvme->max_blocks)
 		return -1;
 
+	for (slot = 0; slot < nvme->io_slots; ++slot) {
+		if (nvme->slots[slot].state != NVME_SLOT_FREE)
+			continue;
+		if (!free_slots++)
+			first_free = slot;
+	}
+	if (free_slots == 0 || (async && free_slots == 1))
+		return -1;
+	slot = first_free;
+
 	struct nvme_s_queue_entry e = {
-		.dw[0] = 0x02,
+		.dw[0] = 0x02 | slot << 16,
 		.dw[1] = 0x1,
 		.dw[6] = virt_to_phys(buffer),
 		.dw[10] = base,
@@ -192,45 +247,138 @@ static int nvme_read(struct nvme_dev *nvme, unsigned char *buffer, uint64_t base
 		/* Crossing exactly one page boundary, PRP2 is second page */
 		e.dw[8] = virt_to_phys(buffer + 0x1000) & ~0xfff;
 	} else {
-		/* Use a single page as PRP list, PRP2 points to the list */
+		/* Use the slot's PRP list page, PRP2 points to the list */
+		uint64_t *const prp_list = nvme->slots[slot].prp_list;
 		unsigned int i;
 		for (i = 0; i < end_page - start_page; ++i) {
 			buffer += 0x1000;
-			nvme->prp_list[i] = virt_to_phys(buffer) & ~0xfff;
+			prp_list[i] = virt_to_phys(buffer) & ~0xfff;
+		}
+		e.dw[8] = virt_to_phys(prp_list);
+	}
+
+	nvme->slots[slot].state = NVME_SLOT_BUSY;
+	nvme->slots[slot].async = async;
+
+	void *s_entry = nvme->queue[ios].base + (nvme->queue[ios].idx * NVME_SQ_ENTRY_SIZE);
+	memcpy(s_entry, &e, NVME_SQ_ENTRY_SIZE);
+	nvme->queue[ios].idx = (nvme->queue[ios].idx + 1) % nvme->queue[ios].size;
+	write32(nvme->queue[ios].bell, nvme->queue[ios].idx);
+
+	return slot;
+}
+
+/* Hands all completions posted so far to their slots, without waiting for more. */
+static void nvme_reap_completions(struct nvme_dev *nvme)
+{
+	bool reaped = false;
+
+	for (;;) {
+		struct nvme_c_queue_entry *c_entry = nvme->queue[ioc].base +
+			(nvme->queue[ioc].idx * NVME_CQ_ENTRY_SIZE);
+		const uint32_t dw3 = read32(&c_entry->dw[3]);
+		if (((dw3 >> 16) & 0x1) == nvme->queue[ioc].round)
+			break;
+
+		const unsigned int slot = dw3 & 0xffff;
+		if (slot < nvme->io_slots && nvme->slots[slot].state == NVME_SLOT_BUSY) {
+			nvme->slots[slot].status = dw3 >> 17;
+			nvme->slots[slot].state = NVME_SLOT_DONE;
+		} else {
+			printf("NVMe ERROR: Completion for unknown command %u\n", slot);
 		}
-		e.dw[8] = virt_to_phys(nvme->prp_list);
+
+		nvme->queue[ioc].idx = (nvme->queue[ioc].idx + 1) % nvme->queue[ioc].size;
+		if (nvme->queue[ioc].idx == 0)
+			nvme->queue[ioc].round = (nvme->queue[ioc].round + 1) & 1;
+		reaped = true;
 	}
 
-	return nvme_cmd(nvme, ios, &e);
+	if (reaped)
+		write32(nvme->queue[ioc].bell, nvme->queue[ioc].idx);
 }
 
+/*
+ * Splits the read into the largest transfers the controller takes and keeps as many
+ * of them in flight as there are free slots. Reads queued through read_submit512()
+ * take slots away until they are reaped with read_poll(), but always leave one.
+ */
 static ssize_t nvme_read_blocks512(
 		struct storage_dev *const dev,
 		const lba_t start, const size_t count, unsigned char *const buf)
 {
-	unsigned int off = 0;
-	while (off < count) {
-		const unsigned int blocks = MIN(count - off, 512);
-		if (nvme_read((struct nvme_dev *)dev, buf + (off * 512), start + off, blocks))
-			return off;
-		off += blocks;
+	struct nvme_dev *const nvme = (struct nvme_dev *)dev;
+	size_t off = 0, failed = count;
+	unsigned int pending = 0, slot;
+
+	while ((off < count && failed == count) || pending) {
+		if (off < count && failed == count) {
+			const size_t blocks = MIN(count - off, nvme->max_blocks);
+			const int s = nvme_submit_read(nvme, buf + (off * 512), start + off,
+						       blocks, false);
+			if (s >= 0) {
+				nvme->slots[s].offset = off;
+				off += blocks;
+				pending++;
+				continue;
+			}
+			/* Nothing of ours to wait for, return what was read so far. */
+			if (!pending)
+				return off;
+		}
+
+		nvme_reap_completions(nvme);
+		for (slot = 0; slot < nvme->io_slots; ++slot) {
+			struct nvme_slot *const sl = &nvme->slots[slot];
+			if (sl->state != NVME_SLOT_DONE || sl->async)
+				continue;
+			/* Only report the blocks up to the first failed transfer. */
+			if (sl->status)
+				failed = MIN(failed, sl->offset);
+			sl->state = NVME_SLOT_FREE;
+			pending--;
+		}
 	}
-	return count;
+	return failed;
 }
 
-static int create_io_submission_queue(struct nvme_dev *nvme)
+static int nvme_read_submit512(
+		struct storage_dev *const dev,
+		const lba_t start, const size_t count, unsigned char *const buf)
+{
+	return nvme_submit_read((struct nvme_dev *)dev, buf, start, count, true);
+}
+
+static int nvme_read_poll(struct storage_dev *const dev, int *const status)
+{
+	struct nvme_dev *const nvme = (struct nvme_dev *)dev;
+	unsigned int slot;
+
+	nvme_reap_completions(nvme);
+	for (slot = 0; slot < nvme->io_slots; ++slot) {
+		struct nvme_slot *const sl = &nvme->slots[slot];
+		if (sl->state == NVME_SLOT_DONE && sl->async) {
+			*status = sl->status;
+			sl->state = NVME_SLOT_FREE;
+			return slot;
+		}
+	}
+	return -1;
+}
+
+static int create_io_submission_queue(struct nvme_dev *nvme, uint16_t size)
 {
-	void *sq_buffer = memalign(0x1000, NVME_SQ_ENTRY_SIZE * NVME_QUEUE_SIZE);
+	void *sq_buffer = memalign(0x1000, NVME_SQ_ENTRY_SIZE * size);
 	if (!sq_buffer) {
 		printf("NVMe ERROR: Failed to allocate memory for io submission queue.\n");
 		return -1;
 	}
-	memset(sq_buffer, 0, NVME_SQ_ENTRY_SIZE * NVME_QUEUE_SIZE);
+	memset(sq_buffer, 0, NVME_SQ_ENTRY_SIZE * size);
 
 	struct nvme_s_queue_entry e = {
 		.dw[0]  = 0x01,
 		.dw[6]  = virt_to_phys(sq_buffer),
-		.dw[10] = ((NVME_QUEUE_SIZE - 1) << 16) | ios >> 1,
+		.dw[10] = ((size - 1) << 16) | ios >> 1,
 		.dw[11] = (1 << 16) | 1,
 	};
 
@@ -245,22 +393,23 @@ static int create_io_submission_queue(struct nvme_dev *nvme)
 	nvme->queue[ios].base = sq_buffer;
 	nvme->queue[ios].bell = nvme->config + 0x1000 + (ios * (4 << cap_dstrd));
 	nvme->queue[ios].idx = 0;
+	nvme->queue[ios].size = size;
 	return 0;
 }
 
-static int create_io_completion_queue(struct nvme_dev *nvme)
+static int create_io_completion_queue(struct nvme_dev *nvme, uint16_t size)
 {
-	void *const cq_buffer = memalign(0x1000, NVME_CQ_ENTRY_SIZE * NVME_QUEUE_SIZE);
+	void *const cq_buffer = memalign(0x1000, NVME_CQ_ENTRY_SIZE * size);
 	if (!cq_buffer) {
 		printf("NVMe ERROR: Failed to allocate memory for io completion queue.\n");
 		return -1;
 	}
-	memset(cq_buffer, 0, NVME_CQ_ENTRY_SIZE * NVME_QUEUE_SIZE);
+	memset(cq_buffer, 0, NVME_CQ_ENTRY_SIZE * size);
 
 	const struct nvme_s_queue_entry e = {
 		.dw[0]  = 0x05,
 		.dw[6]  = virt_to_phys(cq_buffer),
-		.dw[10] = ((NVME_QUEUE_SIZE - 1) << 16) | ioc >> 1,
+		.dw[10] = ((size - 1) << 16) | ioc >> 1,
 		.dw[11] = 1,
 	};
 
@@ -276,6 +425,7 @@ static int create_io_completion_queue(struct nvme_dev *nvme)
 	nvme->queue[ioc].bell  = nvme->config + 0x1000 + (ioc * (4 << cap_dstrd));
 	nvme->queue[ioc].idx   = 0;
 	nvme->queue[ioc].round = 0;
+	nvme->queue[ioc].size  = size;
 
 	return 0;
 }
@@ -283,34 +433,76 @@ static int create_io_completion_queue(struct nvme_dev *nvme)
 static int create_admin_queues(struct nvme_dev *nvme)
 {
 	uint8_t cap_dstrd = (read64(nvme->config) >> 32) & 0xf;
-	write32(nvme->config + 0x24, (NVME_QUEUE_SIZE - 1) << 16 | (NVME_QUEUE_SIZE - 1));
+	write32(nvme->config + 0x24,
+		(NVME_ADMIN_QUEUE_SIZE - 1) << 16 | (NVME_ADMIN_QUEUE_SIZE - 1));
 
-	void *sq_buffer = memalign(0x1000, NVME_SQ_ENTRY_SIZE * NVME_QUEUE_SIZE);
+	void *sq_buffer = memalign(0x1000, NVME_SQ_ENTRY_SIZE * NVME_ADMIN_QUEUE_SIZE);
 	if (!sq_buffer) {
 		printf("NVMe ERROR: Failed to allocated memory for admin submission queue\n");
 		return -1;
 	}
-	memset(sq_buffer, 0, NVME_SQ_ENTRY_SIZE * NVME_QUEUE_SIZE);
+	memset(sq_buffer, 0, NVME_SQ_ENTRY_SIZE * NVME_ADMIN_QUEUE_SIZE);
 	write64(nvme->config + 0x28, virt_to_phys(sq_buffer));
 
 	nvme->queue[ads].base = sq_buffer;
 	nvme->queue[ads].bell = nvme->config + 0x1000 + (ads * (4 << cap_dstrd));
 	nvme->queue[ads].idx = 0;
+	nvme->queue[ads].size = NVME_ADMIN_QUEUE_SIZE;
 
-	void *cq_buffer = memalign(0x1000, NVME_CQ_ENTRY_SIZE * NVME_QUEUE_SIZE);
+	void *cq_buffer = memalign(0x1000, NVME_CQ_ENTRY_SIZE * NVME_ADMIN_QUEUE_SIZE);
 	if (!cq_buffer) {
 		printf("NVMe ERROR: Failed to allocate memory for admin completion queue\n");
 		free(cq_buffer);
 		return -1;
 	}
-	memset(cq_buffer, 0, NVME_CQ_ENTRY_SIZE * NVME_QUEUE_SIZE);
+	memset(cq_buffer, 0, NVME_CQ_ENTRY_SIZE * NVME_ADMIN_QUEUE_SIZE);
 	write64(nvme->config + 0x30, virt_to_phys(cq_buffer));
 
 	nvme->queue[adc].base = cq_buffer;
 	nvme->queue[adc].bell = nvme->config + 0x1000 + (adc * (4 << cap_dstrd));
 	nvme->queue[adc].idx = 0;
 	nvme->queue[adc].round = 0;
+	nvme->queue[adc].size = NVME_ADMIN_QUEUE_SIZE;
+
+	return 0;
+}
+
+/*
+ * Limits transfers to what the controller takes (MDTS), what a single PRP list page
+ * can describe and what fits the 16-bit block count of a read command.
+ */
+static int identify_max_transfer(struct nvme_dev *nvme)
+{
+	uint8_t *const data = memalign(0x1000, 0x1000);
+	if (!data) {
+		printf("NVMe ERROR: Failed to allocate buffer for identify data\n");
+		return -1;
+	}
+
+	const struct nvme_s_queue_entry e = {
+		.dw[0]  = 0x06,
+		.dw[6]  = virt_to_phys(data),
+		.dw[10] = 1, /* Identify Controller */
+	};
+
+	int res = nvme_cmd(nvme, NVME_ADMIN_QUEUE, &e);
+	if (res) {
+		printf("NVMe ERROR: Identify Controller returned with %i.\n", res);
+		free(data);
+		return res;
+	}
 
+	const uint8_t mdts = data[77];
+	const uint8_t cap_mpsmin = (read64(nvme->config) >> 48) & 0xf;
+
+	nvme->max_blocks = MIN(NVME_PRP_LIST_ENTRIES * 0x1000 / 512, 0x10000);
+	if (mdts) { /* in units of the minimum page size, 0 means no limit */
+		/* Anything beyond 4GiB is no limit either, and mdts can be up to 255. */
+		const unsigned int shift = MIN(12 + cap_mpsmin + mdts, 32);
+		nvme->max_blocks = MIN(nvme->max_blocks, ((uint64_t)1 << shift) / 512);
+	}
+
+	free(data);
 	return 0;
 }
 
@@ -325,7 +517,7 @@ static void nvme_init(pcidev_t dev)
 		printf("NVMe ERROR: PCIe device does not support the NVMe command set\n");
 		return;
 	}
-	struct nvme_dev *nvme = malloc(sizeof(*nvme));
+	struct nvme_dev *nvme = calloc(1, sizeof(*nvme));
 	if (!nvme) {
 		printf("NVMe ERROR: Failed to allocate buffer for nvme driver struct\n");
 		return;
@@ -334,14 +526,29 @@ static void nvme_init(pcidev_t dev)
 	nvme->storage_dev.poll			= nvme_poll;
 	nvme->storage_dev.read_blocks512	= nvme_read_blocks512;
 	nvme->storage_dev.write_blocks512	= NULL;
+	nvme->storage_dev.read_submit512	= nvme_read_submit512;
+	nvme->storage_dev.read_poll		= nvme_read_poll;
 	nvme->storage_dev.detach_device		= nvme_detach_device;
 	nvme->pci_dev				= dev;
 	nvme->config				= pci_bar0;
-	nvme->prp_list				= memalign(0x1000, 0x1000);
 
-	if (!nvme->prp_list) {
-		printf("NVMe ERROR: Failed to allocate buffer for PRP list\n");
-		goto _free_abort;
+	/* CAP.MQES is zero-based, the queue needs at least two entries. */
+	const uint16_t io_queue_size =
+		MIN(NVME_IO_QUEUE_SIZE, (read64(pci_bar0) & 0xffff) + 1);
+	nvme->io_slots = io_queue_size - 1;
+	/* With a single slot, it's reserved for synchronous reads. */
+	if (nvme->io_slots < 2) {
+		nvme->storage_dev.read_submit512 = NULL;
+		nvme->storage_dev.read_poll = NULL;
+	}
+
+	unsigned int slot;
+	for (slot = 0; slot < nvme->io_slots; ++slot) {
+		nvme->slots[slot].prp_list = memalign(0x1000, 0x1000);
+		if (!nvme->slots[slot].prp_list) {
+			printf("NVMe ERROR: Failed to allocate buffer for PRP list\n");
+			goto _free_abort;
+		}
 	}
 
 	const uint32_t cc = NVME_CC_EN | NVME_CC_CSS | NVME_CC_MPS | NVME_CC_AMS | NVME_CC_SHN
@@ -380,9 +587,12 @@ static void nvme_init(pcidev_t dev)
 
 	uint16_t command = pci_read_config16(dev, PCI_COMMAND);
 	pci_write_config16(dev, PCI_COMMAND, command | PCI_COMMAND_MASTER);
-	if (create_io_completion_queue(nvme))
+	if (identify_max_transfer(nvme))
+		goto _delete_admin_abort;
+	nvme->storage_dev.max_request_blocks512 = nvme->max_blocks;
+	if (create_io_completion_queue(nvme, io_queue_size))
 		goto _delete_admin_abort;
-	if (create_io_submission_queue(nvme))
+	if (create_io_submission_queue(nvme, io_queue_size))
 		goto _delete_completion_abort;
 	storage_attach_device((storage_dev_t *)nvme);
 	printf("NVMe init done.\n");
@@ -393,7 +603,7 @@ _delete_completion_abort:
 _delete_admin_abort:
 	delete_admin_queues(nvme);
 _free_abort:
-	free(nvme->prp_list);
+	free_prp_lists(nvme);
 	free(nvme);
 	printf("NVMe init failed.\n");
 }
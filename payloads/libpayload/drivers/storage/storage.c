@@ -100,6 +100,72 @@ ssize_t storage_read_blocks512(const size_t dev_num,
 		return -1;
 }
 
+/**
+ * Largest asynchronous read request
+ *
+ * Returns the maximum number of blocks a single storage_read_submit512()
+ * request may cover, or 0 if drive dev_num doesn't support asynchronous
+ * reads.
+ *
+ * @dev_num device number counted from 0
+ */
+size_t storage_max_request_blocks512(const size_t dev_num)
+{
+	if ((dev_num < dev_count) && devices[dev_num]->read_submit512)
+		return devices[dev_num]->max_request_blocks512;
+	else
+		return 0;
+}
+
+/**
+ * Queue an asynchronous read of 512-byte blocks
+ *
+ * Starts reading count blocks from block start of drive dev_num into
+ * buf and returns without waiting for the data. count must not exceed
+ * storage_max_request_blocks512(). The contents of buf are undefined
+ * until storage_read_poll() reported the request as finished.
+ *
+ * Returns a tag >= 0 that identifies the request, or -1 if the request
+ * couldn't be queued, e.g. because the drive has no free slots left.
+ * Every queued request has to be reaped with storage_read_poll().
+ *
+ * @dev_num device number counted from 0
+ * @start number of first block to read from
+ * @count number of blocks to read
+ * @buf buffer where the read data should be written
+ */
+int storage_read_submit512(const size_t dev_num,
+			   const lba_t start, const size_t count,
+			   unsigned char *const buf)
+{
+	if ((dev_num < dev_count) && devices[dev_num]->read_submit512)
+		return devices[dev_num]->read_submit512(
+				devices[dev_num], start, count, buf);
+	else
+		return -1;
+}
+
+/**
+ * Reap a finished asynchronous read
+ *
+ * Checks drive dev_num for a finished storage_read_submit512() request
+ * without blocking. Requests may finish in any order.
+ *
+ * Returns the tag of the finished request and sets *status to 0 if it
+ * succeeded or to a non-zero value otherwise, or returns -1 if no
+ * request has finished yet.
+ *
+ * @dev_num device number counted from 0
+ * @status where the result of the request is stored
+ */
+int storage_read_poll(const size_t dev_num, int *const status)
+{
+	if ((dev_num < dev_count) && devices[dev_num]->read_poll)
+		return devices[dev_num]->read_poll(devices[dev_num], status);
+	else
+		return -1;
+}
+
 /**
  * Initializes storage controllers
  *
@@ -96,9 +96,14 @@ usb_msc_destroy(usbdev_t *dev)
 
 const int DEV_RESET = 0xff;
 const int GET_MAX_LUN = 0xfe;
-/* Many USB3 devices do not work with large transfer requests.
- * Limit the request size to 64KB chunks to ensure maximum compatibility. */
+/* Many USB3 devices do not work with large transfer requests. */
 const int MAX_CHUNK_BYTES = 1024 * 64;
+/* With CONFIG_LP_USB_MSC_LARGE_TRANSFERS, what Linux uses, 240 and 2048
+ * sectors, for devices behind an EHCI or xHCI controller. Devices that fail
+ * larger requests fall back to 64KB chunks. Other controllers can't go beyond
+ * their 64KB bounce buffers. */
+const int HS_CHUNK_BYTES = 1024 * 120;
+const int SS_CHUNK_BYTES = 1024 * 1024;
 
 const unsigned int cbw_signature = 0x43425355;
 const unsigned int csw_signature = 0x53425355;
@@ -313,6 +318,15 @@ typedef struct {
 	unsigned char control;	//9 - the block is 10 bytes long
 } __packed cmdblock_t;
 
+typedef struct {
+	unsigned char command;	//0
+	unsigned char res1;	//1 - service action for READ CAPACITY(16)
+	unsigned long long block;	//2-9
+	unsigned int numblocks;	//10-13 - allocation length for READ CAPACITY(16)
+	unsigned char res2;	//14
+	unsigned char control;	//15 - the block is 16 bytes long
+} __packed cmdblock16_t;
+
 typedef struct {
 	unsigned char command;	//0
 	unsigned char res1;	//1
@@ -339,10 +353,10 @@ typedef struct {
  * @param n number of sectors to access
  * @param dir direction of access: cbw_direction_data_in == read, cbw_direction_data_out == write
  * @param buf buffer to read into or write from. Must be at least n*512 bytes
- * @return 0 on success, 1 on failure
+ * @return 0 on success, non-zero on failure
  */
 int
-readwrite_blocks_512(usbdev_t *dev, int start, int n,
+readwrite_blocks_512(usbdev_t *dev, u64 start, int n,
 	cbw_direction dir, u8 *buf)
 {
 	int blocksize_divider = MSC_INST(dev)->blocksize / 512;
@@ -350,44 +364,181 @@ readwrite_blocks_512(usbdev_t *dev, int start, int n,
 		n / blocksize_divider, dir, buf);
 }
 
+/*
+ * Fills in a READ or WRITE command block and returns its length. READ(10)
+ * and WRITE(10) only take 32-bit block addresses, the 16 byte variants are
+ * only used for blocks beyond that.
+ */
+static int
+wrap_readwrite(u8 *cb, u64 start, int n, cbw_direction dir)
+{
+	if (start + n - 1 > 0xffffffff) {
+		cmdblock16_t *const cb16 = (cmdblock16_t *)cb;
+		memset(cb16, 0, sizeof(*cb16));
+		cb16->command = (dir == cbw_direction_data_in) ? 0x88 : 0x8a;
+		cb16->block = htonll(start);
+		cb16->numblocks = htonl(n);
+		return sizeof(*cb16);
+	} else {
+		cmdblock_t *const cb10 = (cmdblock_t *)cb;
+		memset(cb10, 0, sizeof(*cb10));
+		cb10->command = (dir == cbw_direction_data_in) ? 0x28 : 0x2a;
+		cb10->block = htonl(start);
+		cb10->numblocks = htonw(n);
+		return sizeof(*cb10);
+	}
+}
+
 /**
- * Reads or writes a number of sequential blocks on a USB storage device.
- * As it uses the READ(10) SCSI-2 command, it's limited to storage devices
- * of at most 2TB. It assumes sectors of 512 bytes.
+ * Reads or writes a number of sequential blocks on a USB storage device
+ * with a single command.
  *
  * @param dev device to access
  * @param start first sector to access
  * @param n number of sectors to access
  * @param dir direction of access: cbw_direction_data_in == read, cbw_direction_data_out == write
  * @param buf buffer to read into or write from. Must be at least n*sectorsize bytes
- * @return 0 on success, 1 on failure
+ * @return MSC_COMMAND_OK on success, MSC_COMMAND_FAIL or MSC_COMMAND_DETACHED on failure
  */
 static int
-readwrite_chunk(usbdev_t *dev, int start, int n, cbw_direction dir, u8 *buf)
+readwrite_chunk(usbdev_t *dev, u64 start, int n, cbw_direction dir, u8 *buf)
 {
-	cmdblock_t cb;
-	memset(&cb, 0, sizeof(cb));
-	if (dir == cbw_direction_data_in) {
-		// read
-		cb.command = 0x28;
-	} else {
-		// write
-		cb.command = 0x2a;
+	u8 cb[sizeof(cmdblock16_t)];
+	const int cblen = wrap_readwrite(cb, start, n, dir);
+
+	return execute_command(dev, dir, cb, cblen, buf,
+				n * MSC_INST(dev)->blocksize, 0);
+}
+
+/* Largest number of blocks to transfer with one command. */
+static int
+chunk_blocks(usbdev_t *dev, const u8 *buf)
+{
+	/* Buffers that need bouncing are limited by the bounce buffer. */
+	const unsigned int bytes = dma_coherent(buf)
+		? MSC_INST(dev)->chunk_bytes : MAX_CHUNK_BYTES;
+	return MAX(bytes / MSC_INST(dev)->blocksize, 1);
+}
+
+#define PIPELINE_DEPTH 2
+
+/* CBWs and CSWs of the commands in flight, the controller accesses them
+   directly. */
+static struct {
+	cbw_t cbw[PIPELINE_DEPTH];
+	csw_t csw[PIPELINE_DEPTH];
+} *pipeline;
+
+static int
+can_pipeline(usbdev_t *dev, const u8 *buf)
+{
+	if (!CONFIG(LP_USB_MSC_PIPELINE) ||
+	    !dev->controller->bulk_queue || !dma_coherent(buf) ||
+	    (MSC_INST(dev)->quirks &
+	     (USB_MSC_QUIRK_NO_PIPELINE | USB_MSC_QUIRK_NO_RESET)))
+		return 0;
+
+	if (!pipeline)
+		pipeline = dma_memalign(64, sizeof(*pipeline));
+	return pipeline && dma_coherent(pipeline);
+}
+
+static int
+queue_command(usbdev_t *dev, int slot, u64 start, int n, cbw_direction dir,
+	      u8 *buf)
+{
+	usbmsc_inst_t *const msc = MSC_INST(dev);
+	hci_t *const ctrlr = dev->controller;
+	endpoint_t *const data_ep = (dir == cbw_direction_data_in)
+		? msc->bulk_in : msc->bulk_out;
+	u8 cb[sizeof(cmdblock16_t)];
+	const int cblen = wrap_readwrite(cb, start, n, dir);
+
+	wrap_cbw(&pipeline->cbw[slot], n * msc->blocksize, dir, cb, cblen,
+		 msc->lun);
+	if (ctrlr->bulk_queue(msc->bulk_out, sizeof(cbw_t),
+			      (u8 *)&pipeline->cbw[slot]) ||
+	    ctrlr->bulk_queue(data_ep, n * msc->blocksize, buf) ||
+	    ctrlr->bulk_queue(msc->bulk_in, sizeof(csw_t),
+			      (u8 *)&pipeline->csw[slot]))
+		return MSC_COMMAND_FAIL;
+	return MSC_COMMAND_OK;
+}
+
+static int
+finish_command(usbdev_t *dev, int slot, int n, cbw_direction dir)
+{
+	usbmsc_inst_t *const msc = MSC_INST(dev);
+	hci_t *const ctrlr = dev->controller;
+	endpoint_t *const data_ep = (dir == cbw_direction_data_in)
+		? msc->bulk_in : msc->bulk_out;
+	const csw_t *const csw = &pipeline->csw[slot];
+
+	/* Anything but complete success is left to the synchronous path. */
+	if (ctrlr->bulk_wait(msc->bulk_out) != sizeof(cbw_t) ||
+	    ctrlr->bulk_wait(data_ep) != n * msc->blocksize ||
+	    ctrlr->bulk_wait(msc->bulk_in) != sizeof(csw_t) ||
+	    csw->dCSWSignature != csw_signature ||
+	    csw->dCSWTag != pipeline->cbw[slot].dCBWTag ||
+	    csw->bCSWStatus != 0 || csw->dCSWDataResidue != 0)
+		return MSC_COMMAND_FAIL;
+	return MSC_COMMAND_OK;
+}
+
+/*
+ * Keeps the CBW, data and CSW stages of the next command queued behind the
+ * current one, so the device can take the next CBW right after it sent the
+ * CSW and the controller never waits for us in between.
+ *
+ * If anything goes wrong, the transport is reset and the device continues
+ * with one command at a time for good. *done is set to the number of blocks
+ * that were transferred successfully.
+ */
+static int
+readwrite_pipelined(usbdev_t *dev, u64 start, int n, cbw_direction dir,
+		    u8 *buf, int *done)
+{
+	usbmsc_inst_t *const msc = MSC_INST(dev);
+	const int chunk_size = chunk_blocks(dev, buf);
+	const int chunks = DIV_ROUND_UP(n, chunk_size);
+	int chunk, queued = 0, ret = MSC_COMMAND_OK;
+
+	for (chunk = 0; chunk < chunks; chunk++) {
+		for (; queued < chunks && queued < chunk + PIPELINE_DEPTH;
+		     queued++) {
+			const int off = queued * chunk_size;
+			ret = queue_command(dev, queued % PIPELINE_DEPTH,
+					    start + off,
+					    MIN(chunk_size, n - off), dir,
+					    buf + off * msc->blocksize);
+			if (ret != MSC_COMMAND_OK)
+				break;
+		}
+		if (ret == MSC_COMMAND_OK)
+			ret = finish_command(dev, chunk % PIPELINE_DEPTH,
+					     MIN(chunk_size,
+						 n - chunk * chunk_size),
+					     dir);
+		if (ret != MSC_COMMAND_OK)
+			break;
 	}
-	cb.block = htonl(start);
-	cb.numblocks = htonw(n);
 
-	return execute_command(dev, dir, (u8 *) &cb, sizeof(cb), buf,
-				n * MSC_INST(dev)->blocksize, 0)
-		!= MSC_COMMAND_OK ? 1 : 0;
+	*done = MIN(chunk * chunk_size, n);
+	if (ret == MSC_COMMAND_OK)
+		return MSC_COMMAND_OK;
+
+	usb_debug("MSC: queued command failed, no longer queueing commands\n");
+	dev->controller->bulk_cancel(msc->bulk_out);
+	dev->controller->bulk_cancel(msc->bulk_in);
+	msc->quirks |= USB_MSC_QUIRK_NO_PIPELINE;
+	return reset_transport(dev);
 }
 
 /**
  * Reads or writes a number of sequential blocks on a USB storage device
- * that is split into MAX_CHUNK_BYTES size requests.
+ * that is split into chunk_bytes size requests.
  *
- * As it uses the READ(10) SCSI-2 command, it's limited to storage devices
- * of at most 2TB. It assumes sectors of 512 bytes.
+ * Blocks beyond 32-bit addresses are accessed with READ(16) and WRITE(16).
  *
  * @param dev device to access
  * @param start first sector to access
@@ -396,33 +547,37 @@ readwrite_chunk(usbdev_t *dev, int start, int n, cbw_direction dir, u8 *buf)
  *                                 cbw_direction_data_out == write
  * @param buf buffer to read into or write from.
  *            Must be at least n*sectorsize bytes
- * @return 0 on success, 1 on failure
+ * @return 0 on success, non-zero on failure
  */
 int
-readwrite_blocks(usbdev_t *dev, int start, int n, cbw_direction dir, u8 *buf)
+readwrite_blocks(usbdev_t *dev, u64 start, int n, cbw_direction dir, u8 *buf)
 {
-	int chunk_size = MAX_CHUNK_BYTES / MSC_INST(dev)->blocksize;
-	int chunk;
-
-	/* Read as many full chunks as needed. */
-	for (chunk = 0; chunk < (n / chunk_size); chunk++) {
-		if (readwrite_chunk(dev, start + (chunk * chunk_size),
-				     chunk_size, dir,
-				     buf + (chunk * MAX_CHUNK_BYTES))
-		    != MSC_COMMAND_OK)
-			return 1;
+	usbmsc_inst_t *const msc = MSC_INST(dev);
+	int done = 0, ret;
+
+	if (can_pipeline(dev, buf)) {
+		ret = readwrite_pipelined(dev, start, n, dir, buf, &done);
+		if (ret != MSC_COMMAND_FAIL)
+			return ret;
 	}
 
-	/* Read any remaining partial chunk at the end. */
-	if (n % chunk_size) {
-		if (readwrite_chunk(dev, start + (chunk * chunk_size),
-				     n % chunk_size, dir,
-				     buf + (chunk * MAX_CHUNK_BYTES))
-		    != MSC_COMMAND_OK)
-			return 1;
+	while (done < n) {
+		const int blocks = MIN(chunk_blocks(dev, buf), n - done);
+		ret = readwrite_chunk(dev, start + done, blocks, dir,
+				      buf + done * msc->blocksize);
+		if (ret == MSC_COMMAND_FAIL &&
+		    blocks * msc->blocksize > MAX_CHUNK_BYTES) {
+			usb_debug("MSC: falling back to %d byte transfers\n",
+				  MAX_CHUNK_BYTES);
+			msc->chunk_bytes = MAX_CHUNK_BYTES;
+			continue;
+		}
+		if (ret != MSC_COMMAND_OK)
+			return ret;
+		done += blocks;
 	}
 
-	return 0;
+	return MSC_COMMAND_OK;
 }
 
 /* Only request it, we don't interpret it.
@@ -491,6 +646,27 @@ spin_up(usbdev_t *dev)
 				sizeof(cb), 0, 0, 0);
 }
 
+static int
+read_capacity16(usbdev_t *dev)
+{
+	cmdblock16_t cb;
+	memset(&cb, 0, sizeof(cb));
+	cb.command = 0x9e;	// service action in
+	cb.res1 = 0x10;		// read capacity (16)
+	cb.numblocks = htonl(32);
+	u32 buf[8];
+
+	int ret = execute_command(dev, cbw_direction_data_in, (u8 *) &cb,
+				  sizeof(cb), (u8 *)buf, sizeof(buf), 1);
+	if (ret != MSC_COMMAND_OK) {
+		usb_debug("  READ CAPACITY(16) failed, only using the first 2 TB.\n");
+		return ret;
+	}
+	MSC_INST(dev)->numblocks = ntohll(*(u64 *)buf) + 1;
+	MSC_INST(dev)->blocksize = ntohl(buf[2]);
+	return MSC_COMMAND_OK;
+}
+
 static int
 read_capacity(usbdev_t *dev)
 {
@@ -520,14 +696,17 @@ read_capacity(usbdev_t *dev)
 		MSC_INST(dev)->numblocks = 0xffffffff;
 		MSC_INST(dev)->blocksize = 512;
 	} else {
-		MSC_INST(dev)->numblocks = ntohl(buf[0]) + 1;
+		MSC_INST(dev)->numblocks = ntohl(buf[0]) + 1ULL;
 		MSC_INST(dev)->blocksize = ntohl(buf[1]);
+		/* The last block doesn't fit, the device has more to tell */
+		if (ntohl(buf[0]) == 0xffffffff) {
+			ret = read_capacity16(dev);
+			if (ret == MSC_COMMAND_DETACHED)
+				return ret;
+		}
 	}
-	usb_debug("  %d %d-byte sectors (%d MB)\n", MSC_INST(dev)->numblocks,
-		MSC_INST(dev)->blocksize,
-		/* round down high block counts to avoid integer overflow */
-		MSC_INST(dev)->numblocks > 1000000
-			? (MSC_INST(dev)->numblocks / 1000) * MSC_INST(dev)->blocksize / 1000 :
+	usb_debug("  %llu %d-byte sectors (%llu MB)\n",
+		MSC_INST(dev)->numblocks, MSC_INST(dev)->blocksize,
 		MSC_INST(dev)->numblocks * MSC_INST(dev)->blocksize / 1000 / 1000);
 	return MSC_COMMAND_OK;
 }
@@ -651,6 +830,11 @@ void usb_msc_force_init(usbdev_t *dev, u32 quirks)
 	MSC_INST(dev)->bulk_out = 0;
 	MSC_INST(dev)->usbdisk_created = 0;
 	MSC_INST(dev)->quirks = quirks;
+	MSC_INST(dev)->chunk_bytes = MAX_CHUNK_BYTES;
+	if (CONFIG(LP_USB_MSC_LARGE_TRANSFERS) &&
+	    (dev->controller->type == EHCI || dev->controller->type == XHCI))
+		MSC_INST(dev)->chunk_bytes = is_usb_speed_ss(dev->speed)
+			? SS_CHUNK_BYTES : HS_CHUNK_BYTES;
 
 	for (i = 1; i <= dev->num_endp; i++) {
 		if (dev->endpoints[i].endpoint == 0)
@@ -40,6 +40,9 @@ static void xhci_reset(hci_t *controller);
 static void xhci_reinit(hci_t *controller);
 static void xhci_shutdown(hci_t *controller);
 static int xhci_bulk(endpoint_t *ep, int size, u8 *data, int finalize);
+static int xhci_bulk_queue(endpoint_t *ep, int size, u8 *data);
+static int xhci_bulk_wait(endpoint_t *ep);
+static void xhci_bulk_cancel(endpoint_t *ep);
 static int xhci_control(usbdev_t *dev, direction_t dir, int drlen, void *devreq,
 			 int dalen, u8 *data);
 static void* xhci_create_intr_queue(endpoint_t *ep, int reqsize, int reqcount, int reqtiming);
@@ -168,6 +171,9 @@ xhci_init(unsigned long physical_bar)
 	controller->init		= xhci_reinit;
 	controller->shutdown		= xhci_shutdown;
 	controller->bulk		= xhci_bulk;
+	controller->bulk_queue		= xhci_bulk_queue;
+	controller->bulk_wait		= xhci_bulk_wait;
+	controller->bulk_cancel		= xhci_bulk_cancel;
 	controller->control		= xhci_control;
 	controller->set_address		= xhci_set_address;
 	controller->finish_device_config = xhci_finish_device_config;
@@ -798,6 +804,92 @@ xhci_bulk(endpoint_t *const ep, const int size, u8 *const src,
 	return ret;
 }
 
+/*
+ * Queued transfers go straight to the ring without a bounce buffer, so the
+ * controller can work through all of them without waiting for us.
+ */
+static int
+xhci_bulk_queue(endpoint_t *const ep, const int size, u8 *const data)
+{
+	xhci_t *const xhci = XHCI_INST(ep->dev->controller);
+	const int slot_id = ep->dev->address;
+	const int ep_id = xhci_ep_id(ep);
+	epctx_t *const epctx = xhci->dev[slot_id].ctx.ep[ep_id];
+	transfer_ring_t *const tr = xhci->dev[slot_id].transfer_rings[ep_id];
+	bulkq_t *const q = &xhci->dev[slot_id].bulk_queues[ep_id];
+
+	if (!dma_coherent(data) || q->queued == BULKQ_SIZE)
+		return -1;
+
+	/* One TRB per 64KiB boundary crossed plus the Event Data TRB */
+	const size_t first = (size_t)data >> 16;
+	const size_t last = ((size_t)data + MAX(size, 1) - 1) >> 16;
+	const int trbs = last - first + 2;
+	int i, used = 0;
+	for (i = 0; i < q->queued; ++i)
+		used += q->trbs[i];
+	if (used + trbs > TRANSFER_RING_SIZE - 2)
+		return -1;
+
+	/* Reset endpoint if it's not running, unless that would drop
+	   transfers queued before */
+	const unsigned ep_state = EC_GET(STATE, epctx);
+	if (ep_state > 1) {
+		if (q->queued || xhci_reset_endpoint(ep->dev, ep))
+			return -1;
+	}
+
+	const unsigned mps = EC_GET(MPS, epctx);
+	const unsigned dir = (ep->direction == OUT) ? TRB_DIR_OUT : TRB_DIR_IN;
+	xhci_enqueue_td(tr, ep_id, mps, size, data, dir);
+	xhci_ring_doorbell(ep);
+
+	q->trbs[q->queued++] = trbs;
+	return 0;
+}
+
+static int
+xhci_bulk_wait(endpoint_t *const ep)
+{
+	xhci_t *const xhci = XHCI_INST(ep->dev->controller);
+	bulkq_t *const q =
+		&xhci->dev[ep->dev->address].bulk_queues[xhci_ep_id(ep)];
+
+	if (!q->queued)
+		return -1;
+
+	const int ret = xhci_wait_for_queued_transfer(xhci, q);
+	if (ret < 0) {
+		xhci_debug("Queued bulk transfer failed: %d\n", ret);
+		/* The endpoint won't run the transfers behind it */
+		xhci_bulk_cancel(ep);
+		return ret;
+	}
+
+	--q->queued;
+	--q->done;
+	memmove(q->trbs, q->trbs + 1, q->queued * sizeof(q->trbs[0]));
+	memmove(q->result, q->result + 1, q->done * sizeof(q->result[0]));
+	return ret;
+}
+
+static void
+xhci_bulk_cancel(endpoint_t *const ep)
+{
+	xhci_t *const xhci = XHCI_INST(ep->dev->controller);
+	const int slot_id = ep->dev->address;
+	const int ep_id = xhci_ep_id(ep);
+	epctx_t *const epctx = xhci->dev[slot_id].ctx.ep[ep_id];
+	bulkq_t *const q = &xhci->dev[slot_id].bulk_queues[ep_id];
+
+	/* A stopped endpoint gets its ring reset before the next transfer */
+	if (q->queued > q->done && EC_GET(STATE, epctx) == 1) {
+		xhci_debug("Stopping ID %d EP %d\n", slot_id, ep_id);
+		xhci_cmd_stop_endpoint(xhci, slot_id, ep_id);
+	}
+	memset(q, 0, sizeof(*q));
+}
+
 static trb_t *
 xhci_next_trb(trb_t *cur, int *const pcs)
 {
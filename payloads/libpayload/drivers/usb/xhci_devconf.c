@@ -464,6 +464,7 @@ xhci_destroy_dev(hci_t *const controller, const int slot_id)
 			free((void *)di->transfer_rings[i]->ring);
 		free(di->transfer_rings[i]);
 		free(di->interrupt_queues[i]);
+		memset(&di->bulk_queues[i], 0, sizeof(di->bulk_queues[i]));
 	}
 
 	xhci_spew("Stopped slot %d, but not disabling it yet.\n", slot_id);
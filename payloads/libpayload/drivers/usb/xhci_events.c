@@ -86,6 +86,8 @@ xhci_handle_transfer_event(xhci_t *const xhci)
 	const int ep = TRB_GET(EP, ev);
 
 	intrq_t *intrq;
+	bulkq_t *const bulkq = (id && id <= xhci->max_slots_en)
+		? &xhci->dev[id].bulk_queues[ep] : NULL;
 
 	if (id && id <= xhci->max_slots_en &&
 			(intrq = xhci->dev[id].interrupt_queues[ep])) {
@@ -101,6 +103,12 @@ xhci_handle_transfer_event(xhci_t *const xhci)
 		}
 	} else if (cc == CC_STOPPED || cc == CC_STOPPED_LENGTH_INVALID) {
 		/* Ignore 'Forced Stop Events' */
+	} else if (bulkq && bulkq->queued > bulkq->done) {
+		/* It's the oldest unfinished queued bulk transfer */
+		if (cc == CC_SUCCESS || cc == CC_SHORT_PACKET)
+			bulkq->result[bulkq->done++] = TRB_GET(EVTL, ev);
+		else
+			bulkq->result[bulkq->done++] = -cc;
 	} else {
 		xhci_debug("Warning: "
 			   "Spurious transfer event for ID %d, EP %d:\n"
@@ -344,3 +352,24 @@ xhci_wait_for_transfer(xhci_t *const xhci, const int slot_id, const int ep_id)
 	xhci_update_event_dq(xhci);
 	return ret;
 }
+
+/*
+ * Wait for the oldest transfer on a bulk queue to finish. Events of other
+ * endpoints are handled meanwhile, including those of other bulk queues.
+ *
+ * Returns the number of bytes transferred, a negative completion code or
+ * TIMEOUT.
+ */
+int
+xhci_wait_for_queued_transfer(xhci_t *const xhci, const bulkq_t *const q)
+{
+	/* 5s for all types of transfers */
+	unsigned long timeout_us = USB_MAX_PROCESSING_TIME_US;
+	while (!q->done &&
+	       xhci_wait_for_event_type(xhci, TRB_EV_TRANSFER, &timeout_us))
+		xhci_handle_transfer_event(xhci);
+	if (!q->done)
+		xhci_debug("Warning: Timed out waiting for TRB_EV_TRANSFER.\n");
+	xhci_update_event_dq(xhci);
+	return q->done ? q->result[0] : TIMEOUT;
+}
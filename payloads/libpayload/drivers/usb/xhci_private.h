@@ -159,7 +159,7 @@ typedef struct {
 } event_ring_t;
 
 /* Never raise this above 256 to prevent transfer event length overflow! */
-#define TRANSFER_RING_SIZE 32
+#define TRANSFER_RING_SIZE 64
 typedef struct {
 	trb_t *ring;
 	trb_t *cur;
@@ -306,10 +306,19 @@ typedef struct intrq {
 	endpoint_t *ep;
 } intrq_t;
 
+#define BULKQ_SIZE 4
+typedef struct bulkq {
+	u8 queued;		/* Transfers queued and not collected yet */
+	u8 done;		/* The oldest ones of those that finished */
+	u8 trbs[BULKQ_SIZE];	/* TRBs used by each queued transfer */
+	int result[BULKQ_SIZE];	/* Bytes transferred or error of finished ones */
+} bulkq_t;
+
 typedef struct devinfo {
 	devctx_t ctx;
 	transfer_ring_t *transfer_rings[NUM_EPS];
 	intrq_t *interrupt_queues[NUM_EPS];
+	bulkq_t bulk_queues[NUM_EPS];
 } devinfo_t;
 
 typedef struct erst_entry {
@@ -497,6 +506,7 @@ void xhci_handle_events(xhci_t *);
 int xhci_wait_for_command_aborted(xhci_t *, const trb_t *);
 int xhci_wait_for_command_done(xhci_t *, const trb_t *, int clear_event);
 int xhci_wait_for_transfer(xhci_t *, const int slot_id, const int ep_id);
+int xhci_wait_for_queued_transfer(xhci_t *, const bulkq_t *);
 
 void xhci_clear_trb(trb_t *, int pcs);
 
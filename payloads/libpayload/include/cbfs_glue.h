@@ -11,6 +11,10 @@
 #define CBFS_ENABLE_HASHING CONFIG(LP_CBFS_VERIFICATION)
 #define CBFS_HASH_HWCRYPTO cbfs_hwcrypto_allowed()
 
+/* libpayload doesn't build mcaches and can look up files in coreboot's without the index. */
+#define CBFS_MCACHE_INDEX 0
+#define CBFS_MCACHE_HASH(name, len) 0
+
 #define ERROR(...) printf("CBFS ERROR: " __VA_ARGS__)
 #define LOG(...) printf("CBFS: " __VA_ARGS__)
 #define DEBUG(...)                                                                             \
@@ -62,6 +62,11 @@ typedef struct storage_dev {
 	ssize_t (*read_blocks512)(struct storage_dev *, lba_t start, size_t count, unsigned char *buf);
 	ssize_t (*write_blocks512)(struct storage_dev *, lba_t start, size_t count, const unsigned char *buf);
 
+	/* Optional asynchronous reads, see storage_read_submit512() and storage_read_poll(). */
+	int (*read_submit512)(struct storage_dev *, lba_t start, size_t count, unsigned char *buf);
+	int (*read_poll)(struct storage_dev *, int *status);
+	size_t max_request_blocks512;
+
 	void (*detach_device)(struct storage_dev *);
 } storage_dev_t;
 
@@ -71,4 +76,8 @@ int storage_attach_device(storage_dev_t *dev);
 storage_poll_t storage_probe(size_t dev_num);
 ssize_t storage_read_blocks512(size_t dev_num, lba_t start, size_t count, unsigned char *buf);
 
+size_t storage_max_request_blocks512(size_t dev_num);
+int storage_read_submit512(size_t dev_num, lba_t start, size_t count, unsigned char *buf);
+int storage_read_poll(size_t dev_num, int *status);
+
 #endif
@@ -260,6 +260,17 @@ struct usbdev_hc {
 	void* (*create_intr_queue) (endpoint_t *ep, int reqsize, int reqcount, int reqtiming);
 	void (*destroy_intr_queue) (endpoint_t *ep, void *queue);
 	u8* (*poll_intr_queue) (void *queue);
+	/* bulk_queue():	Optional. Queue a bulk transfer from or to a DMA
+				coherent buffer without waiting for it. Transfers
+				on one endpoint run in the order they were queued.
+				Returns 0 if the transfer was queued. */
+	int (*bulk_queue) (endpoint_t *ep, int size, u8 *data);
+	/* bulk_wait():		Wait for the oldest transfer queued on ep, return
+				the number of bytes transferred or < 0 on error.
+				An error drops the rest of the queue. */
+	int (*bulk_wait) (endpoint_t *ep);
+	/* bulk_cancel():	Drop all transfers still queued on ep. */
+	void (*bulk_cancel) (endpoint_t *ep);
 	void *instance;
 
 	/* set_address():		Tell the USB device its address (xHCI
@@ -30,7 +30,8 @@
 #define __USBMSC_H
 typedef struct {
 	unsigned int blocksize;
-	unsigned int numblocks;
+	u64 numblocks;
+	unsigned int chunk_bytes; /* Largest transfer per command */
 	endpoint_t *bulk_in;
 	endpoint_t *bulk_out;
 	u8 quirks		: 7;
@@ -49,6 +50,9 @@ enum {
 	   cannot recover from phase errors and won't detach automatically for
 	   unrecoverable errors. Do not use unless you have to. */
 	USB_MSC_QUIRK_NO_RESET	= 1 << 1,
+	/* Wait for the CSW of a command before sending the next CBW. Set by
+	   the driver itself if queueing commands back to back failed. */
+	USB_MSC_QUIRK_NO_PIPELINE = 1 << 2,
 };
 
 /* Possible values for ready field. */
@@ -63,8 +67,8 @@ enum {
 typedef enum { cbw_direction_data_in = 0x80, cbw_direction_data_out = 0
 } cbw_direction;
 
-int readwrite_blocks_512 (usbdev_t *dev, int start, int n, cbw_direction dir, u8 *buf);
-int readwrite_blocks (usbdev_t *dev, int start, int n, cbw_direction dir, u8 *buf);
+int readwrite_blocks_512 (usbdev_t *dev, u64 start, int n, cbw_direction dir, u8 *buf);
+int readwrite_blocks (usbdev_t *dev, u64 start, int n, cbw_direction dir, u8 *buf);
 
 /* Force a device to enumerate as MSC, without checking class/protocol types.
    It must still have a bulk endpoint pair and respond to MSC commands. */
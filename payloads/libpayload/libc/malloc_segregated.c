@@ -0,0 +1,527 @@
+/*
+ *
+ * Copyright (C) 2008 Advanced Micro Devices, Inc.
+ * Copyright (C) 2008-2010 coresystems GmbH
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ * 3. The name of the author may not be used to endorse or promote products
+ *    derived from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE AUTHOR AND CONTRIBUTORS ``AS IS'' AND
+ * ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED.  IN NO EVENT SHALL THE AUTHOR OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS
+ * OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+ * HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ * LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY
+ * OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF
+ * SUCH DAMAGE.
+ */
+
+/*
+ * Segregated-fit malloc() for large heaps. Free blocks are kept in lists by
+ * size class, two levels deep: the first level splits sizes by powers of two,
+ * the second splits each of those into SL_COUNT equal steps. A bitmap per
+ * level tells which lists hold blocks, so malloc() finds a block that is
+ * large enough without looking at any other block.
+ *
+ * Every block starts with a header holding its size and flags. Free blocks
+ * also keep a copy of their size in their last word (boundary tag), and
+ * each header tells whether the block right before it is free. That way
+ * free() merges a block with both neighbours in constant time, too.
+ *
+ * Like the first-fit allocator in malloc.c, we're susceptible to the usual
+ * buffer overrun poisoning.
+ */
+
+#define IN_MALLOC_C
+#include <libpayload.h>
+#include <stdint.h>
+
+typedef u64 hdrtype_t;
+#define HDRSIZE (sizeof(hdrtype_t))
+
+#define SIZE_BITS ((HDRSIZE << 3) - 8)
+#define MAGIC          (((hdrtype_t)0x2a) << (SIZE_BITS + 2))
+#define FLAG_PREV_FREE (((hdrtype_t)0x01) << (SIZE_BITS + 1))
+#define FLAG_FREE      (((hdrtype_t)0x01) << (SIZE_BITS + 0))
+#define MAX_SIZE  ((((hdrtype_t)0x01) << SIZE_BITS) - 1)
+
+/* Block sizes include the header. */
+#define SIZE(_h) ((size_t)((_h) & MAX_SIZE))
+
+#define _HEADER(_s, _f) ((hdrtype_t) (MAGIC | (_f) | ((_s) & MAX_SIZE)))
+
+#define FREE_BLOCK(_s) _HEADER(_s, FLAG_FREE)
+#define USED_BLOCK(_s) _HEADER(_s, 0)
+
+#define IS_FREE(_h) (((_h) & (MAGIC | FLAG_FREE)) == (MAGIC | FLAG_FREE))
+#define HAS_MAGIC(_h) (((_h) & MAGIC) == MAGIC)
+
+struct free_block {
+	hdrtype_t header;
+	struct free_block *next;
+	struct free_block *prev;
+	/* ...followed by the boundary tag in the last word of the block. */
+};
+
+#define MIN_BLOCK ALIGN_UP(sizeof(struct free_block) + HDRSIZE, HDRSIZE)
+/* Keeps all size arithmetic well within the size classes. */
+#define MAX_ALLOC ((size_t)1 << 30)
+
+/* Sizes below SMALL_SIZE get one class per HDRSIZE step. */
+#define SL_LOG2 3
+#define SL_COUNT (1 << SL_LOG2)
+#define FL_SHIFT (SL_LOG2 + 3)
+#define SMALL_SIZE (1 << FL_SHIFT)
+#define FL_COUNT (32 - FL_SHIFT + 1)
+
+struct memory_type {
+	void *start;
+	void *end;
+	int initialized;
+	u32 fl_bitmap;
+	u32 sl_bitmap[FL_COUNT];
+	struct free_block *lists[FL_COUNT][SL_COUNT];
+#if CONFIG(LP_DEBUG_MALLOC)
+	size_t free_bytes;
+	size_t minimal_free;
+	const char *name;
+#endif
+};
+
+extern char _heap, _eheap;	/* Defined in the ldscript. */
+
+static struct memory_type default_type = {
+	.start = (void *)&_heap,
+	.end = (void *)&_eheap,
+#if CONFIG(LP_DEBUG_MALLOC)
+	.name = "HEAP",
+#endif
+};
+static struct memory_type *const heap = &default_type;
+static struct memory_type *dma = &default_type;
+
+void print_malloc_map(void);
+
+void init_dma_memory(void *start, u32 size)
+{
+	if (dma_initialized()) {
+		printf("ERROR: %s called twice!\n", __func__);
+		return;
+	}
+
+	dma = malloc(sizeof(*dma));
+	memset(dma, 0, sizeof(*dma));
+	dma->start = start;
+	dma->end = start + size;
+
+#if CONFIG(LP_DEBUG_MALLOC)
+	dma->name = "DMA";
+
+	printf("Initialized cache-coherent DMA memory at [%p:%p]\n", start, start + size);
+#endif
+}
+
+int dma_initialized(void)
+{
+	return dma != heap;
+}
+
+/* For boards that don't initialize DMA we assume all locations are coherent */
+int dma_coherent(const void *ptr)
+{
+	return !dma_initialized() || (dma->start <= ptr && dma->end > ptr);
+}
+
+static struct memory_type *find_type(const void *ptr)
+{
+	if (ptr >= heap->start && ptr < heap->end)
+		return heap;
+	if (ptr >= dma->start && ptr < dma->end)
+		return dma;
+	return NULL;
+}
+
+static hdrtype_t *next_header(hdrtype_t *header)
+{
+	return (void *)header + SIZE(*header);
+}
+
+static void size_class(size_t size, unsigned int *fl, unsigned int *sl)
+{
+	if (size < SMALL_SIZE) {
+		*fl = 0;
+		*sl = size / (SMALL_SIZE / SL_COUNT);
+		return;
+	}
+
+	const unsigned int msb = log2_64(size);
+	*fl = msb - FL_SHIFT + 1;
+	*sl = (size >> (msb - SL_LOG2)) - SL_COUNT;
+
+	/* Blocks beyond the largest class all share its last list. */
+	if (*fl >= FL_COUNT) {
+		*fl = FL_COUNT - 1;
+		*sl = SL_COUNT - 1;
+	}
+}
+
+static void insert_block(struct memory_type *type, struct free_block *block)
+{
+	unsigned int fl, sl;
+
+	size_class(SIZE(block->header), &fl, &sl);
+	block->prev = NULL;
+	block->next = type->lists[fl][sl];
+	if (block->next)
+		block->next->prev = block;
+	type->lists[fl][sl] = block;
+	type->fl_bitmap |= 1U << fl;
+	type->sl_bitmap[fl] |= 1U << sl;
+
+#if CONFIG(LP_DEBUG_MALLOC)
+	type->free_bytes += SIZE(block->header);
+#endif
+}
+
+static void remove_block(struct memory_type *type, struct free_block *block)
+{
+	unsigned int fl, sl;
+
+	size_class(SIZE(block->header), &fl, &sl);
+	if (block->next)
+		block->next->prev = block->prev;
+	if (block->prev) {
+		block->prev->next = block->next;
+	} else {
+		type->lists[fl][sl] = block->next;
+		if (!block->next) {
+			type->sl_bitmap[fl] &= ~(1U << sl);
+			if (!type->sl_bitmap[fl])
+				type->fl_bitmap &= ~(1U << fl);
+		}
+	}
+
+#if CONFIG(LP_DEBUG_MALLOC)
+	type->free_bytes -= SIZE(block->header);
+	if (type->free_bytes < type->minimal_free)
+		type->minimal_free = type->free_bytes;
+#endif
+}
+
+/* Find a free block of at least 'size' bytes in constant time. */
+static struct free_block *find_block(struct memory_type *type, size_t size)
+{
+	unsigned int fl, sl;
+	u32 sl_map;
+
+	/* Round up to the next class, every block in there is large enough. */
+	if (size >= SMALL_SIZE)
+		size += ((size_t)1 << (log2_64(size) - SL_LOG2)) - 1;
+	size_class(size, &fl, &sl);
+
+	sl_map = type->sl_bitmap[fl] & (~0U << sl);
+	if (!sl_map) {
+		const u32 fl_map = type->fl_bitmap & (~0U << (fl + 1));
+		if (!fl_map)
+			return NULL;
+		fl = __ffs(fl_map);
+		sl_map = type->sl_bitmap[fl];
+	}
+
+	struct free_block *const block = type->lists[fl][__ffs(sl_map)];
+	if (!IS_FREE(block->header)) {
+		printf("memory allocator panic. (%s%s)\n",
+		       !HAS_MAGIC(block->header) ? " no magic " : "",
+		       HAS_MAGIC(block->header) ? " used block in free list " : "");
+		halt();
+	}
+	return block;
+}
+
+/*
+ * Turn 'size' bytes at 'header' into a free block. The block before has
+ * to be in use already.
+ */
+static void make_free(struct memory_type *type, hdrtype_t *header, size_t size)
+{
+	*header = FREE_BLOCK(size);
+	*(hdrtype_t *)((void *)header + size - HDRSIZE) = size;
+	*next_header(header) |= FLAG_PREV_FREE;
+	insert_block(type, (struct free_block *)header);
+}
+
+/* Free a used block and merge it with free neighbours. */
+static void release(struct memory_type *type, hdrtype_t *header)
+{
+	size_t size = SIZE(*header);
+	hdrtype_t *const next = next_header(header);
+
+	if (IS_FREE(*next)) {
+		remove_block(type, (struct free_block *)next);
+		size += SIZE(*next);
+		/* Don't leave a valid header behind in the middle of a block. */
+		*next = 0;
+	}
+
+	if (*header & FLAG_PREV_FREE) {
+		const size_t prev_size = *(header - 1);
+		hdrtype_t *const prev = (void *)header - prev_size;
+
+		remove_block(type, (struct free_block *)prev);
+		*header = 0;
+		header = prev;
+		size += prev_size;
+	}
+
+	make_free(type, header, size);
+}
+
+/* Give the end of a used block back if it's large enough to be a block. */
+static void shrink_block(struct memory_type *type, hdrtype_t *header, size_t size)
+{
+	const size_t old_size = SIZE(*header);
+
+	if (old_size - size < MIN_BLOCK)
+		return;
+
+	*header = USED_BLOCK(size) | (*header & FLAG_PREV_FREE);
+	hdrtype_t *const tail = next_header(header);
+	*tail = USED_BLOCK(old_size - size);
+	release(type, tail);
+}
+
+static void setup_region(struct memory_type *type)
+{
+	hdrtype_t *const first = (void *)ALIGN_UP((uintptr_t)type->start, HDRSIZE);
+	hdrtype_t *const last =
+		(void *)ALIGN_DOWN((uintptr_t)type->end, HDRSIZE) - HDRSIZE;
+
+	type->initialized = 1;
+	if ((void *)last - (void *)first < MIN_BLOCK)
+		return;
+
+	/* The heap ends in a used block of size 0 that is never merged. */
+	*last = USED_BLOCK(0);
+	make_free(type, first, (void *)last - (void *)first);
+
+#if CONFIG(LP_DEBUG_MALLOC)
+	type->minimal_free = type->free_bytes;
+#endif
+}
+
+static size_t block_size(size_t len)
+{
+	return MAX(ALIGN_UP(len, HDRSIZE) + HDRSIZE, MIN_BLOCK);
+}
+
+static void *alloc(size_t len, struct memory_type *type)
+{
+	if (!len || len > MAX_ALLOC)
+		return NULL;
+
+	if (!type->initialized)
+		setup_region(type);
+
+	const size_t size = block_size(len);
+	struct free_block *const block = find_block(type, size);
+	if (!block)
+		return NULL;
+
+	hdrtype_t *const header = &block->header;
+	remove_block(type, block);
+	*header = USED_BLOCK(SIZE(*header)) | (*header & FLAG_PREV_FREE);
+	*next_header(header) &= ~FLAG_PREV_FREE;
+	shrink_block(type, header, size);
+
+	return (void *)header + HDRSIZE;
+}
+
+static void *alloc_aligned(size_t align, size_t size, struct memory_type *type)
+{
+	if (align <= HDRSIZE)
+		return alloc(size, type);
+	if (!size || size > MAX_ALLOC || align > MAX_ALLOC)
+		return NULL;
+
+	/* Leave room for a free block in front of the aligned data. */
+	void *const ptr = alloc(size + align + MIN_BLOCK, type);
+	if (!ptr)
+		return NULL;
+
+	hdrtype_t *header = ptr - HDRSIZE;
+	if (!IS_ALIGNED((uintptr_t)ptr, align)) {
+		void *const aligned = (void *)ALIGN_UP((uintptr_t)ptr + MIN_BLOCK, align);
+		const size_t front = aligned - ptr;
+		hdrtype_t *const aligned_header = aligned - HDRSIZE;
+
+		*aligned_header = USED_BLOCK(SIZE(*header) - front);
+		*header = USED_BLOCK(front) | (*header & FLAG_PREV_FREE);
+		release(type, header);
+		header = aligned_header;
+	}
+	shrink_block(type, header, block_size(size));
+
+	return (void *)header + HDRSIZE;
+}
+
+void free(void *ptr)
+{
+	struct memory_type *type;
+	hdrtype_t *header;
+
+	/* No action occurs on NULL. */
+	if (ptr == NULL)
+		return;
+
+	/* Sanity check. */
+	type = find_type(ptr);
+	if (!type)
+		return;
+
+	header = ptr - HDRSIZE;
+
+	/* Not our header (we're probably poisoned). */
+	if (!HAS_MAGIC(*header))
+		return;
+
+	/* Double free. */
+	if (*header & FLAG_FREE)
+		return;
+
+	release(type, header);
+}
+
+void *malloc(size_t size)
+{
+	return alloc(size, heap);
+}
+
+void *dma_malloc(size_t size)
+{
+	return alloc(size, dma);
+}
+
+void *calloc(size_t nmemb, size_t size)
+{
+	size_t total;
+	void *ptr;
+
+	if (__builtin_mul_overflow(nmemb, size, &total))
+		return NULL;
+
+	ptr = alloc(total, heap);
+	if (ptr)
+		memset(ptr, 0, total);
+
+	return ptr;
+}
+
+void *realloc(void *ptr, size_t size)
+{
+	struct memory_type *type;
+	hdrtype_t *header;
+	size_t old_size;
+	void *ret;
+
+	if (ptr == NULL)
+		return alloc(size, heap);
+
+	type = find_type(ptr);
+	header = ptr - HDRSIZE;
+	if (!type || !HAS_MAGIC(*header) || (*header & FLAG_FREE))
+		return NULL;
+
+	/* Like the first-fit allocator, realloc(ptr, 0) frees ptr. */
+	if (!size) {
+		release(type, header);
+		return NULL;
+	}
+	if (size > MAX_ALLOC)
+		return NULL;
+
+	/* Grow into a free block right behind, if that's enough. */
+	old_size = SIZE(*header);
+	hdrtype_t *const next = next_header(header);
+	if (block_size(size) > old_size && IS_FREE(*next) &&
+	    old_size + SIZE(*next) >= block_size(size)) {
+		remove_block(type, (struct free_block *)next);
+		*header = USED_BLOCK(old_size + SIZE(*next)) | (*header & FLAG_PREV_FREE);
+		*next = 0;
+		*next_header(header) &= ~FLAG_PREV_FREE;
+	}
+
+	if (block_size(size) <= SIZE(*header)) {
+		shrink_block(type, header, block_size(size));
+		return ptr;
+	}
+
+	ret = alloc(size, type);
+	if (ret == NULL)
+		return NULL;
+
+	memcpy(ret, ptr, old_size - HDRSIZE);
+	release(type, header);
+
+	return ret;
+}
+
+void *memalign(size_t align, size_t size)
+{
+	return alloc_aligned(align, size, heap);
+}
+
+void *dma_memalign(size_t align, size_t size)
+{
+	return alloc_aligned(align, size, dma);
+}
+
+/* This is for debugging purposes. */
+#if CONFIG(LP_DEBUG_MALLOC)
+void print_malloc_map(void)
+{
+	struct memory_type *type = heap;
+	hdrtype_t *header;
+
+again:
+	header = (void *)ALIGN_UP((uintptr_t)type->start, HDRSIZE);
+
+	while (type->initialized && (void *)header < type->end) {
+		if (!HAS_MAGIC(*header)) {
+			printf("%s: Poisoned magic - we're toast\n", type->name);
+			break;
+		}
+
+		/* The block of size 0 at the end of the heap. */
+		if (SIZE(*header) == 0)
+			break;
+
+		printf("%s %x: %s (%zx bytes)\n", type->name,
+		       (unsigned int)((void *)header - type->start),
+		       *header & FLAG_FREE ? "FREE" : "USED", SIZE(*header));
+
+		header = next_header(header);
+	}
+
+	if (!type->initialized)
+		printf("%s: Not used yet\n", type->name);
+	printf("%s: %zu bytes free, maximum memory consumption: %zu bytes\n",
+	       type->name, type->free_bytes,
+	       (type->end - type->start) - HDRSIZE - type->minimal_free);
+
+	if (type != dma) {
+		type = dma;
+		goto again;
+	}
+}
+#endif
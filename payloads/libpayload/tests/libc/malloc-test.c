@@ -0,0 +1,319 @@
+/* SPDX-License-Identifier: GPL-2.0-only */
+
+/* Keep the allocator under test apart from the one of the host. */
+#define malloc lp_malloc
+#define free lp_free
+#define calloc lp_calloc
+#define realloc lp_realloc
+#define memalign lp_memalign
+#define dma_malloc lp_dma_malloc
+#define dma_memalign lp_dma_memalign
+
+#if CONFIG(LP_MALLOC_SEGREGATED_FIT)
+#include "../libc/malloc_segregated.c"
+#else
+#include "../libc/malloc.c"
+#endif
+
+#include <libpayload.h>
+#include <tests/test.h>
+
+#define TEST_HEAP_SIZE (64 * MiB)
+
+u8 test_heap[TEST_HEAP_SIZE] __aligned(64);
+/* TEST_SYMBOL() doesn't expand macros in its arguments itself. */
+#define HEAP_SYMBOL(symbol, value) TEST_SYMBOL(symbol, value)
+HEAP_SYMBOL(_heap, test_heap);
+HEAP_SYMBOL(_eheap, test_heap + TEST_HEAP_SIZE);
+
+/* Mocks */
+void halt(void)
+{
+	fail_msg("%s() called", __func__);
+	while (1)
+		;
+}
+
+static u32 rand_state;
+
+static u32 next_rand(void)
+{
+	/* xorshift32, so that every run sees the same trace. */
+	rand_state ^= rand_state << 13;
+	rand_state ^= rand_state >> 17;
+	rand_state ^= rand_state << 5;
+	return rand_state;
+}
+
+static int setup_rand(void **state)
+{
+	rand_state = 0x12345678;
+	return 0;
+}
+
+static void fill(void *ptr, size_t size, u8 seed)
+{
+	u8 *p = ptr;
+
+	for (size_t i = 0; i < size; i++)
+		p[i] = seed + i;
+}
+
+static void check(const void *ptr, size_t size, u8 seed)
+{
+	const u8 *p = ptr;
+
+	for (size_t i = 0; i < size; i++)
+		assert_int_equal((u8)(seed + i), p[i]);
+}
+
+static void test_malloc_reuse(void **state)
+{
+	void *a = malloc(100);
+	void *b;
+
+	assert_non_null(a);
+	assert_true(IS_ALIGNED((uintptr_t)a, HDRSIZE));
+	free(a);
+
+	b = malloc(100);
+	assert_ptr_equal(a, b);
+	free(b);
+
+	assert_null(malloc(0));
+	free(NULL);
+}
+
+static void test_malloc_coalesce(void **state)
+{
+	void *a = malloc(KiB);
+	void *b = malloc(KiB);
+	void *c = malloc(KiB);
+	void *d;
+
+	assert_non_null(a);
+	assert_non_null(b);
+	assert_non_null(c);
+	fill(a, KiB, 1);
+	fill(b, KiB, 2);
+	fill(c, KiB, 3);
+	check(a, KiB, 1);
+	check(b, KiB, 2);
+	check(c, KiB, 3);
+
+	/* Merge with the next block, then with the previous one. */
+	free(b);
+	free(a);
+	free(c);
+
+	d = malloc(3 * KiB);
+	assert_ptr_equal(a, d);
+	free(d);
+}
+
+static void test_realloc_keeps_data(void **state)
+{
+	void *a = malloc(256);
+	void *obstacle;
+
+	fill(a, 256, 7);
+
+	/* Grow in place while the space behind is free. */
+	a = realloc(a, 4 * KiB);
+	assert_non_null(a);
+	check(a, 256, 7);
+	fill(a, 4 * KiB, 8);
+
+	/* Has to move once the space behind is taken. */
+	obstacle = malloc(16);
+	a = realloc(a, 64 * KiB);
+	assert_non_null(a);
+	check(a, 4 * KiB, 8);
+
+	a = realloc(a, 100);
+	assert_non_null(a);
+	check(a, 100, 8);
+
+	free(obstacle);
+	free(a);
+
+	a = realloc(NULL, 32);
+	assert_non_null(a);
+	free(a);
+}
+
+static void test_calloc_zeroes(void **state)
+{
+	u8 *a = malloc(4 * KiB);
+	u8 *b;
+
+	memset(a, 0xff, 4 * KiB);
+	free(a);
+
+	b = calloc(4, KiB);
+	assert_non_null(b);
+	for (size_t i = 0; i < 4 * KiB; i++)
+		assert_int_equal(0, b[i]);
+	free(b);
+}
+
+static void test_malloc_exhaustion(void **state)
+{
+	static void *blocks[TEST_HEAP_SIZE / MiB];
+	size_t count = 0;
+	void *big;
+
+	while (count < ARRAY_SIZE(blocks) && (blocks[count] = malloc(MiB)))
+		count++;
+	assert_true(count > ARRAY_SIZE(blocks) / 2);
+	assert_true(count < ARRAY_SIZE(blocks));
+	assert_null(malloc(MiB));
+
+	while (count)
+		free(blocks[--count]);
+
+	big = malloc(TEST_HEAP_SIZE / 2);
+	assert_non_null(big);
+	free(big);
+}
+
+static void test_memalign(void **state)
+{
+	for (size_t align = 16; align <= 64 * KiB; align <<= 1) {
+		void *a = memalign(align, 100);
+		void *b = memalign(align, align + 1);
+
+		assert_non_null(a);
+		assert_non_null(b);
+		assert_true(IS_ALIGNED((uintptr_t)a, align));
+		assert_true(IS_ALIGNED((uintptr_t)b, align));
+		fill(a, 100, 1);
+		fill(b, align + 1, 2);
+		check(a, 100, 1);
+		free(a);
+		free(b);
+	}
+}
+
+/* Benchmarks with allocation patterns of payloads. Timing isn't checked, just printed. */
+
+static u64 now_usecs(void)
+{
+	struct timeval tv;
+
+	gettimeofday(&tv, NULL);
+	return (u64)tv.tv_sec * 1000000 + tv.tv_usec;
+}
+
+static void report(const char *name, size_t ops, u64 start)
+{
+	const unsigned long long usecs = MAX(now_usecs() - start, 1);
+
+	print_message("%s: %zu operations in %llu us (%llu ops/s)\n", name, ops, usecs,
+		      ops * 1000000ULL / usecs);
+}
+
+/* Network stack: packet buffers freed in arrival order, small control blocks in between. */
+static void bench_packets(void **state)
+{
+	enum { RING = 256, CONTROL = 16, ROUNDS = 100000 };
+	static void *ring[RING];
+	static void *control[CONTROL];
+	const u64 start = now_usecs();
+
+	for (size_t i = 0; i < ROUNDS; i++) {
+		free(ring[i % RING]);
+		ring[i % RING] = malloc(1514 + next_rand() % 64);
+		assert_non_null(ring[i % RING]);
+
+		free(control[i % CONTROL]);
+		control[i % CONTROL] = malloc(32 + next_rand() % 32);
+		assert_non_null(control[i % CONTROL]);
+	}
+
+	for (size_t i = 0; i < RING; i++)
+		free(ring[i]);
+	for (size_t i = 0; i < CONTROL; i++)
+		free(control[i]);
+
+	report(__func__, 4 * ROUNDS, start);
+}
+
+/* Decompressor: an output buffer growing by realloc() and short-lived temporaries. */
+static void bench_decompress(void **state)
+{
+	enum { IMAGES = 32, TEMPS = 64 };
+	static void *temps[TEMPS];
+	const u64 start = now_usecs();
+	size_t ops = 0;
+
+	for (size_t image = 0; image < IMAGES; image++) {
+		void *out = NULL;
+
+		for (size_t size = 4 * KiB; size <= 4 * MiB; size <<= 1) {
+			out = realloc(out, size);
+			assert_non_null(out);
+			ops++;
+
+			for (size_t i = 0; i < TEMPS; i++) {
+				const size_t t = next_rand() % TEMPS;
+
+				free(temps[t]);
+				temps[t] = malloc(16 + next_rand() % 240);
+				assert_non_null(temps[t]);
+				ops += 2;
+			}
+		}
+		free(out);
+		ops++;
+	}
+
+	for (size_t i = 0; i < TEMPS; i++)
+		free(temps[i]);
+
+	report(__func__, ops, start);
+}
+
+/* Many long-lived small objects (e.g. device or filesystem nodes) replaced at random. */
+static void bench_objects(void **state)
+{
+	enum { OBJECTS = 2048, ROUNDS = 50000 };
+	static void *objects[OBJECTS];
+	const u64 start = now_usecs();
+
+	for (size_t i = 0; i < OBJECTS; i++) {
+		objects[i] = malloc(16 + next_rand() % 496);
+		assert_non_null(objects[i]);
+	}
+
+	for (size_t i = 0; i < ROUNDS; i++) {
+		const size_t o = next_rand() % OBJECTS;
+
+		free(objects[o]);
+		objects[o] = malloc(16 + next_rand() % 496);
+		assert_non_null(objects[o]);
+	}
+
+	for (size_t i = 0; i < OBJECTS; i++)
+		free(objects[i]);
+
+	report(__func__, OBJECTS * 2 + ROUNDS * 2, start);
+}
+
+int main(void)
+{
+	const struct CMUnitTest tests[] = {
+		cmocka_unit_test(test_malloc_reuse),
+		cmocka_unit_test(test_malloc_coalesce),
+		cmocka_unit_test(test_realloc_keeps_data),
+		cmocka_unit_test(test_calloc_zeroes),
+		cmocka_unit_test(test_malloc_exhaustion),
+		cmocka_unit_test_setup(bench_packets, setup_rand),
+		cmocka_unit_test_setup(bench_decompress, setup_rand),
+		cmocka_unit_test_setup(bench_objects, setup_rand),
+		/* Last, the first-fit allocator never gives back its alignment bookkeeping. */
+		cmocka_unit_test(test_memalign),
+	};
+
+	return lp_run_group_tests(tests, NULL, NULL);
+}
@@ -1548,12 +1548,6 @@ unsigned long write_acpi_tables(const unsigned long start)
 		acpi_add_table(rsdp, header);
 	}
 
-	/*
-	 * cbfs_unmap() uses mem_pool_free() which works correctly only
-	 * if freeing is done in reverse order than memory allocation.
-	 * This is why unmapping of dsdt_file must be done after
-	 * unmapping slic file.
-	 */
 	cbfs_unmap(slic_file);
 	cbfs_unmap(dsdt_file);
 
@@ -71,7 +71,7 @@ static unsigned long acpi_create_madt_lapics(unsigned long current)
 				continue;
 			apic_ids[num_cpus++] = cpu->path.apic.apic_id;
 		}
-		bubblesort(&apic_ids[sort_start], num_cpus - sort_start, NUM_ASCENDING);
+		sort_int(&apic_ids[sort_start], num_cpus - sort_start, NUM_ASCENDING);
 		sort_start = num_cpus;
 	}
 	for (index = 0; index < num_cpus; index++)
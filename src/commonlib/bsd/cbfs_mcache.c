@@ -21,11 +21,21 @@
  * metadata (entry->file.h.offset). The next mcache_entry begins at the next
  * CBFS_MCACHE_ALIGNMENT boundary after that. The cache is terminated by a special 4-byte
  * mcache_entry that consists only of a magic number (MCACHE_MAGIC_END or MCACHE_MAGIC_FULL).
+ *
+ * If the host application enables CBFS_MCACHE_INDEX and there is enough space left behind the
+ * terminating magic, cbfs_mcache_build() also places a lookup index at the very end of the
+ * mcache area. It consists of an open addressing hash table of uint16_t slots (keyed by
+ * CBFS_MCACHE_HASH() of the file name, with linear probing), followed by a struct mcache_index
+ * footer that ends exactly at the end of the (aligned) mcache size. Each non-zero slot holds
+ * (offset of the mcache_entry from the mcache start) / CBFS_MCACHE_ALIGNMENT + 1. All offsets
+ * are relative, so the index stays valid when the mcache is copied with cbfs_mcache_copy().
+ * Parsers that don't know about the index stop at the terminating magic and never look at it.
  */
 
 #define MCACHE_MAGIC_FILE	0x454c4946	/* 'FILE' */
 #define MCACHE_MAGIC_FULL	0x4c4c5546	/* 'FULL' */
 #define MCACHE_MAGIC_END	0x444e4524	/* '$END' */
+#define MCACHE_MAGIC_INDEX	0x58444e49	/* 'INDX' */
 
 union mcache_entry {
 	union cbfs_mdata file;
@@ -35,6 +45,12 @@ union mcache_entry {
 	};
 };
 
+struct mcache_index {
+	uint16_t slots;		/* Number of hash slots preceding this footer, power of two. */
+	uint16_t terminator;	/* Offset of the terminating magic / CBFS_MCACHE_ALIGNMENT. */
+	uint32_t magic;		/* MCACHE_MAGIC_INDEX */
+};
+
 struct cbfs_mcache_build_args {
 	void *mcache;
 	void *end;
@@ -63,6 +79,82 @@ static enum cb_err build_walker(cbfs_dev_t dev, size_t offset, const union cbfs_
 	return CB_CBFS_NOT_FOUND;
 }
 
+static size_t index_size(const struct mcache_index *index)
+{
+	return index->slots * sizeof(uint16_t) + sizeof(*index);
+}
+
+static const struct mcache_index *find_index(const void *mcache, size_t mcache_size)
+{
+	const size_t size = ALIGN_DOWN(mcache_size, CBFS_MCACHE_ALIGNMENT);
+
+	if (!CBFS_MCACHE_INDEX || size < sizeof(struct mcache_index) + sizeof(uint32_t))
+		return NULL;
+
+	const struct mcache_index *index = mcache + size - sizeof(*index);
+	if (index->magic != MCACHE_MAGIC_INDEX)
+		return NULL;
+
+	/* The footer may be stale, so make sure it is consistent with the actual mcache. */
+	const size_t terminator = index->terminator * CBFS_MCACHE_ALIGNMENT;
+	if (!index->slots || (index->slots & (index->slots - 1)) ||
+	    terminator + sizeof(uint32_t) + index_size(index) > size)
+		return NULL;
+
+	const union mcache_entry *entry = mcache + terminator;
+	if (entry->magic != MCACHE_MAGIC_END && entry->magic != MCACHE_MAGIC_FULL)
+		return NULL;
+
+	return index;
+}
+
+static void build_index(void *mcache, size_t size, void *terminator, int count)
+{
+	const size_t terminator_offset = terminator - mcache;
+	struct mcache_index *index = mcache + size - sizeof(*index);
+	uint16_t slots = 2;
+
+	if (terminator_offset + sizeof(uint32_t) + sizeof(*index) > size)
+		return;		/* No space for a footer, the terminator marks the end. */
+
+	/* Make sure a stale footer from an earlier build can never be picked up. */
+	index->magic = 0;
+
+	while (slots < 2 * count && slots < UINT16_MAX / 2 + 1)
+		slots <<= 1;
+	if (slots < 2 * count ||
+	    terminator_offset / CBFS_MCACHE_ALIGNMENT >= UINT16_MAX ||
+	    terminator_offset + sizeof(uint32_t) + slots * sizeof(uint16_t) + sizeof(*index)
+	    > size) {
+		LOG("no space for mcache index @%p, lookups will be linear\n", mcache);
+		return;
+	}
+
+	uint16_t *table = (uint16_t *)index - slots;
+	memset(table, 0, slots * sizeof(uint16_t));
+
+	for (void *current = mcache; current < terminator;) {
+		const union mcache_entry *entry = current;
+		const uint32_t data_offset = be32toh(entry->file.h.offset);
+		const size_t maxlen = data_offset - offsetof(union cbfs_mdata, h.filename);
+		const size_t namelen = strnlen(entry->file.h.filename, maxlen);
+
+		/* Names that aren't terminated can never match a lookup, don't index them. */
+		if (namelen < maxlen) {
+			uint32_t i = CBFS_MCACHE_HASH(entry->file.h.filename, namelen);
+			while (table[i & (slots - 1)])
+				i++;
+			table[i & (slots - 1)] = (current - mcache) / CBFS_MCACHE_ALIGNMENT + 1;
+		}
+
+		current += ALIGN_UP(data_offset, CBFS_MCACHE_ALIGNMENT);
+	}
+
+	index->slots = slots;
+	index->terminator = terminator_offset / CBFS_MCACHE_ALIGNMENT;
+	index->magic = MCACHE_MAGIC_INDEX;
+}
+
 enum cb_err cbfs_mcache_build(cbfs_dev_t dev, void *mcache, size_t size,
 			      struct vb2_hash *metadata_hash)
 {
@@ -84,11 +176,59 @@ enum cb_err cbfs_mcache_build(cbfs_dev_t dev, void *mcache, size_t size,
 		entry->magic = MCACHE_MAGIC_FULL;
 	}
 
+	if (CBFS_MCACHE_INDEX && (ret == CB_SUCCESS || ret == CB_CBFS_CACHE_FULL))
+		build_index(mcache, ALIGN_DOWN(size, CBFS_MCACHE_ALIGNMENT), entry, args.count);
+
 	LOG("mcache @%p built for %d files, used %#zx of %#zx bytes\n", mcache,
 	    args.count, args.mcache + sizeof(entry->magic) - mcache, size);
 	return ret;
 }
 
+static bool entry_matches(const union mcache_entry *entry, const char *name,
+			  size_t namesize)
+{
+	const uint32_t data_offset = be32toh(entry->file.h.offset);
+
+	return namesize <= data_offset - offsetof(union cbfs_mdata, h.filename) &&
+	       memcmp(name, entry->file.h.filename, namesize) == 0;
+}
+
+static enum cb_err found(const union mcache_entry *entry, const char *name,
+			 union cbfs_mdata *mdata_out, size_t *data_offset_out)
+{
+	const uint32_t data_offset = be32toh(entry->file.h.offset);
+	const uint32_t data_length = be32toh(entry->file.h.len);
+
+	LOG("Found '%s' @%#x size %#x in mcache @%p\n", name, entry->offset, data_length, entry);
+	*data_offset_out = entry->offset + data_offset;
+	memcpy(mdata_out, &entry->file, data_offset);
+	return CB_SUCCESS;
+}
+
+static enum cb_err index_lookup(const void *mcache, const struct mcache_index *index,
+				const char *name, size_t namesize, union cbfs_mdata *mdata_out,
+				size_t *data_offset_out)
+{
+	const uint16_t *table = (const uint16_t *)index - index->slots;
+	uint32_t i = CBFS_MCACHE_HASH(name, namesize - 1);
+
+	/* The table is at most half full, so there is always an empty slot to stop at. */
+	for (; table[i & (index->slots - 1)]; i++) {
+		const uint16_t slot = table[i & (index->slots - 1)];
+		const union mcache_entry *entry = mcache + (slot - 1) * CBFS_MCACHE_ALIGNMENT;
+
+		assert(slot <= index->terminator && entry->magic == MCACHE_MAGIC_FILE);
+		if (entry_matches(entry, name, namesize))
+			return found(entry, name, mdata_out, data_offset_out);
+	}
+
+	const union mcache_entry *terminator =
+		mcache + index->terminator * CBFS_MCACHE_ALIGNMENT;
+	if (terminator->magic == MCACHE_MAGIC_FULL)
+		return CB_CBFS_CACHE_FULL;
+	return CB_CBFS_NOT_FOUND;
+}
+
 enum cb_err cbfs_mcache_lookup(const void *mcache, size_t mcache_size, const char *name,
 			       union cbfs_mdata *mdata_out, size_t *data_offset_out)
 {
@@ -96,6 +236,10 @@ enum cb_err cbfs_mcache_lookup(const void *mcache, size_t mcache_size, const cha
 	const void *end = mcache + mcache_size;
 	const void *current = mcache;
 
+	const struct mcache_index *index = find_index(mcache, mcache_size);
+	if (index)
+		return index_lookup(mcache, index, name, namesize, mdata_out, data_offset_out);
+
 	while (current + sizeof(uint32_t) <= end) {
 		const union mcache_entry *entry = current;
 
@@ -105,25 +249,17 @@ enum cb_err cbfs_mcache_lookup(const void *mcache, size_t mcache_size, const cha
 			return CB_CBFS_CACHE_FULL;
 
 		assert(entry->magic == MCACHE_MAGIC_FILE);
-		const uint32_t data_offset = be32toh(entry->file.h.offset);
-		const uint32_t data_length = be32toh(entry->file.h.len);
-		if (namesize <= data_offset - offsetof(union cbfs_mdata, h.filename) &&
-		    memcmp(name, entry->file.h.filename, namesize) == 0) {
-			LOG("Found '%s' @%#x size %#x in mcache @%p\n",
-			    name, entry->offset, data_length, current);
-			*data_offset_out = entry->offset + data_offset;
-			memcpy(mdata_out, &entry->file, data_offset);
-			return CB_SUCCESS;
-		}
+		if (entry_matches(entry, name, namesize))
+			return found(entry, name, mdata_out, data_offset_out);
 
-		current += ALIGN_UP(data_offset, CBFS_MCACHE_ALIGNMENT);
+		current += ALIGN_UP(be32toh(entry->file.h.offset), CBFS_MCACHE_ALIGNMENT);
 	}
 
 	ERROR("CBFS mcache is not terminated!\n");	/* should never happen */
 	return CB_ERR;
 }
 
-size_t cbfs_mcache_real_size(const void *mcache, size_t mcache_size)
+static size_t entries_size(const void *mcache, size_t mcache_size)
 {
 	const void *end = mcache + mcache_size;
 	const void *current = mcache;
@@ -142,3 +278,21 @@ size_t cbfs_mcache_real_size(const void *mcache, size_t mcache_size)
 
 	return current - mcache;
 }
+
+size_t cbfs_mcache_real_size(const void *mcache, size_t mcache_size)
+{
+	const struct mcache_index *index = find_index(mcache, mcache_size);
+
+	return entries_size(mcache, mcache_size) + (index ? index_size(index) : 0);
+}
+
+void cbfs_mcache_copy(void *dst, const void *mcache, size_t mcache_size)
+{
+	const struct mcache_index *index = find_index(mcache, mcache_size);
+	const size_t size = entries_size(mcache, mcache_size);
+
+	memcpy(dst, mcache, size);
+	if (index)
+		memcpy(dst + size, (const void *)(index + 1) - index_size(index),
+		       index_size(index));
+}
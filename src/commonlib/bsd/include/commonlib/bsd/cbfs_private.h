@@ -30,6 +30,10 @@
  * CBFS_HASH_HWCRYPTO	Should evaluate to true to allow using vboot hardware crypto routines
  *			for hashing, false to forbid. This macro may expand to a function call
  *			to decide this at runtime.
+ * CBFS_MCACHE_INDEX	Should be 1 to build and use a hash index for mcache lookups, 0 otherwise.
+ * CBFS_MCACHE_HASH(name, len)
+ *			Should evaluate to a uint32_t hash over the |len| bytes at |name|. Only
+ *			used when CBFS_MCACHE_INDEX is enabled.
  * ERROR(...)		printf-style macro to print errors.
  * LOG(...)		printf-style macro to print normal-operation log messages.
  * DEBUG(...)		printf-style macro to print detailed debug output.
@@ -121,4 +125,9 @@ enum cb_err cbfs_mcache_lookup(const void *mcache, size_t mcache_size, const cha
 /* Returns the amount of bytes actually used by the CBFS metadata cache in |mcache|. */
 size_t cbfs_mcache_real_size(const void *mcache, size_t mcache_size);
 
+/* Copy the CBFS metadata cache in |mcache| into a new buffer at |dst| that must be exactly
+   cbfs_mcache_real_size() bytes large. Unlike a plain memcpy(), this also carries over the
+   lookup index (which lives at the end of the original mcache area) if there is one. */
+void cbfs_mcache_copy(void *dst, const void *mcache, size_t mcache_size);
+
 #endif	/* _COMMONLIB_BSD_CBFS_PRIVATE_H_ */
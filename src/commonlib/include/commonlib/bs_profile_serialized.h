@@ -0,0 +1,54 @@
+/* SPDX-License-Identifier: GPL-2.0-only */
+
+#ifndef COMMONLIB_BS_PROFILE_SERIALIZED_H
+#define COMMONLIB_BS_PROFILE_SERIALIZED_H
+
+#include <commonlib/bsd/helpers.h>
+#include <stdint.h>
+
+/* Boot state profile (CBMEM_ID_BS_PROFILE), see CONFIG_BOOT_STATE_PROFILER. */
+
+#define BS_PROFILE_NAME_LEN 64
+
+enum bs_profile_kind {
+	BS_PROFILE_STATE = 1,		/* run_state() function of a boot state */
+	BS_PROFILE_CALLBACK = 2,	/* Boot state entry or exit callback */
+	BS_PROFILE_DEV_INIT = 3,	/* Device init() operation */
+	BS_PROFILE_DEV_FINAL = 4,	/* Device final() operation */
+};
+
+/* Part of the boot state an entry was recorded in. */
+enum bs_profile_phase {
+	BS_PROFILE_PHASE_ENTRY = 0,
+	BS_PROFILE_PHASE_RUN = 1,
+	BS_PROFILE_PHASE_EXIT = 2,
+};
+
+/* Names of the boot_state_t values, in the order of the enum in bootstate.h. */
+#define BS_PROFILE_STATE_NAMES						\
+	"BS_PRE_DEVICE", "BS_DEV_INIT_CHIPS", "BS_DEV_ENUMERATE",	\
+	"BS_DEV_RESOURCES", "BS_DEV_ENABLE", "BS_DEV_INIT",		\
+	"BS_POST_DEVICE", "BS_OS_RESUME_CHECK", "BS_OS_RESUME",		\
+	"BS_WRITE_TABLES", "BS_PAYLOAD_LOAD", "BS_PAYLOAD_BOOT"
+
+struct bs_profile_entry {
+	uint8_t kind;		/* enum bs_profile_kind */
+	uint8_t state;		/* boot_state_t */
+	uint8_t phase;		/* enum bs_profile_phase */
+	uint8_t reserved;
+	uint64_t func;		/* Address of the callback or device operation */
+	uint64_t start_us;	/* Monotonic timer, in microseconds */
+	uint64_t duration_us;
+	/* Callback location (with DEBUG_BOOT_STATE) or device path, NUL terminated. */
+	char name[BS_PROFILE_NAME_LEN];
+} __packed;
+
+struct bs_profile_table {
+	uint32_t max_entries;
+	uint32_t num_entries;
+	uint32_t dropped;	/* Entries that didn't fit */
+	uint32_t reserved;
+	struct bs_profile_entry entries[]; /* Variable number of entries */
+} __packed;
+
+#endif
@@ -0,0 +1,44 @@
+/* SPDX-License-Identifier: GPL-2.0-only */
+
+#ifndef COMMONLIB_IMD_SERIALIZED_H
+#define COMMONLIB_IMD_SERIALIZED_H
+
+#include <commonlib/bsd/compiler.h>
+#include <stdint.h>
+
+/*
+ * In-memory layout of an imd, e.g. CBMEM. The root pointer sits just below the upper limit,
+ * which is aligned to IMD_LIMIT_ALIGN. The root and the entries grow downwards from there.
+ */
+
+struct imd_root_pointer {
+	uint32_t magic;
+	/* Relative to upper limit/offset. */
+	int32_t root_offset;
+} __packed;
+
+struct imd_entry {
+	uint32_t magic;
+	/* start is located relative to imd_root */
+	int32_t start_offset;
+	uint32_t size;
+	uint32_t id;
+} __packed;
+
+struct imd_root {
+	uint32_t max_entries;
+	uint32_t num_entries;
+	uint32_t flags;
+	uint32_t entry_align;
+	/* Used for fixing the size of an imd. Relative to the root. */
+	int32_t max_offset;
+	struct imd_entry entries[];
+} __packed;
+
+#define IMD_ROOT_PTR_MAGIC  0xc0389481
+#define IMD_ENTRY_MAGIC  (~0xc0389481)
+#define IMD_LIMIT_ALIGN 4096
+
+#define IMD_FLAG_LOCKED 1
+
+#endif
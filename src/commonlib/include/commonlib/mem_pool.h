@@ -4,6 +4,7 @@
 #define _MEM_POOL_H_
 
 #include <assert.h>
+#include <stdbool.h>
 #include <stddef.h>
 #include <stdint.h>
 
@@ -17,9 +18,16 @@
  * were chosen to optimize for the CBFS cache case which may need two buffers
  * to map a single compressed file, and will free them in reverse order.)
  *
+ * Pools set up with MEM_POOL_INIT_FREE_LIST() or mem_pool_init_free_list()
+ * instead keep a header in front of every allocation and a list of free
+ * chunks, so allocations can be freed in any order. Neighbouring free chunks
+ * are merged again. This costs one 'alignment' aligned header per allocation.
+ *
  * You must ensure the backing buffer is 'alignment' aligned.
  */
 
+struct mem_chunk;
+
 struct mem_pool {
 	uint8_t *buf;
 	size_t size;
@@ -27,6 +35,13 @@ struct mem_pool {
 	uint8_t *last_alloc;
 	uint8_t *second_to_last_alloc;
 	size_t free_offset;
+	/* Free-list pools only: free chunks sorted by address. */
+	bool free_list;
+	struct mem_chunk *free_chunks;
+	/* Statistics, see mem_pool_high_water() and mem_pool_failures(). */
+	size_t used;
+	size_t high_water;
+	size_t failures;
 };
 
 #define MEM_POOL_INIT(buf_, size_, alignment_)	\
@@ -39,11 +54,23 @@ struct mem_pool {
 		.free_offset = 0,		\
 	}
 
+#define MEM_POOL_INIT_FREE_LIST(buf_, size_, alignment_)	\
+	{							\
+		.buf = (buf_),					\
+		.size = (size_),				\
+		.alignment = (alignment_),			\
+		.free_list = true,				\
+	}
+
 static inline void mem_pool_reset(struct mem_pool *mp)
 {
 	mp->last_alloc = NULL;
 	mp->second_to_last_alloc = NULL;
 	mp->free_offset = 0;
+	mp->free_chunks = NULL;
+	mp->used = 0;
+	mp->high_water = 0;
+	mp->failures = 0;
 }
 
 /* Initialize a memory pool. */
@@ -56,9 +83,30 @@ static inline void mem_pool_init(struct mem_pool *mp, void *buf, size_t sz,
 	mp->buf = buf;
 	mp->size = sz;
 	mp->alignment = alignment;
+	mp->free_list = false;
 	mem_pool_reset(mp);
 }
 
+/* Initialize a memory pool whose allocations can be freed in any order. */
+static inline void mem_pool_init_free_list(struct mem_pool *mp, void *buf,
+					   size_t sz, size_t alignment)
+{
+	mem_pool_init(mp, buf, sz, alignment);
+	mp->free_list = true;
+}
+
+/* Most bytes in use at the same time since the pool was set up or reset. */
+static inline size_t mem_pool_high_water(const struct mem_pool *mp)
+{
+	return mp->high_water;
+}
+
+/* Number of allocations that failed because the pool had no space left. */
+static inline size_t mem_pool_failures(const struct mem_pool *mp)
+{
+	return mp->failures;
+}
+
 /* Allocate requested size from the memory pool. NULL returned on error. */
 void *mem_pool_alloc(struct mem_pool *mp, size_t sz);
 
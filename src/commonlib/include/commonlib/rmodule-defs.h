@@ -7,6 +7,21 @@
 
 #define RMODULE_MAGIC 0xf8fe
 #define RMODULE_VERSION_1 1
+#define RMODULE_VERSION_2 2
+
+/*
+ * In RMODULE_VERSION_1 modules the relocation information is a sorted array
+ * of the link addresses that need adjusting, each the size of a pointer of the
+ * module's architecture.
+ *
+ * RMODULE_VERSION_2 modules pack the same sorted addresses as the distances
+ * between consecutive ones, starting from address 0. Each entry is a ULEB128
+ * number holding the distance shifted left by one. If bit 0 (RMODULE_RELOC_RUN)
+ * is set, another ULEB128 number follows with the count of additional
+ * relocations that follow at the same distance, so tables of pointers only
+ * take a few bytes.
+ */
+#define RMODULE_RELOC_RUN 1
 
 /* All fields with '_offset' in the name are byte offsets into the flat blob.
  * The linker and the linker script takes are of assigning the values.  */
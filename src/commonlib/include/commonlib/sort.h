@@ -9,6 +9,14 @@ typedef enum {
 	NUM_DESCENDING
 } sort_order_t;
 
-void bubblesort(int *v, size_t num_entries, sort_order_t order);
+/*
+ * Sort |num| elements of |size| bytes each at |base| in place, in the order given by |cmp|,
+ * which returns <0, 0 or >0 like memcmp(). This is a heapsort: O(n log n) in the worst case,
+ * no recursion and no extra memory, but not stable.
+ */
+void sort(void *base, size_t num, size_t size, int (*cmp)(const void *a, const void *b));
+
+/* Sort an array of ints. */
+void sort_int(int *v, size_t num_entries, sort_order_t order);
 
 #endif /* _COMMONLIB_SORT_H_ */
@@ -19,6 +19,18 @@ struct timestamp_table {
 	struct timestamp_entry entries[]; /* Variable number of entries */
 } __packed;
 
+/*
+ * Entries with these IDs are bookkeeping, not timestamps. Only the last slot of a table is used
+ * for them, but a table that was migrated into another one may leave a TS_TABLE_DROPPED entry
+ * in the middle of it.
+ *
+ * TS_TABLE_CONTINUATION: the table is full and continues in another struct timestamp_table in
+ *			  CBMEM (CBMEM_ID_TIMESTAMP_EXT + n), entry_stamp is its address.
+ * TS_TABLE_DROPPED:	  entry_stamp counts timestamps that were lost for lack of space.
+ */
+#define TS_TABLE_CONTINUATION	0xfffffffe
+#define TS_TABLE_DROPPED	0xffffffff
+
 enum timestamp_id {
 	TS_ROMSTAGE_START = 1,
 	TS_INITRAM_START = 2,
@@ -59,6 +71,14 @@ enum timestamp_id {
 	TS_READ_UCODE_END = 113,
 	TS_ELOG_INIT_START = 114,
 	TS_ELOG_INIT_END = 115,
+	TS_CBFS_PRELOAD_START = 116,
+	TS_CBFS_PRELOAD_END = 117,
+	TS_CBFS_PRELOAD_WAIT_START = 118,
+	TS_CBFS_PRELOAD_WAIT_END = 119,
+	TS_CBFS_PRELOAD_HIT = 120,
+	TS_CBFS_PRELOAD_MISS = 121,
+	TS_PAYLOAD_SEGMENT_START = 122,
+	TS_PAYLOAD_SEGMENT_END = 123,
 
 	/* 500+ reserved for vendorcode extensions (500-600: google/chromeos) */
 	TS_COPYVER_START = 501,
@@ -234,6 +254,16 @@ static const struct timestamp_id_to_name {
 	TS_NAME_DEF(TS_READ_UCODE_END, 0, "finished reading uCode"),
 	TS_NAME_DEF(TS_ELOG_INIT_START, TS_ELOG_INIT_END, "started elog init"),
 	TS_NAME_DEF(TS_ELOG_INIT_END, 0, "finished elog init"),
+	TS_NAME_DEF(TS_CBFS_PRELOAD_START, TS_CBFS_PRELOAD_END, "started CBFS file preload"),
+	TS_NAME_DEF(TS_CBFS_PRELOAD_END, 0, "finished CBFS file preload"),
+	TS_NAME_DEF(TS_CBFS_PRELOAD_WAIT_START, TS_CBFS_PRELOAD_WAIT_END,
+		    "started waiting for CBFS preload"),
+	TS_NAME_DEF(TS_CBFS_PRELOAD_WAIT_END, 0, "finished waiting for CBFS preload"),
+	TS_NAME_DEF(TS_CBFS_PRELOAD_HIT, 0, "CBFS file loaded from preload"),
+	TS_NAME_DEF(TS_CBFS_PRELOAD_MISS, 0, "CBFS file not preloaded in time"),
+	TS_NAME_DEF(TS_PAYLOAD_SEGMENT_START, TS_PAYLOAD_SEGMENT_END,
+		    "started loading payload segment"),
+	TS_NAME_DEF(TS_PAYLOAD_SEGMENT_END, 0, "finished loading payload segment"),
 
 	/* Google related timestamps */
 	TS_NAME_DEF(TS_COPYVER_START, TS_COPYVER_START, "starting to load verstage"),
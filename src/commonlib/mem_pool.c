@@ -3,6 +3,105 @@
 #include <commonlib/helpers.h>
 #include <commonlib/mem_pool.h>
 
+/* Header in front of every chunk of a free-list pool. */
+struct mem_chunk {
+	size_t size;		/* Including the header */
+	struct mem_chunk *next;	/* Next free chunk, unused while allocated */
+};
+
+static size_t chunk_header_size(const struct mem_pool *mp)
+{
+	return ALIGN_UP(sizeof(struct mem_chunk), mp->alignment);
+}
+
+static void account_alloc(struct mem_pool *mp, size_t sz)
+{
+	mp->used += sz;
+	if (mp->used > mp->high_water)
+		mp->high_water = mp->used;
+}
+
+static void *free_list_alloc(struct mem_pool *mp, size_t sz)
+{
+	const size_t hdr = chunk_header_size(mp);
+	struct mem_chunk **link, **best = NULL;
+	struct mem_chunk *chunk;
+
+	/* Nothing allocated and nothing free means the pool is still untouched. */
+	if (!mp->free_chunks && !mp->used && mp->size >= hdr + mp->alignment) {
+		mp->free_chunks = (struct mem_chunk *)mp->buf;
+		mp->free_chunks->size = ALIGN_DOWN(mp->size, mp->alignment);
+		mp->free_chunks->next = NULL;
+	}
+
+	if (sz > mp->size)
+		return NULL;
+	sz = ALIGN_UP(sz, mp->alignment) + hdr;
+
+	/* Best fit, to keep large chunks around for large files. */
+	for (link = &mp->free_chunks; *link; link = &(*link)->next) {
+		if ((*link)->size >= sz && (!best || (*link)->size < (*best)->size))
+			best = link;
+	}
+	if (!best)
+		return NULL;
+
+	chunk = *best;
+	if (chunk->size - sz >= hdr + mp->alignment) {
+		struct mem_chunk *rest = (struct mem_chunk *)((uint8_t *)chunk + sz);
+
+		rest->size = chunk->size - sz;
+		rest->next = chunk->next;
+		*best = rest;
+		chunk->size = sz;
+	} else {
+		*best = chunk->next;
+	}
+
+	account_alloc(mp, chunk->size);
+
+	return (uint8_t *)chunk + hdr;
+}
+
+static void free_list_free(struct mem_pool *mp, void *p)
+{
+	const size_t hdr = chunk_header_size(mp);
+	struct mem_chunk *chunk, *prev = NULL, *next;
+	struct mem_chunk **link;
+
+	/* Ignore addresses that can't be allocations from this pool. */
+	if (!mp->used || (uint8_t *)p < mp->buf + hdr || (uint8_t *)p >= mp->buf + mp->size)
+		return;
+
+	chunk = (struct mem_chunk *)((uint8_t *)p - hdr);
+	if (((uint8_t *)chunk - mp->buf) % mp->alignment || chunk->size < hdr ||
+	    chunk->size > mp->size - ((uint8_t *)chunk - mp->buf))
+		return;
+
+	for (link = &mp->free_chunks; *link && *link < chunk; link = &(*link)->next)
+		prev = *link;
+	next = *link;
+
+	/* Not the start of an allocated chunk, e.g. freed twice. */
+	if (next == chunk || (prev && (uint8_t *)prev + prev->size > (uint8_t *)chunk))
+		return;
+
+	mp->used -= chunk->size;
+
+	if (next && (uint8_t *)chunk + chunk->size == (uint8_t *)next) {
+		chunk->size += next->size;
+		next = next->next;
+	}
+	chunk->next = next;
+
+	if (prev && (uint8_t *)prev + prev->size == (uint8_t *)chunk) {
+		prev->size += chunk->size;
+		prev->next = chunk->next;
+	} else {
+		*link = chunk;
+	}
+}
+
 void *mem_pool_alloc(struct mem_pool *mp, size_t sz)
 {
 	void *p;
@@ -10,12 +109,21 @@ void *mem_pool_alloc(struct mem_pool *mp, size_t sz)
 	if (mp->alignment == 0)
 		return NULL;
 
+	if (mp->free_list) {
+		p = free_list_alloc(mp, sz);
+		if (!p)
+			mp->failures++;
+		return p;
+	}
+
 	/* We assume that mp->buf started mp->alignment aligned */
 	sz = ALIGN_UP(sz, mp->alignment);
 
 	/* Determine if any space available. */
-	if ((mp->size - mp->free_offset) < sz)
+	if ((mp->size - mp->free_offset) < sz) {
+		mp->failures++;
 		return NULL;
+	}
 
 	p = &mp->buf[mp->free_offset];
 
@@ -23,16 +131,27 @@ void *mem_pool_alloc(struct mem_pool *mp, size_t sz)
 	mp->second_to_last_alloc = mp->last_alloc;
 	mp->last_alloc = p;
 
+	account_alloc(mp, sz);
+
 	return p;
 }
 
 void mem_pool_free(struct mem_pool *mp, void *p)
 {
+	if (p == NULL)
+		return;
+
+	if (mp->free_list) {
+		free_list_free(mp, p);
+		return;
+	}
+
 	/* Determine if p was the most recent allocation. */
-	if (p == NULL || mp->last_alloc != p)
+	if (mp->last_alloc != p)
 		return;
 
 	mp->free_offset = mp->last_alloc - mp->buf;
+	mp->used = mp->free_offset;
 	mp->last_alloc = mp->second_to_last_alloc;
 	/* No way to track allocation before this one. */
 	mp->second_to_last_alloc = NULL;
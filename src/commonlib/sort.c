@@ -2,39 +2,82 @@
 
 #include <commonlib/helpers.h>
 #include <commonlib/sort.h>
+#include <stdint.h>
 
-/* Implement a simple Bubble sort algorithm. Reduce the needed number of
-   iterations by taking care of already sorted entries in the list. */
-void bubblesort(int *v, size_t num_entries, sort_order_t order)
+static void swap_elements(void *a, void *b, size_t size)
 {
-	size_t i, j;
-	int swapped;
+	/* Most callers sort pointers or integers, swap those in one go. */
+	if (size == sizeof(uint32_t) && IS_ALIGNED((uintptr_t)a | (uintptr_t)b, size)) {
+		SWAP(*(uint32_t *)a, *(uint32_t *)b);
+	} else if (size == sizeof(uint64_t) &&
+		   IS_ALIGNED((uintptr_t)a | (uintptr_t)b, size)) {
+		SWAP(*(uint64_t *)a, *(uint64_t *)b);
+	} else {
+		uint8_t *x = a, *y = b;
+
+		while (size--)
+			SWAP(*x++, *y++);
+	}
+}
+
+/* Move the element at |root| down until the subtree below it is a max-heap again. */
+static void sift_down(uint8_t *base, size_t root, size_t num, size_t size,
+		      int (*cmp)(const void *a, const void *b))
+{
+	size_t child;
+
+	while ((child = 2 * root + 1) < num) {
+		if (child + 1 < num &&
+		    cmp(base + child * size, base + (child + 1) * size) < 0)
+			child++;
+		if (cmp(base + root * size, base + child * size) >= 0)
+			return;
+		swap_elements(base + root * size, base + child * size, size);
+		root = child;
+	}
+}
+
+void sort(void *base, size_t num, size_t size, int (*cmp)(const void *a, const void *b))
+{
+	uint8_t *const p = base;
+	size_t i;
 
 	/* Make sure there are at least two entries to sort. */
-	if (num_entries < 2)
+	if (num < 2 || !size)
 		return;
 
-	for (j = 0; j < num_entries - 1; j++) {
-		swapped = 0;
-		for (i = 0; i < num_entries - j - 1; i++) {
-			switch (order) {
-			case NUM_ASCENDING:
-				if (v[i] > v[i + 1]) {
-					SWAP(v[i], v[i + 1]);
-					swapped = 1;
-				}
-				break;
-			case NUM_DESCENDING:
-				if (v[i] < v[i + 1]) {
-					SWAP(v[i], v[i + 1]);
-					swapped = 1;
-				}
-				break;
-			default:
-				return;
-			}
-		}
-		if (!swapped)
-			break;
+	for (i = num / 2; i > 0; i--)
+		sift_down(p, i - 1, num, size, cmp);
+
+	/* Move the largest element to the end and repair the heap in front of it. */
+	for (i = num - 1; i > 0; i--) {
+		swap_elements(p, p + i * size, size);
+		sift_down(p, 0, i, size, cmp);
+	}
+}
+
+static int cmp_int_ascending(const void *a, const void *b)
+{
+	const int x = *(const int *)a, y = *(const int *)b;
+
+	return (x > y) - (x < y);
+}
+
+static int cmp_int_descending(const void *a, const void *b)
+{
+	return cmp_int_ascending(b, a);
+}
+
+void sort_int(int *v, size_t num_entries, sort_order_t order)
+{
+	switch (order) {
+	case NUM_ASCENDING:
+		sort(v, num_entries, sizeof(*v), cmp_int_ascending);
+		break;
+	case NUM_DESCENDING:
+		sort(v, num_entries, sizeof(*v), cmp_int_descending);
+		break;
+	default:
+		return;
 	}
 }
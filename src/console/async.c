@@ -0,0 +1,120 @@
+/* SPDX-License-Identifier: GPL-2.0-only */
+
+#include <bootstate.h>
+#include <console/async.h>
+#include <console/console.h>
+#include <console/streams.h>
+#include <smp/spinlock.h>
+#include <thread.h>
+#include <types.h>
+
+/*
+ * While asynchronous output is active, bytes for the interactive consoles are only appended to
+ * a queue. A cooperative thread writes them out whenever the main thread yields, e.g. in
+ * udelay(). The stored consoles (CBMEM console) are still written synchronously, so the log
+ * is complete even if the queued output never makes it out.
+ *
+ * Once the queue fills up to the high-water mark, every new byte first writes out the oldest
+ * one, so output becomes synchronous again without getting reordered.
+ */
+
+#define QUEUE_SIZE CONFIG_CONSOLE_ASYNC_BUFFER_SIZE
+#define HIGH_WATER CONFIG_CONSOLE_ASYNC_HIGH_WATER
+/* Bytes the drain thread writes before the main thread gets a chance to run again. */
+#define DRAIN_CHUNK 8
+
+_Static_assert(HIGH_WATER < QUEUE_SIZE, "High-water mark must be below the queue size");
+
+static struct {
+	uint8_t data[QUEUE_SIZE];
+	size_t head;
+	size_t tail;
+	bool active;
+} queue;
+
+/* Serialises the drain thread against writers on other CPUs. */
+DECLARE_SPIN_LOCK(queue_lock)
+
+static struct thread_handle drain_handle;
+
+static size_t queue_used(void)
+{
+	return (queue.head + QUEUE_SIZE - queue.tail) % QUEUE_SIZE;
+}
+
+/* Must be called with queue_lock held. */
+static void drain_bytes(size_t count)
+{
+	/* Console drivers may udelay(). Don't let that switch to a thread that could print. */
+	thread_coop_disable();
+	while (count-- && queue.tail != queue.head) {
+		console_interactive_tx_byte_sync(queue.data[queue.tail]);
+		queue.tail = (queue.tail + 1) % QUEUE_SIZE;
+	}
+	thread_coop_enable();
+}
+
+bool console_async_tx_byte(unsigned char byte)
+{
+	if (!queue.active)
+		return false;
+
+	spin_lock(&queue_lock);
+
+	/* Output may have been flushed and stopped in the meantime. */
+	if (!queue.active) {
+		spin_unlock(&queue_lock);
+		return false;
+	}
+
+	if (queue_used() >= HIGH_WATER)
+		drain_bytes(1);
+	queue.data[queue.head] = byte;
+	queue.head = (queue.head + 1) % QUEUE_SIZE;
+
+	spin_unlock(&queue_lock);
+	return true;
+}
+
+void console_async_flush(void)
+{
+	if (!queue.active)
+		return;
+
+	spin_lock(&queue_lock);
+	queue.active = false;
+	drain_bytes(QUEUE_SIZE);
+	spin_unlock(&queue_lock);
+}
+
+static enum cb_err drain_thread(void *unused)
+{
+	while (queue.active) {
+		spin_lock(&queue_lock);
+		drain_bytes(DRAIN_CHUNK);
+		spin_unlock(&queue_lock);
+		thread_yield();
+	}
+
+	return CB_SUCCESS;
+}
+
+static void console_async_start(void *unused)
+{
+	queue.active = true;
+	if (thread_run(&drain_handle, drain_thread, NULL) < 0) {
+		printk(BIOS_WARNING, "Could not start console drain thread\n");
+		console_async_flush();
+	}
+}
+
+static void console_async_stop(void *unused)
+{
+	console_async_flush();
+	if (drain_handle.state != THREAD_UNINITIALIZED)
+		thread_join(&drain_handle);
+}
+
+BOOT_STATE_INIT_ENTRY(BS_PRE_DEVICE, BS_ON_ENTRY, console_async_start, NULL);
+BOOT_STATE_INIT_ENTRY(BS_OS_RESUME, BS_ON_ENTRY, console_async_stop, NULL);
+BOOT_STATE_INIT_ENTRY(BS_PAYLOAD_BOOT, BS_ON_ENTRY, console_async_stop, NULL);
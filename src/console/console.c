@@ -1,5 +1,6 @@
 /* SPDX-License-Identifier: GPL-2.0-only */
 
+#include <console/async.h>
 #include <console/cbmem_console.h>
 #include <console/flash.h>
 #include <console/i2c_smbus.h>
@@ -32,7 +33,7 @@ void console_hw_init(void)
 	__simnow_console_init();
 }
 
-void console_interactive_tx_byte(unsigned char byte, void *data_unused)
+void console_interactive_tx_byte_sync(unsigned char byte)
 {
 	if (byte == '\n') {
 		/* Some consoles want newline conversion to keep terminals happy. */
@@ -52,6 +53,12 @@ void console_interactive_tx_byte(unsigned char byte, void *data_unused)
 	__simnow_console_tx_byte(byte);
 }
 
+void console_interactive_tx_byte(unsigned char byte, void *data_unused)
+{
+	if (!console_async_tx_byte(byte))
+		console_interactive_tx_byte_sync(byte);
+}
+
 void console_stored_tx_byte(unsigned char byte, void *data_unused)
 {
 	__flashconsole_tx_byte(byte);
@@ -1,6 +1,8 @@
 /* SPDX-License-Identifier: GPL-2.0-only */
 
+#include <console/async.h>
 #include <console/console.h>
+#include <console/percpu.h>
 #include <halt.h>
 #include <stdarg.h>
 
@@ -23,6 +25,8 @@ void __noreturn die(const char *fmt, ...)
 	vprintk(BIOS_EMERG, fmt, args);
 	va_end(args);
 
+	console_percpu_drain();
+	console_async_flush();
 	die_notify();
 	halt();
 }
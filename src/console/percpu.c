@@ -0,0 +1,205 @@
+/* SPDX-License-Identifier: GPL-2.0-only */
+
+#include <arch/cpu.h>
+#include <bootstate.h>
+#include <commonlib/helpers.h>
+#include <console/console.h>
+#include <console/percpu.h>
+#include <cpu/x86/tsc.h>
+#include <smp/node.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <types.h>
+
+/*
+ * Each AP gets a ring buffer that only it writes records to and only the BSP reads them from,
+ * so no lock is needed: the AP only ever advances |head| and the BSP only ever advances
+ * |tail|. x86 doesn't reorder stores against other stores or loads against other loads, so
+ * compiler barriers are enough to publish a record after its contents.
+ *
+ * Every record carries a TSC value, which lets the BSP merge the records of all CPUs into
+ * one stream in the order they were logged.
+ *
+ * The buffers come from the heap once the number of CPUs is known, so that boards with a
+ * large CONFIG_MAX_CPUS don't pay for CPUs they don't have in .bss.
+ */
+
+#define barrier() __asm__ __volatile__("" : : : "memory")
+
+#define BUFFER_SIZE CONFIG_CONSOLE_PERCPU_BUFFER_SIZE
+/* Longer messages are truncated. This lives on the AP stack, so keep it small. */
+#define RECORD_TEXT_MAX 160
+
+struct percpu_record {
+	uint64_t timestamp;
+	uint16_t len;		/* Length of the text following the record header. */
+	uint8_t level;
+};
+
+struct percpu_log {
+	volatile uint32_t head;		/* Written by the AP only. */
+	volatile uint32_t tail;		/* Written by the BSP only. */
+	volatile uint32_t dropped;	/* Written by the AP only. */
+	uint32_t dropped_reported;	/* Used by the BSP only. */
+	uint8_t data[BUFFER_SIZE];
+};
+
+static struct percpu_log *logs;
+static size_t num_logs;
+static bool enabled;
+
+static uint32_t ring_offset(uint32_t pos, size_t size)
+{
+	return (pos + size) % BUFFER_SIZE;
+}
+
+static size_t ring_used(uint32_t head, uint32_t tail)
+{
+	return (head + BUFFER_SIZE - tail) % BUFFER_SIZE;
+}
+
+static void ring_write(struct percpu_log *log, uint32_t pos, const void *src, size_t size)
+{
+	const size_t first = MIN(size, BUFFER_SIZE - pos);
+
+	memcpy(&log->data[pos], src, first);
+	memcpy(&log->data[0], src + first, size - first);
+}
+
+static void ring_read(const struct percpu_log *log, uint32_t pos, void *dst, size_t size)
+{
+	const size_t first = MIN(size, BUFFER_SIZE - pos);
+
+	memcpy(dst, &log->data[pos], first);
+	memcpy(dst + first, &log->data[0], size - first);
+}
+
+void console_percpu_enable(size_t num_cpus)
+{
+	if (enabled)
+		return;
+
+	logs = calloc(num_cpus, sizeof(*logs));
+	if (!logs) {
+		printk(BIOS_WARNING, "No memory for per-CPU console buffers\n");
+		return;
+	}
+	num_logs = num_cpus;
+
+	/* The APs must not see |enabled| before the buffers. */
+	barrier();
+	enabled = true;
+}
+
+bool console_percpu_enabled(void)
+{
+	return enabled;
+}
+
+int console_percpu_vprintk(int msg_level, const char *fmt, va_list args)
+{
+	const unsigned long index = cpu_index();
+	struct percpu_record rec;
+	char text[RECORD_TEXT_MAX];
+	struct percpu_log *log;
+	uint32_t head;
+	int i;
+
+	if (index >= num_logs)
+		return 0;
+	log = &logs[index];
+
+	rec.timestamp = rdtscll();
+	rec.level = msg_level;
+	i = vsnprintf(text, sizeof(text), fmt, args);
+	rec.len = MIN(i, (int)sizeof(text) - 1);
+
+	/* One byte always stays free to tell a full buffer from an empty one. */
+	head = log->head;
+	if (BUFFER_SIZE - 1 - ring_used(head, log->tail) < sizeof(rec) + rec.len) {
+		log->dropped++;
+		return i;
+	}
+
+	ring_write(log, head, &rec, sizeof(rec));
+	ring_write(log, ring_offset(head, sizeof(rec)), text, rec.len);
+
+	/* Only make the record visible to the BSP once it is complete. */
+	barrier();
+	log->head = ring_offset(head, sizeof(rec) + rec.len);
+
+	return i;
+}
+
+static void report_dropped(struct percpu_log *log)
+{
+	const uint32_t dropped = log->dropped;
+
+	if (dropped == log->dropped_reported)
+		return;
+
+	printk(BIOS_WARNING, "CPU %zu: %u console messages dropped\n",
+	       (size_t)(log - logs), dropped - log->dropped_reported);
+	log->dropped_reported = dropped;
+}
+
+void console_percpu_drain(void)
+{
+	/* The drained messages go through printk(), which drains again. */
+	static bool draining;
+	struct percpu_record rec, next_rec;
+	struct percpu_log *next;
+	char text[RECORD_TEXT_MAX];
+	size_t i;
+
+	if (!enabled || draining || !boot_cpu())
+		return;
+	draining = true;
+
+	do {
+		next = NULL;
+
+		/* Find the oldest record that is waiting in any of the buffers. */
+		for (i = 0; i < num_logs; i++) {
+			struct percpu_log *log = &logs[i];
+
+			if (log->tail == log->head)
+				continue;
+			/* Don't read the record before its head update was seen. */
+			barrier();
+
+			ring_read(log, log->tail, &rec, sizeof(rec));
+			if (!next || rec.timestamp < next_rec.timestamp) {
+				next = log;
+				next_rec = rec;
+			}
+		}
+
+		if (next) {
+			const uint32_t text_pos = ring_offset(next->tail, sizeof(next_rec));
+
+			ring_read(next, text_pos, text, next_rec.len);
+			/* Hand the space back before printing, the AP may need it. */
+			barrier();
+			next->tail = ring_offset(text_pos, next_rec.len);
+
+			printk(next_rec.level, "%.*s", next_rec.len, text);
+		}
+	} while (next);
+
+	for (i = 0; i < num_logs; i++)
+		report_dropped(&logs[i]);
+
+	draining = false;
+}
+
+/* Nothing may be left behind in the buffers when coreboot hands over. */
+static void console_percpu_stop(void *unused)
+{
+	console_percpu_drain();
+	enabled = false;
+}
+
+BOOT_STATE_INIT_ENTRY(BS_OS_RESUME, BS_ON_ENTRY, console_percpu_stop, NULL);
+BOOT_STATE_INIT_ENTRY(BS_PAYLOAD_BOOT, BS_ON_ENTRY, console_percpu_stop, NULL);
@@ -6,6 +6,7 @@
 
 #include <console/cbmem_console.h>
 #include <console/console.h>
+#include <console/percpu.h>
 #include <console/streams.h>
 #include <console/vtxprintf.h>
 #include <smp/spinlock.h>
@@ -138,6 +139,13 @@ int vprintk(int msg_level, const char *fmt, va_list args)
 	if (state.speed < CONSOLE_LOG_FAST)
 		return 0;
 
+	if (console_percpu_enabled()) {
+		if (!boot_cpu())
+			return console_percpu_vprintk(msg_level, fmt, args);
+		/* Keep the BSP's own messages behind what the APs logged before. */
+		console_percpu_drain();
+	}
+
 	spin_lock(&console_lock);
 
 	console_time_run();
@@ -1,6 +1,7 @@
 /* SPDX-License-Identifier: GPL-2.0-only */
 
 #include <console/console.h>
+#include <console/percpu.h>
 #include <string.h>
 #include <rmodule.h>
 #include <commonlib/helpers.h>
@@ -143,6 +144,7 @@ static enum cb_err wait_for_aps(atomic_t *val, int target, int total_delay,
 {
 	int delayed = 0;
 	while (atomic_read(val) != target) {
+		console_percpu_drain();
 		udelay(delay_step);
 		delayed += delay_step;
 		if (delayed >= total_delay) {
@@ -529,6 +531,10 @@ static enum cb_err bsp_do_flight_plan(struct mp_params *mp_params)
 					 timeout_us, step_us) != CB_SUCCESS) {
 				printk(BIOS_ERR, "MP record %d timeout.\n", i);
 				ret = CB_ERR;
+			} else if (i == 0) {
+				/* All APs have set up their cpu_info by now, so they can
+				   log to their own console buffers. */
+				console_percpu_enable(mp_params->num_cpus);
 			}
 		}
 
@@ -932,6 +938,8 @@ static enum cb_err run_ap_work(struct mp_callback *val, long expire_us, bool wai
 			if (!wait_ap_finish || (cpus_finish == global_num_aps))
 				return CB_SUCCESS;
 
+		console_percpu_drain();
+
 	} while (expire_us <= 0 || !stopwatch_expired(&sw));
 
 	printk(BIOS_CRIT, "CRITICAL ERROR: AP call expired. %d/%d CPUs accepted.\n",
@@ -4,6 +4,7 @@
  * Originally based on the Linux kernel (arch/i386/kernel/pci-pc.c).
  */
 
+#include <bootstate.h>
 #include <console/console.h>
 #include <device/device.h>
 #include <device/pci_def.h>
@@ -527,6 +528,8 @@ static void init_dev(struct device *dev)
 		stopwatch_init(&sw);
 		dev->initialized = 1;
 		dev->ops->init(dev);
+		bs_profile_record(BS_PROFILE_DEV_INIT, &sw.start, dev->ops->init,
+				  dev_path(dev));
 
 		init_time = stopwatch_duration_msecs(&sw);
 		printk(BIOS_DEBUG, "%s init finished in %ld msecs\n", dev_path(dev),
@@ -590,8 +593,13 @@ static void final_dev(struct device *dev)
 		return;
 
 	if (dev->ops && dev->ops->final) {
+		struct mono_time start;
+
 		printk(BIOS_DEBUG, "%s final\n", dev_path(dev));
+		if (CONFIG(BOOT_STATE_PROFILER))
+			timer_monotonic_get(&start);
 		dev->ops->final(dev);
+		bs_profile_record(BS_PROFILE_DEV_FINAL, &start, dev->ops->final, dev_path(dev));
 	}
 }
 
@@ -3,6 +3,7 @@
 #define BOOTSTATE_H
 
 #include <assert.h>
+#include <commonlib/bs_profile_serialized.h>
 #include <string.h>
 #include <stddef.h>
 /* Only declare main() when in ramstage. */
@@ -194,6 +195,22 @@ struct boot_state_init_entry {
 	_Static_assert(!(state_ == BS_OS_RESUME && when_ == BS_ON_EXIT), \
 		       "Invalid bootstate hook");
 
+/*
+ * Boot state profiler, see CONFIG_BOOT_STATE_PROFILER. bs_profile_phase() tells the profiler
+ * which part of which state the boot state machine is in, bs_profile_record() adds an entry of
+ * |kind| (enum bs_profile_kind) for |func| that ran from |start| until now. |name| may be NULL.
+ */
+struct mono_time;
+#if CONFIG(BOOT_STATE_PROFILER) && ENV_RAMSTAGE
+void bs_profile_phase(boot_state_t state, uint8_t phase);
+void bs_profile_record(uint8_t kind, const struct mono_time *start, const void *func,
+		       const char *name);
+#else
+static inline void bs_profile_phase(boot_state_t state, uint8_t phase) {}
+static inline void bs_profile_record(uint8_t kind, const struct mono_time *start,
+				     const void *func, const char *name) {}
+#endif
+
 /* Hook per arch when coreboot is exiting to payload or ACPI OS resume. It's
  * the very last thing done before the transition. */
 void arch_bootstate_coreboot_exit(void);
@@ -127,6 +127,14 @@ static inline void *cbfs_unverified_area_cbmem_alloc(const char *area, const cha
  */
 void cbfs_preload(const char *name);
 
+/*
+ * Same as cbfs_preload() for several files at once. The files are read one after another in
+ * the order they are stored in flash, independent of the order of |names|, and only so far
+ * ahead of their consumers as CONFIG_CBFS_PRELOAD_MAX_INFLIGHT allows. Loading a file whose
+ * preload hasn't started yet just reads it directly instead.
+ */
+void cbfs_preload_batch(const char *const names[], size_t count);
+
 /* Removes a previously allocated CBFS mapping. Should try to unmap mappings in strict LIFO
    order where possible, since mapping backends often don't support more complicated cases. */
 void cbfs_unmap(void *mapping);
@@ -6,6 +6,7 @@
 #include <commonlib/region.h>
 #include <console/console.h>
 #include <security/vboot/misc.h>
+#include <xxhash.h>
 
 /*
  * This flag prevents linking hashing functions into stages where they're not required. We don't
@@ -26,6 +27,9 @@
 				  CONFIG(VBOOT_RETURN_FROM_VERSTAGE))))))
 #define CBFS_HASH_HWCRYPTO vboot_hwcrypto_allowed()
 
+#define CBFS_MCACHE_INDEX CONFIG(CBFS_MCACHE_INDEX)
+#define CBFS_MCACHE_HASH(name, len) xxh32(name, len, 0)
+
 #define ERROR(...) printk(BIOS_ERR, "CBFS ERROR: " __VA_ARGS__)
 #define LOG(...) printk(BIOS_INFO, "CBFS: " __VA_ARGS__)
 #define DEBUG(...) do { \
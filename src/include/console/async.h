@@ -0,0 +1,19 @@
+/* SPDX-License-Identifier: GPL-2.0-only */
+
+#ifndef _CONSOLE_ASYNC_H_
+#define _CONSOLE_ASYNC_H_
+
+#include <stdbool.h>
+
+#if CONFIG(CONSOLE_ASYNC) && ENV_RAMSTAGE
+/* Queue a byte for the interactive consoles. Returns false if it has to be sent right away
+   because asynchronous output isn't active. */
+bool console_async_tx_byte(unsigned char byte);
+/* Write out everything that is queued and send all further output synchronously. */
+void console_async_flush(void);
+#else
+static inline bool console_async_tx_byte(unsigned char byte) { return false; }
+static inline void console_async_flush(void) {}
+#endif
+
+#endif /* _CONSOLE_ASYNC_H_ */
@@ -0,0 +1,30 @@
+/* SPDX-License-Identifier: GPL-2.0-only */
+
+#ifndef _CONSOLE_PERCPU_H_
+#define _CONSOLE_PERCPU_H_
+
+#include <stdarg.h>
+#include <stdbool.h>
+#include <stddef.h>
+
+#if CONFIG(CONSOLE_PERCPU_BUFFERS) && ENV_RAMSTAGE
+/* Allocate a buffer for each of num_cpus CPUs and start buffering AP console output. Must
+   only be called once cpu_index() works on all APs. */
+void console_percpu_enable(size_t num_cpus);
+bool console_percpu_enabled(void);
+/* Append a message to the calling AP's buffer. */
+int console_percpu_vprintk(int msg_level, const char *fmt, va_list args);
+/* Write all buffered AP messages to the consoles in time stamp order. Does nothing on
+   APs. */
+void console_percpu_drain(void);
+#else
+static inline void console_percpu_enable(size_t num_cpus) {}
+static inline bool console_percpu_enabled(void) { return false; }
+static inline int console_percpu_vprintk(int msg_level, const char *fmt, va_list args)
+{
+	return 0;
+}
+static inline void console_percpu_drain(void) {}
+#endif
+
+#endif /* _CONSOLE_PERCPU_H_ */
@@ -12,6 +12,8 @@ void console_tx_flush(void);
 
 /* Interactive consoles that are usually displayed in real time on a terminal. */
 void console_interactive_tx_byte(unsigned char byte, void *data_unused);
+/* Same, but bypasses the queue of CONFIG_CONSOLE_ASYNC. */
+void console_interactive_tx_byte_sync(unsigned char byte);
 /* Consoles that store logs on some medium for later retrieval. */
 void console_stored_tx_byte(unsigned char byte, void *data_unused);
 
@@ -10,6 +10,12 @@
 /* Defined in src/lib/lzma.c. Returns decompressed size or 0 on error. */
 size_t ulzman(const void *src, size_t srcn, void *dst, size_t dstn);
 
+/* Defined in src/lib/lzma.c. Like ulzman(), but reads the compressed data from |rdev| in
+   chunks through the |work_size| bytes large |work| buffer instead of needing it mapped. */
+struct region_device;
+size_t ulzman_rdev(const struct region_device *rdev, void *dst, size_t dstn,
+		   void *work, size_t work_size);
+
 /* Defined in src/lib/ramtest.c */
 /* Assumption is 32-bit addressable UC memory. */
 void ram_check(uintptr_t start);
@@ -10,6 +10,8 @@
  * is exposed so that a memranges can be used on the stack if needed. */
 struct memranges {
 	struct range_entry *entries;
+	/* The same entries in a balanced search tree ordered by address. */
+	struct range_entry *root;
 	/* coreboot doesn't have a free() function. Therefore, keep a cache of
 	 * free'd entries.  */
 	struct range_entry *free_list;
@@ -26,6 +28,12 @@ struct range_entry {
 	resource_t end;
 	unsigned long tag;
 	struct range_entry *next;
+	/* Search tree links, only used within memrange.c. */
+	struct range_entry *left;
+	struct range_entry *right;
+	/* Largest end - begin in the subtree rooted at this entry. */
+	resource_t max_span;
+	int height;
 };
 
 /* Initialize a range_entry with inclusive beginning address and exclusive
@@ -38,6 +46,8 @@ static inline void range_entry_init(struct range_entry *re,
 	re->end = excl_end - 1;
 	re->tag = tag;
 	re->next = NULL;
+	re->left = NULL;
+	re->right = NULL;
 }
 
 /* Return inclusive base address of memory range. */
@@ -152,6 +162,14 @@ void memranges_create_hole(struct memranges *ranges,
 void memranges_insert(struct memranges *ranges,
 		      resource_t base, resource_t size, unsigned long tag);
 
+/* Insert several resources at once. This has the same result as calling
+ * memranges_insert() for each entry in order, using only the begin, end and
+ * tag of each entry (see range_entry_init()). If the memranges is empty and
+ * the entries are sorted and don't overlap, e.g. when they come from another
+ * memranges, they are added in a single pass. */
+void memranges_insert_bulk(struct memranges *ranges,
+			   const struct range_entry *entries, size_t count);
+
 /* Update all entries with old_tag to new_tag. */
 void memranges_update_tag(struct memranges *ranges, unsigned long old_tag,
 			  unsigned long new_tag);
@@ -0,0 +1,23 @@
+/* SPDX-License-Identifier: GPL-2.0-only */
+
+#ifndef _MULTIHASH_H_
+#define _MULTIHASH_H_
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <vb2_sha.h>
+
+/* Enough for a verification and a measurement digest of the same data. */
+#define MULTIHASH_MAX_DIGESTS 2
+
+/*
+ * Calculate the digests of |buf| for the algorithms set in hashes[i].algo. The buffer is walked
+ * only once, in chunks that stay in cache while every algorithm hashes them. If hardware
+ * crypto is allowed, it's used for the first algorithm it supports; the hardware only keeps
+ * the state of one digest at a time.
+ */
+vb2_error_t multihash_calculate(bool allow_hwcrypto, const void *buf, uint32_t size,
+				struct vb2_hash *hashes, size_t count);
+
+#endif /* _MULTIHASH_H_ */
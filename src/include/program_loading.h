@@ -184,6 +184,12 @@ void payload_run(void);
  */
 bool selfload_check(struct prog *payload, enum bootmem_type dest_type);
 bool selfload(struct prog *payload);
+/*
+ * Like selfload_check() but reads the payload segment by segment from the boot device, see
+ * CONFIG_PAYLOAD_PIPELINED_LOAD. Returns false without loading anything if the payload can't
+ * be loaded this way, callers should fall back to mapping it then.
+ */
+bool selfload_pipelined(struct prog *payload, enum bootmem_type dest_type);
 /* Like selfload_check() but with the payload data already mapped to memory. */
 bool selfload_mapped(struct prog *payload, void *mapping,
 		     enum bootmem_type dest_type);
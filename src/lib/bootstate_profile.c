@@ -0,0 +1,79 @@
+/* SPDX-License-Identifier: GPL-2.0-only */
+
+#include <bootstate.h>
+#include <cbmem.h>
+#include <commonlib/bs_profile_serialized.h>
+#include <console/console.h>
+#include <string.h>
+#include <timer.h>
+#include <types.h>
+
+#define MAX_ENTRIES 256
+
+static struct bs_profile_table *table;
+static bool table_failed;
+static uint8_t current_state;
+static uint8_t current_phase;
+
+/* The table is set up on first use, which also resets an old one found in CBMEM on resume. */
+static struct bs_profile_table *profile_table(void)
+{
+	if (table || table_failed)
+		return table;
+
+	table = cbmem_add(CBMEM_ID_BS_PROFILE,
+			  sizeof(*table) + MAX_ENTRIES * sizeof(table->entries[0]));
+	if (!table) {
+		printk(BIOS_ERR, "BS: Unable to allocate boot state profile.\n");
+		table_failed = true;
+		return NULL;
+	}
+
+	table->max_entries = MAX_ENTRIES;
+	table->num_entries = 0;
+	table->dropped = 0;
+	table->reserved = 0;
+	return table;
+}
+
+void bs_profile_phase(boot_state_t state, uint8_t phase)
+{
+	current_state = state;
+	current_phase = phase;
+}
+
+void bs_profile_record(uint8_t kind, const struct mono_time *start, const void *func,
+		       const char *name)
+{
+	struct bs_profile_table *t = profile_table();
+	struct bs_profile_entry *e;
+	struct mono_time now;
+	size_t len;
+
+	if (!t)
+		return;
+
+	if (t->num_entries >= t->max_entries) {
+		t->dropped++;
+		return;
+	}
+
+	timer_monotonic_get(&now);
+
+	e = &t->entries[t->num_entries++];
+	e->kind = kind;
+	e->state = current_state;
+	e->phase = current_phase;
+	e->reserved = 0;
+	e->func = (uintptr_t)func;
+	e->start_us = start->microseconds;
+	e->duration_us = mono_time_diff_microseconds(start, &now);
+
+	/* Keep the end of long names, that's where file names and line numbers are. */
+	len = name ? strlen(name) : 0;
+	if (len >= sizeof(e->name))
+		name += len - (sizeof(e->name) - 1);
+	memset(e->name, 0, sizeof(e->name));
+	if (len)
+		strncpy(e->name, name, sizeof(e->name) - 1);
+}
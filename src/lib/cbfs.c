@@ -2,6 +2,7 @@
 
 #include <assert.h>
 #include <boot_device.h>
+#include <bootstate.h>
 #include <cbfs.h>
 #include <cbmem.h>
 #include <commonlib/bsd/cbfs_private.h>
@@ -11,6 +12,7 @@
 #include <lib.h>
 #include <list.h>
 #include <metadata_hash.h>
+#include <multihash.h>
 #include <security/tpm/tspi/crtm.h>
 #include <security/vboot/vboot_common.h>
 #include <security/vboot/misc.h>
@@ -18,19 +20,38 @@
 #include <string.h>
 #include <symbols.h>
 #include <thread.h>
+#include <timer.h>
 #include <timestamp.h>
 
-struct mem_pool cbfs_cache =
-	MEM_POOL_INIT(_cbfs_cache, REGION_SIZE(cbfs_cache), CONFIG_CBFS_CACHE_ALIGN);
+/* Preloads and mappings are freed in any order, so don't use a plain stack of buffers. */
+struct mem_pool cbfs_cache = MEM_POOL_INIT_FREE_LIST(_cbfs_cache, REGION_SIZE(cbfs_cache),
+						     CONFIG_CBFS_CACHE_ALIGN);
+
+static void print_cbfs_cache_usage(void)
+{
+	printk(BIOS_DEBUG, "CBFS: cbfs_cache high-water mark %zu of %zu bytes, %zu failures\n",
+	       mem_pool_high_water(&cbfs_cache), cbfs_cache.size,
+	       mem_pool_failures(&cbfs_cache));
+}
 
 static void switch_to_postram_cache(int unused)
 {
-	if (_preram_cbfs_cache != _postram_cbfs_cache)
-		mem_pool_init(&cbfs_cache, _postram_cbfs_cache, REGION_SIZE(postram_cbfs_cache),
-			      CONFIG_CBFS_CACHE_ALIGN);
+	if (_preram_cbfs_cache != _postram_cbfs_cache) {
+		print_cbfs_cache_usage();
+		mem_pool_init_free_list(&cbfs_cache, _postram_cbfs_cache,
+					REGION_SIZE(postram_cbfs_cache),
+					CONFIG_CBFS_CACHE_ALIGN);
+	}
 }
 CBMEM_CREATION_HOOK(switch_to_postram_cache);
 
+static void print_postram_cbfs_cache_usage(void *unused)
+{
+	print_cbfs_cache_usage();
+}
+BOOT_STATE_INIT_ENTRY(BS_PAYLOAD_BOOT, BS_ON_ENTRY, print_postram_cbfs_cache_usage,
+		      NULL);
+
 enum cb_err _cbfs_boot_lookup(const char *name, bool force_ro,
 			      union cbfs_mdata *mdata, struct region_device *rdev)
 {
@@ -145,6 +166,31 @@ static inline bool cbfs_lzma_enabled(void)
 	return true;
 }
 
+/*
+ * On boot media that are not memory-mapped, LZMA files can be decompressed straight from the
+ * boot device through a small pair of buffers instead of reading the whole file into the
+ * cbfs_cache first. This is only possible when the compressed data doesn't need to be hashed
+ * as a whole before decompression (for verification or measurement).
+ */
+#define CBFS_LZMA_STREAM_BUFFER_SIZE (8 * KiB)
+
+static inline bool cbfs_lzma_stream_allowed(const struct region_device *rdev,
+					    bool skip_verification)
+{
+	const struct region_device *root = rdev->root ? rdev->root : rdev;
+
+	if (!CONFIG(CBFS_LZMA_STREAMING))
+		return false;
+	/* Preloaded files are already in memory, so mapping them is free. */
+	if (root->ops == &mem_rdev_ro_ops || root->ops == &mem_rdev_rw_ops)
+		return false;
+	if (CONFIG(CBFS_VERIFICATION) && !skip_verification)
+		return false;
+	if (CONFIG(TPM_MEASURED_BOOT))
+		return false;
+	return true;
+}
+
 static bool cbfs_file_hash_mismatch(const void *buffer, size_t size,
 				    const union cbfs_mdata *mdata, bool skip_verification)
 {
@@ -153,15 +199,33 @@ static bool cbfs_file_hash_mismatch(const void *buffer, size_t size,
 		return false;
 
 	const struct vb2_hash *hash = NULL;
+	const bool measure = CONFIG(TPM_MEASURED_BOOT) && !ENV_SMM;
+	/* Verification and measurement digests, when they use different algorithms. */
+	struct vb2_hash hashes[MULTIHASH_MAX_DIGESTS];
 
 	if (CONFIG(CBFS_VERIFICATION) && !skip_verification) {
+		vb2_error_t rv;
+
 		hash = cbfs_file_hash(mdata);
 		if (!hash) {
 			ERROR("'%s' does not have a file hash!\n", mdata->h.filename);
 			return true;
 		}
 
-		vb2_error_t rv = vb2_hash_verify(vboot_hwcrypto_allowed(), buffer, size, hash);
+		if (measure && hash->algo != TPM_MEASURE_ALGO) {
+			/* Calculate both digests in one pass over the file. */
+			hashes[0].algo = hash->algo;
+			hashes[1].algo = TPM_MEASURE_ALGO;
+			rv = multihash_calculate(vboot_hwcrypto_allowed(), buffer, size,
+						 hashes, ARRAY_SIZE(hashes));
+			if (rv == VB2_SUCCESS && vb2_safe_memcmp(hashes[0].raw, hash->raw,
+								 vb2_digest_size(hash->algo)))
+				rv = VB2_ERROR_SHA_MISMATCH;
+			hash = &hashes[1];
+		} else {
+			rv = vb2_hash_verify(vboot_hwcrypto_allowed(), buffer, size, hash);
+		}
+
 		if (rv != VB2_SUCCESS) {
 			ERROR("'%s' file hash mismatch!\n", mdata->h.filename);
 			if (CONFIG(VBOOT_CBFS_INTEGRATION) && !vboot_recovery_mode_enabled()
@@ -172,16 +236,14 @@ static bool cbfs_file_hash_mismatch(const void *buffer, size_t size,
 		}
 	}
 
-	if (CONFIG(TPM_MEASURED_BOOT) && !ENV_SMM) {
-		struct vb2_hash calculated_hash;
-
+	if (measure) {
 		/* No need to re-hash file if we already have it from verification. */
-		if (!hash || hash->algo != TPM_MEASURE_ALGO) {
+		if (!hash) {
 			if (vb2_hash_calculate(vboot_hwcrypto_allowed(), buffer, size,
-					       TPM_MEASURE_ALGO, &calculated_hash))
+					       TPM_MEASURE_ALGO, &hashes[0]))
 				hash = NULL;
 			else
-				hash = &calculated_hash;
+				hash = &hashes[0];
 		}
 
 		if (!hash ||
@@ -244,6 +306,19 @@ static size_t cbfs_load_and_decompress(const struct region_device *rdev, void *b
 	case CBFS_COMPRESS_LZMA:
 		if (!cbfs_lzma_enabled())
 			return 0;
+
+		if (cbfs_lzma_stream_allowed(rdev, skip_verification)) {
+			void *work = mem_pool_alloc(&cbfs_cache, CBFS_LZMA_STREAM_BUFFER_SIZE);
+			if (work) {
+				timestamp_add_now(TS_ULZMA_START);
+				out_size = ulzman_rdev(rdev, buffer, buffer_size, work,
+						       CBFS_LZMA_STREAM_BUFFER_SIZE);
+				timestamp_add_now(TS_ULZMA_END);
+				mem_pool_free(&cbfs_cache, work);
+				return out_size;
+			}
+		}
+
 		map = rdev_mmap_full(rdev);
 		if (map == NULL)
 			return 0;
@@ -264,15 +339,35 @@ static size_t cbfs_load_and_decompress(const struct region_device *rdev, void *b
 	}
 }
 
+/*
+ * Preloads are served by a single worker thread that reads queued files one after the other in
+ * flash offset order, so the boot device sees one long mostly sequential transfer instead of
+ * several threads competing for it. The worker only reads ahead as far as
+ * CONFIG_CBFS_PRELOAD_MAX_INFLIGHT allows. Beyond that it exits and is started again once a
+ * file has been consumed.
+ */
+enum cbfs_preload_state {
+	CBFS_PRELOAD_QUEUED,
+	CBFS_PRELOAD_READING,
+	CBFS_PRELOAD_DONE,
+	CBFS_PRELOAD_FAILED,
+};
+
 struct cbfs_preload_context {
 	struct region_device rdev;
-	struct thread_handle handle;
 	struct list_node list_node;
+	enum cbfs_preload_state state;
+	/* Done once the worker has finished reading this file, see cbfs_preload_worker(). */
+	struct thread_handle handle;
 	void *buffer;
 	char name[];
 };
 
+/* Sorted by flash offset among the entries that are still queued. */
 static struct list_node cbfs_preload_context_list;
+static struct thread_handle cbfs_preload_worker_handle;
+/* Bytes read (or being read) by the worker that haven't been picked up by a consumer yet. */
+static size_t cbfs_preload_inflight;
 
 static struct cbfs_preload_context *alloc_cbfs_preload_context(size_t additional)
 {
@@ -289,8 +384,19 @@ static struct cbfs_preload_context *alloc_cbfs_preload_context(size_t additional
 	return context;
 }
 
-static void append_cbfs_preload_context(struct cbfs_preload_context *context)
+static void queue_cbfs_preload_context(struct cbfs_preload_context *context)
 {
+	struct cbfs_preload_context *next;
+	const size_t offset = region_device_offset(&context->rdev);
+
+	list_for_each(next, cbfs_preload_context_list, list_node) {
+		if (next->state == CBFS_PRELOAD_QUEUED &&
+		    region_device_offset(&next->rdev) > offset) {
+			list_insert_before(&context->list_node, &next->list_node);
+			return;
+		}
+	}
+
 	list_append(&context->list_node, &cbfs_preload_context_list);
 }
 
@@ -301,25 +407,101 @@ static void free_cbfs_preload_context(struct cbfs_preload_context *context)
 	mem_pool_free(&cbfs_cache, context);
 }
 
-static enum cb_err cbfs_preload_thread_entry(void *arg)
+static struct cbfs_preload_context *find_cbfs_preload_context(const char *name)
 {
-	struct cbfs_preload_context *context = arg;
+	struct cbfs_preload_context *context;
 
-	if (rdev_read_full(&context->rdev, context->buffer) < 0) {
-		ERROR("%s(name='%s') readat failed\n", __func__, context->name);
-		return CB_ERR;
+	list_for_each(context, cbfs_preload_context_list, list_node) {
+		if (strcmp(context->name, name) == 0)
+			return context;
+	}
+
+	return NULL;
+}
+
+static struct cbfs_preload_context *next_queued_cbfs_preload_context(void)
+{
+	struct cbfs_preload_context *context;
+
+	list_for_each(context, cbfs_preload_context_list, list_node) {
+		if (context->state == CBFS_PRELOAD_QUEUED)
+			return context;
+	}
+
+	return NULL;
+}
+
+static enum cb_err cbfs_preload_worker(void *unused)
+{
+	struct cbfs_preload_context *context;
+
+	while ((context = next_queued_cbfs_preload_context())) {
+		const size_t size = region_device_sz(&context->rdev);
+
+		/*
+		 * Always allow one file in flight, however large, so the queue can't stall.
+		 * Past the limit, give the thread back instead of holding it while waiting.
+		 * get_preload_rdev() starts the worker again once a file has been picked up.
+		 */
+		if (cbfs_preload_inflight &&
+		    cbfs_preload_inflight + size > CONFIG_CBFS_PRELOAD_MAX_INFLIGHT)
+			break;
+
+		context->buffer = mem_pool_alloc(&cbfs_cache, size);
+		if (!context->buffer) {
+			ERROR("%s(name='%s') failed to allocate %zu bytes for preload buffer\n",
+			      __func__, context->name, size);
+			context->state = CBFS_PRELOAD_FAILED;
+			continue;
+		}
+
+		/*
+		 * The handle tracks the read of this one file as if it ran on a thread of its
+		 * own, so a consumer can thread_join() it without waiting for the whole queue.
+		 */
+		context->state = CBFS_PRELOAD_READING;
+		context->handle.state = THREAD_STARTED;
+		cbfs_preload_inflight += size;
+
+		timestamp_add_now(TS_CBFS_PRELOAD_START);
+		if (rdev_read_full(&context->rdev, context->buffer) < 0) {
+			ERROR("%s(name='%s') readat failed\n", __func__, context->name);
+			context->state = CBFS_PRELOAD_FAILED;
+			context->handle.error = CB_ERR;
+		} else {
+			context->state = CBFS_PRELOAD_DONE;
+			context->handle.error = CB_SUCCESS;
+		}
+		context->handle.state = THREAD_DONE;
+		timestamp_add_now(TS_CBFS_PRELOAD_END);
 	}
 
 	return CB_SUCCESS;
 }
 
-void cbfs_preload(const char *name)
+static void start_cbfs_preload_worker(void)
+{
+	struct cbfs_preload_context *context;
+
+	if (cbfs_preload_worker_handle.state == THREAD_STARTED ||
+	    !next_queued_cbfs_preload_context())
+		return;
+
+	if (thread_run(&cbfs_preload_worker_handle, cbfs_preload_worker, NULL) == 0)
+		return;
+
+	ERROR("%s() failed to start preload thread\n", __func__);
+	while ((context = next_queued_cbfs_preload_context()))
+		free_cbfs_preload_context(context);
+}
+
+void cbfs_preload_batch(const char *const names[], size_t count)
 {
 	struct region_device rdev;
 	union cbfs_mdata mdata;
 	struct cbfs_preload_context *context;
 	bool force_ro = false;
-	size_t size;
+	size_t queued = 0;
 
 	if (!CONFIG(CBFS_PRELOAD))
 		dead_code();
@@ -328,57 +510,45 @@ void cbfs_preload(const char *name)
 	if (ENV_ROMSTAGE && CONFIG(VBOOT_STARTS_IN_ROMSTAGE))
 		return;
 
-	DEBUG("%s(name='%s')\n", __func__, name);
+	for (size_t i = 0; i < count; i++) {
+		const char *name = names[i];
 
-	if (_cbfs_boot_lookup(name, force_ro, &mdata, &rdev))
-		return;
+		DEBUG("%s(name='%s')\n", __func__, name);
 
-	size = region_device_sz(&rdev);
-
-	context = alloc_cbfs_preload_context(strlen(name) + 1);
-	if (!context) {
-		ERROR("%s(name='%s') failed to allocate preload context\n", __func__, name);
-		return;
-	}
-
-	context->buffer = mem_pool_alloc(&cbfs_cache, size);
-	if (context->buffer == NULL) {
-		ERROR("%s(name='%s') failed to allocate %zu bytes for preload buffer\n",
-		      __func__, name, size);
-		goto out;
-	}
+		if (find_cbfs_preload_context(name))
+			continue;
 
-	context->rdev = rdev;
-	strcpy(context->name, name);
+		if (_cbfs_boot_lookup(name, force_ro, &mdata, &rdev))
+			continue;
 
-	append_cbfs_preload_context(context);
-
-	if (thread_run(&context->handle, cbfs_preload_thread_entry, context) == 0)
-		return;
+		context = alloc_cbfs_preload_context(strlen(name) + 1);
+		if (!context) {
+			ERROR("%s(name='%s') failed to allocate preload context\n", __func__,
+			      name);
+			continue;
+		}
 
-	ERROR("%s(name='%s') failed to start preload thread\n", __func__, name);
-	mem_pool_free(&cbfs_cache, context->buffer);
+		context->rdev = rdev;
+		strcpy(context->name, name);
+		queue_cbfs_preload_context(context);
+		queued++;
+	}
 
-out:
-	free_cbfs_preload_context(context);
+	if (queued)
+		start_cbfs_preload_worker();
 }
 
-static struct cbfs_preload_context *find_cbfs_preload_context(const char *name)
+void cbfs_preload(const char *name)
 {
-	struct cbfs_preload_context *context;
-
-	list_for_each(context, cbfs_preload_context_list, list_node) {
-		if (strcmp(context->name, name) == 0)
-			return context;
-	}
-
-	return NULL;
+	cbfs_preload_batch(&name, 1);
 }
 
 static enum cb_err get_preload_rdev(struct region_device *rdev, const char *name)
 {
 	enum cb_err err;
 	struct cbfs_preload_context *context;
+	struct stopwatch sw;
+	int64_t waited_us = 0;
 
 	if (!CONFIG(CBFS_PRELOAD) || !ENV_SUPPORTS_COOP)
 		return CB_ERR_ARG;
@@ -387,10 +557,33 @@ static enum cb_err get_preload_rdev(struct region_device *rdev, const char *name
 	if (!context)
 		return CB_ERR_ARG;
 
-	err = thread_join(&context->handle);
-	if (err != CB_SUCCESS) {
-		ERROR("%s(name='%s') Preload thread failed: %u\n", __func__, name, err);
+	switch (context->state) {
+	case CBFS_PRELOAD_QUEUED:
+		/* Not started yet, so reading it directly is at least as fast. */
+		printk(BIOS_DEBUG, "CBFS: Preload of '%s' missed, not started yet\n", name);
+		timestamp_add_now(TS_CBFS_PRELOAD_MISS);
+		free_cbfs_preload_context(context);
+		return CB_ERR_ARG;
+	case CBFS_PRELOAD_READING:
+		timestamp_add_now(TS_CBFS_PRELOAD_WAIT_START);
+		stopwatch_init(&sw);
+		thread_join(&context->handle);
+		waited_us = stopwatch_duration_usecs(&sw);
+		timestamp_add_now(TS_CBFS_PRELOAD_WAIT_END);
+		break;
+	default:
+		break;
+	}
+
+	if (context->buffer) {
+		cbfs_preload_inflight -= region_device_sz(&context->rdev);
+		/* The worker may have stopped at the in-flight limit. */
+		start_cbfs_preload_worker();
+	}
 
+	if (context->state != CBFS_PRELOAD_DONE) {
+		ERROR("%s(name='%s') Preload failed\n", __func__, name);
+		err = CB_ERR;
 		goto out;
 	}
 
@@ -401,11 +594,16 @@ static enum cb_err get_preload_rdev(struct region_device *rdev, const char *name
 		goto out;
 	}
 
+	/* The buffer is handed to the caller, which frees it once it is done. */
+	context->buffer = NULL;
 	err = CB_SUCCESS;
 
-	DEBUG("%s(name='%s') preload successful\n", __func__, name);
-
 out:
+	/* The timestamps don't say which file they belong to, so log that here. */
+	printk(BIOS_DEBUG, "CBFS: Preload of '%s' %s, waited %lld us\n", name,
+	       err == CB_SUCCESS ? "hit" : "failed", waited_us);
+	timestamp_add_now(err == CB_SUCCESS ? TS_CBFS_PRELOAD_HIT : TS_CBFS_PRELOAD_MISS);
+	mem_pool_free(&cbfs_cache, context->buffer);
 	free_cbfs_preload_context(context);
 
 	return err;
@@ -701,7 +899,7 @@ static void mcache_to_cbmem(const struct cbfs_boot_device *cbd, u32 cbmem_id)
 		       cbmem_id, real_size);
 		return;
 	}
-	memcpy(cbmem_mcache, cbd->mcache, real_size);
+	cbfs_mcache_copy(cbmem_mcache, cbd->mcache, cbd->mcache_size);
 }
 
 static void cbfs_mcache_migrate(int unused)
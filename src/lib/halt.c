@@ -1,10 +1,16 @@
 /* SPDX-License-Identifier: GPL-2.0-only */
 
 #include <arch/hlt.h>
+#include <console/async.h>
+#include <console/percpu.h>
 #include <halt.h>
 
 void halt(void)
 {
+	/* Get out what APs logged and what is still queued for slow consoles. */
+	console_percpu_drain();
+	console_async_flush();
+
 	while (1)
 		hlt();
 }
@@ -274,12 +274,15 @@ static void bs_call_callbacks(struct boot_state *state,
 			phase->callbacks = bscb->next;
 			bscb->next = NULL;
 
-			if (CONFIG(DEBUG_BOOT_STATE)) {
+			if (CONFIG(DEBUG_BOOT_STATE))
 				printk(BIOS_DEBUG, "BS: callback (%p) @ %s.\n",
 					bscb, bscb_location(bscb));
+			if (CONFIG(DEBUG_BOOT_STATE) || CONFIG(BOOT_STATE_PROFILER))
 				timer_monotonic_get(&mt_start);
-			}
 			bscb->callback(bscb->arg);
+			bs_profile_record(BS_PROFILE_CALLBACK, &mt_start, bscb->callback,
+					  CONFIG(DEBUG_BOOT_STATE) ?
+					  bscb_location(bscb) : NULL);
 			if (CONFIG(DEBUG_BOOT_STATE)) {
 				timer_monotonic_get(&mt_stop);
 				printk(BIOS_DEBUG, "BS: callback (%p) @ %s (%lld ms).\n", bscb,
@@ -319,6 +322,7 @@ static void bs_walk_state_machine(void)
 
 	while (1) {
 		struct boot_state *state;
+		struct mono_time run_start;
 		boot_state_t next_id;
 
 		state = &boot_states[current_phase.state_id];
@@ -337,6 +341,7 @@ static void bs_walk_state_machine(void)
 
 		bs_sample_time(state);
 
+		bs_profile_phase(current_phase.state_id, BS_PROFILE_PHASE_ENTRY);
 		bs_call_callbacks(state, current_phase.seq);
 		/* Update the current sequence so that any calls to block the
 		 * current state from the run_state() function will place a
@@ -347,7 +352,11 @@ static void bs_walk_state_machine(void)
 
 		post_code(state->post_code);
 
+		bs_profile_phase(current_phase.state_id, BS_PROFILE_PHASE_RUN);
+		if (CONFIG(BOOT_STATE_PROFILER))
+			timer_monotonic_get(&run_start);
 		next_id = state->run_state(state->arg);
+		bs_profile_record(BS_PROFILE_STATE, &run_start, state->run_state, state->name);
 
 		if (CONFIG(DEBUG_BOOT_STATE))
 			printk(BIOS_DEBUG, "BS: Exiting %s state.\n",
@@ -357,6 +366,7 @@ static void bs_walk_state_machine(void)
 
 		bs_run_timers(0);
 
+		bs_profile_phase(current_phase.state_id, BS_PROFILE_PHASE_EXIT);
 		bs_call_callbacks(state, current_phase.seq);
 
 		if (CONFIG(DEBUG_BOOT_STATE))
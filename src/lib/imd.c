@@ -89,6 +89,139 @@ static void imd_entry_assign(struct imd_entry *e, uint32_t id,
 	e->id = id;
 }
 
+/*
+ * Entries are looked up by id through a small open-addressed hash table per root, so finding
+ * one doesn't scan the whole root. The tables live outside the imd: they are built when a root
+ * is created or recovered and kept up to date when entries are added or removed. Roots without
+ * a table, e.g. because there are too many entries, fall back to scanning.
+ *
+ * The tables take about 1 KiB of .bss, which earlier stages (possibly running from CAR) can't
+ * spare. They look up few entries anyway, so they always scan.
+ */
+#if ENV_RAMSTAGE || ENV_POSTCAR
+#define IMD_INDEX_ROOTS 4
+#else
+#define IMD_INDEX_ROOTS 0
+#endif
+#define IMD_INDEX_SLOT_BITS 8
+#define IMD_INDEX_SLOTS (1 << IMD_INDEX_SLOT_BITS)
+/* Keep the load factor at 3/4 at most. */
+#define IMD_INDEX_MAX_ENTRIES (IMD_INDEX_SLOTS * 3 / 4)
+
+struct imd_index {
+	const struct imd_root *r;
+	/* Number of entries of r covered by the table. */
+	uint32_t num_entries;
+	/* Index of the entry in r, 0 for a free slot. Entry 0 covers the root, it's never
+	   looked up. */
+	uint8_t slots[IMD_INDEX_SLOTS];
+};
+
+_Static_assert(IMD_INDEX_MAX_ENTRIES <= UINT8_MAX, "Entry index doesn't fit in a slot");
+
+static struct imd_index imd_indexes[IMD_INDEX_ROOTS];
+static size_t imd_index_next;
+
+static size_t imd_index_hash(uint32_t id)
+{
+	/* Fibonacci hashing, the ids are often close to each other. */
+	return (uint32_t)(id * 0x9e3779b1u) >> (32 - IMD_INDEX_SLOT_BITS);
+}
+
+static struct imd_index *imd_index_get(const struct imd_root *r)
+{
+	size_t i;
+
+	for (i = 0; i < ARRAY_SIZE(imd_indexes); i++) {
+		if (imd_indexes[i].r == r)
+			return &imd_indexes[i];
+	}
+
+	return NULL;
+}
+
+static void imd_index_insert(struct imd_index *idx, const struct imd_root *r, uint32_t i)
+{
+	size_t slot = imd_index_hash(r->entries[i].id);
+
+	while (idx->slots[slot] != 0) {
+		/* Lookups return the first entry with an id, like the scan does. */
+		if (r->entries[idx->slots[slot]].id == r->entries[i].id)
+			return;
+		slot = (slot + 1) % IMD_INDEX_SLOTS;
+	}
+
+	idx->slots[slot] = i;
+}
+
+/* (Re)build the table of a root, taking over the oldest table if it doesn't have one. */
+static void imd_index_build(const struct imd_root *r)
+{
+	struct imd_index *idx;
+	uint32_t i;
+
+	if (!IMD_INDEX_ROOTS)
+		return;
+
+	idx = imd_index_get(r);
+
+	if (r->num_entries > IMD_INDEX_MAX_ENTRIES) {
+		if (idx != NULL)
+			idx->r = NULL;
+		return;
+	}
+
+	if (idx == NULL) {
+		idx = &imd_indexes[imd_index_next];
+		if (++imd_index_next == ARRAY_SIZE(imd_indexes))
+			imd_index_next = 0;
+	}
+
+	memset(idx->slots, 0, sizeof(idx->slots));
+
+	for (i = 1; i < r->num_entries; i++)
+		imd_index_insert(idx, r, i);
+
+	idx->num_entries = r->num_entries;
+	idx->r = r;
+}
+
+/* Add the last entry of a root to its table. */
+static void imd_index_add(const struct imd_root *r)
+{
+	struct imd_index *idx = imd_index_get(r);
+
+	if (idx == NULL)
+		return;
+
+	if (idx->num_entries + 1 != r->num_entries || r->num_entries > IMD_INDEX_MAX_ENTRIES) {
+		idx->r = NULL;
+		return;
+	}
+
+	imd_index_insert(idx, r, r->num_entries - 1);
+	idx->num_entries = r->num_entries;
+}
+
+/* Returns the index of the entry with the id, 0 if there is none or -1 without a table. */
+static int imd_index_find(const struct imd_root *r, uint32_t id)
+{
+	const struct imd_index *idx = imd_index_get(r);
+	size_t slot;
+
+	/* Entries may have been added behind the table's back, e.g. by an older stage. */
+	if (idx == NULL || idx->num_entries != r->num_entries)
+		return -1;
+
+	for (slot = imd_index_hash(id); idx->slots[slot] != 0;
+	     slot = (slot + 1) % IMD_INDEX_SLOTS) {
+		if (r->entries[idx->slots[slot]].id == id)
+			return idx->slots[slot];
+	}
+
+	return 0;
+}
+
 static void imdr_init(struct imdr *ir, void *upper_limit)
 {
 	uintptr_t limit = (uintptr_t)upper_limit;
@@ -148,6 +281,7 @@ static int imdr_create_empty(struct imdr *imdr, size_t root_size,
 	r->num_entries = 1;
 	e = &r->entries[0];
 	imd_entry_assign(e, CBMEM_ID_IMD_ROOT, 0, root_size);
+	imd_index_build(r);
 
 	printk(BIOS_DEBUG, "IMD: root @ %p %u entries.\n", r, r->max_entries);
 
@@ -205,6 +339,7 @@ static int imdr_recover(struct imdr *imdr)
 
 	/* Set root pointer. */
 	imdr->r = r;
+	imd_index_build(r);
 
 	return 0;
 }
@@ -215,12 +350,17 @@ static const struct imd_entry *imdr_entry_find(const struct imdr *imdr,
 	struct imd_root *r;
 	struct imd_entry *e;
 	size_t i;
+	int idx;
 
 	r = imdr_root(imdr);
 
 	if (r == NULL)
 		return NULL;
 
+	idx = imd_index_find(r, id);
+	if (idx >= 0)
+		return idx ? &r->entries[idx] : NULL;
+
 	e = NULL;
 	/* Skip first entry covering the root. */
 	for (i = 1; i < r->num_entries; i++) {
@@ -299,6 +439,7 @@ static struct imd_entry *imd_entry_add_to_root(struct imd_root *r, uint32_t id,
 	r->num_entries++;
 
 	imd_entry_assign(entry, id, e_offset, size);
+	imd_index_add(r);
 
 	return entry;
 }
@@ -605,6 +746,7 @@ int imd_entry_remove(const struct imd *imd, const struct imd_entry *entry)
 		return -1;
 
 	r->num_entries--;
+	imd_index_build(r);
 
 	return 0;
 }
@@ -11,31 +11,26 @@
  *
  */
 
+#include <commonlib/region.h>
 #include <console/console.h>
 #include <string.h>
 #include <lib.h>
+#include <thread.h>
 
 #include "lzmadecode.h"
 
-size_t ulzman(const void *src, size_t srcn, void *dst, size_t dstn)
+#define LZMA_HEADER_SIZE (LZMA_PROPERTIES_SIZE + 8)
+
+static unsigned char scratchpad[15980];
+
+/* Parse the stream header at |src| and set up |state| to decode into |dstn| bytes. Returns the
+   number of bytes to decode, or 0 on error. */
+static UInt32 lzma_init(CLzmaDecoderState *state, const unsigned char *src, size_t dstn)
 {
-	unsigned char properties[LZMA_PROPERTIES_SIZE];
-	const int data_offset = LZMA_PROPERTIES_SIZE + 8;
 	UInt32 outSize;
-	SizeT inProcessed;
-	SizeT outProcessed;
-	int res;
-	CLzmaDecoderState state;
 	SizeT mallocneeds;
-	static unsigned char scratchpad[15980];
 	const unsigned char *cp;
 
-	if (srcn < data_offset) {
-		printk(BIOS_WARNING, "lzma: Input too small.\n");
-		return 0;
-	}
-
-	memcpy(properties, src, LZMA_PROPERTIES_SIZE);
 	/* The outSize in LZMA stream is a 64bit integer stored in little-endian
 	 * (ref: lzma.cc@LZMACompress: put_64). To prevent accessing by
 	 * unaligned memory address and to load in correct endianness, read each
@@ -44,18 +39,39 @@ size_t ulzman(const void *src, size_t srcn, void *dst, size_t dstn)
 	outSize = cp[3] << 24 | cp[2] << 16 | cp[1] << 8 | cp[0];
 	if (outSize > dstn)
 		outSize = dstn;
-	if (LzmaDecodeProperties(&state.Properties, properties,
+	if (LzmaDecodeProperties(&state->Properties, src,
 				 LZMA_PROPERTIES_SIZE) != LZMA_RESULT_OK) {
 		printk(BIOS_WARNING, "lzma: Incorrect stream properties.\n");
 		return 0;
 	}
-	mallocneeds = (LzmaGetNumProbs(&state.Properties) * sizeof(CProb));
-	if (mallocneeds > 15980) {
+	mallocneeds = (LzmaGetNumProbs(&state->Properties) * sizeof(CProb));
+	if (mallocneeds > sizeof(scratchpad)) {
 		printk(BIOS_WARNING, "lzma: Decoder scratchpad too small!\n");
 		return 0;
 	}
-	state.Probs = (CProb *)scratchpad;
-	res = LzmaDecode(&state, src + data_offset, srcn - data_offset,
+	state->Probs = (CProb *)scratchpad;
+	state->Refill = NULL;
+	state->RefillArg = NULL;
+	return outSize;
+}
+
+size_t ulzman(const void *src, size_t srcn, void *dst, size_t dstn)
+{
+	UInt32 outSize;
+	SizeT inProcessed;
+	SizeT outProcessed;
+	int res;
+	CLzmaDecoderState state;
+
+	if (srcn < LZMA_HEADER_SIZE) {
+		printk(BIOS_WARNING, "lzma: Input too small.\n");
+		return 0;
+	}
+
+	outSize = lzma_init(&state, src, dstn);
+	if (!outSize)
+		return 0;
+	res = LzmaDecode(&state, src + LZMA_HEADER_SIZE, srcn - LZMA_HEADER_SIZE,
 			 &inProcessed, dst, outSize, &outProcessed);
 	if (res != 0) {
 		printk(BIOS_WARNING, "lzma: Decoding error = %d\n", res);
@@ -63,3 +79,129 @@ size_t ulzman(const void *src, size_t srcn, void *dst, size_t dstn)
 	}
 	return outProcessed;
 }
+
+/*
+ * Input side of ulzman_rdev(). The work buffer is split into two chunks. The chunk that is
+ * not being decoded gets filled with the next part of the file, on a separate thread if the
+ * stage supports cooperative multitasking, so that boot media with DMA can keep transferring
+ * while the decoder runs.
+ */
+struct lzma_stream {
+	const struct region_device *rdev;
+	unsigned char *chunk[2];
+	size_t chunk_size;
+	size_t offset;		/* Offset in |rdev| of the next read to start. */
+	int pending;		/* Chunk the outstanding read goes to, or -1. */
+	size_t pending_size;
+	struct thread_handle handle;
+	bool threaded;		/* Outstanding read runs on a separate thread. */
+	bool use_threads;
+};
+
+static enum cb_err lzma_stream_read(void *arg)
+{
+	struct lzma_stream *s = arg;
+
+	if (rdev_readat(s->rdev, s->chunk[s->pending], s->offset - s->pending_size,
+			s->pending_size) != s->pending_size)
+		return CB_ERR;
+	return CB_SUCCESS;
+}
+
+static void lzma_stream_start(struct lzma_stream *s, int chunk)
+{
+	const size_t remaining = region_device_sz(s->rdev) - s->offset;
+
+	s->pending = chunk;
+	s->pending_size = MIN(remaining, s->chunk_size);
+	s->offset += s->pending_size;
+	s->threaded = false;
+
+	if (!s->pending_size)
+		return;
+
+	if (ENV_SUPPORTS_COOP && s->use_threads &&
+	    thread_run(&s->handle, lzma_stream_read, s) == 0)
+		s->threaded = true;
+	else
+		s->use_threads = false;	/* Don't retry for every chunk. */
+}
+
+/* Wait for the outstanding read and start the next one into the other chunk. Returns the size
+   of the chunk that is now ready to decode (and passes it out in |buffer|), or 0. */
+static SizeT lzma_stream_refill(void *arg, const unsigned char **buffer)
+{
+	struct lzma_stream *s = arg;
+	const int ready = s->pending;
+	const size_t size = s->pending_size;
+	enum cb_err err;
+
+	if (ready < 0 || !size)
+		return 0;
+
+	if (ENV_SUPPORTS_COOP && s->threaded)
+		err = thread_join(&s->handle);
+	else
+		err = lzma_stream_read(s);
+
+	if (err != CB_SUCCESS) {
+		printk(BIOS_WARNING, "lzma: Read error at offset %#zx.\n",
+		       s->offset - size);
+		s->pending = -1;
+		return 0;
+	}
+
+	lzma_stream_start(s, !ready);
+
+	*buffer = s->chunk[ready];
+	return size;
+}
+
+size_t ulzman_rdev(const struct region_device *rdev, void *dst, size_t dstn,
+		   void *work, size_t work_size)
+{
+	const size_t chunk_size = ALIGN_DOWN(work_size / 2, sizeof(UInt32));
+	struct lzma_stream s = {
+		.rdev = rdev,
+		.chunk = { work, work + chunk_size },
+		.chunk_size = chunk_size,
+		.use_threads = ENV_SUPPORTS_COOP,
+	};
+	const unsigned char *src;
+	SizeT srcn;
+	UInt32 outSize;
+	SizeT inProcessed;
+	SizeT outProcessed = 0;
+	int res;
+	CLzmaDecoderState state;
+
+	if (chunk_size < LZMA_HEADER_SIZE) {
+		printk(BIOS_WARNING, "lzma: Stream buffer too small.\n");
+		return 0;
+	}
+
+	lzma_stream_start(&s, 0);
+	srcn = lzma_stream_refill(&s, &src);
+	if (srcn < LZMA_HEADER_SIZE) {
+		printk(BIOS_WARNING, "lzma: Input too small.\n");
+		goto out;
+	}
+
+	outSize = lzma_init(&state, src, dstn);
+	if (!outSize)
+		goto out;
+	state.Refill = lzma_stream_refill;
+	state.RefillArg = &s;
+	res = LzmaDecode(&state, src + LZMA_HEADER_SIZE, srcn - LZMA_HEADER_SIZE,
+			 &inProcessed, dst, outSize, &outProcessed);
+	if (res != 0) {
+		printk(BIOS_WARNING, "lzma: Decoding error = %d\n", res);
+		outProcessed = 0;
+	}
+
+out:
+	/* Don't leave a read into the caller's work buffer running behind its back. */
+	if (ENV_SUPPORTS_COOP && s.threaded && s.pending >= 0)
+		thread_join(&s.handle);
+	return outProcessed;
+}
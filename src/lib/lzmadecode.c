@@ -57,7 +57,16 @@
 }
 
 
-#define RC_TEST { if (Buffer == BufferLim) return LZMA_RESULT_DATA_ERROR; }
+/* When streaming, RC_TEST asks for the next input chunk instead of failing right away. */
+#define RC_TEST { if (Buffer == BufferLim) {				\
+	const Byte *next;						\
+	SizeT nextSize = RcRefill(vs, &next);				\
+	if (nextSize == 0)						\
+		return LZMA_RESULT_DATA_ERROR;				\
+	inConsumed += (SizeT)(Buffer - inStream);			\
+	inStream = Buffer = next;					\
+	BufferLim = next + nextSize;					\
+} }
 
 #define RC_INIT(buffer, bufferSize) Buffer = buffer; \
 	BufferLim = buffer + bufferSize; RC_INIT2
@@ -189,6 +198,12 @@ int LzmaDecodeProperties(CLzmaProperties *propsRes,
 
 #define kLzmaStreamWasFinishedId (-1)
 
+/* Only called when the current input chunk is exhausted, so keep it out of the hot path. */
+static __attribute__((noinline)) SizeT RcRefill(CLzmaDecoderState *vs, const Byte **next)
+{
+	return vs->Refill ? vs->Refill(vs->RefillArg, next) : 0;
+}
+
 __lzma_attribute_Ofast__
 int LzmaDecode(CLzmaDecoderState *vs,
 	const unsigned char *inStream, SizeT inSize, SizeT *inSizeProcessed,
@@ -214,6 +229,7 @@ int LzmaDecode(CLzmaDecoderState *vs,
 	} look_ahead;
 	UInt32 Range;
 	UInt32 Code;
+	SizeT inConsumed = 0;
 
 	*inSizeProcessed = 0;
 	*outSizeProcessed = 0;
@@ -435,7 +451,7 @@ int LzmaDecode(CLzmaDecoderState *vs,
 	 (void)len;
 
 
-	*inSizeProcessed = (SizeT)(Buffer - inStream);
+	*inSizeProcessed = inConsumed + (SizeT)(Buffer - inStream);
 	*outSizeProcessed = nowPos;
 	return LZMA_RESULT_OK;
 }
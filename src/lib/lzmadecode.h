@@ -52,9 +52,19 @@ int LzmaDecodeProperties(CLzmaProperties *propsRes,
 
 #define kLzmaNeedInitId (-2)
 
+/*
+ * Optional input callback for streaming decompression. When the decoder has consumed all of
+ * the input passed to LzmaDecode(), it calls Refill(RefillArg, &buffer) to obtain the next
+ * chunk. It must return the size of the chunk at *buffer, or 0 on end of input or error.
+ * Leave Refill NULL to decode from a single, complete input buffer.
+ */
+typedef SizeT (*CLzmaRefill)(void *arg, const unsigned char **buffer);
+
 typedef struct _CLzmaDecoderState {
 	CLzmaProperties Properties;
 	CProb *Probs;
+	CLzmaRefill Refill;
+	void *RefillArg;
 } CLzmaDecoderState;
 
 
@@ -1,14 +1,48 @@
 /* SPDX-License-Identifier: GPL-2.0-only */
 
 #include <string.h>
+#include <types.h>
+
+/* Word type used for the bulk of the copy. may_alias keeps the compiler from making type-based
+   assumptions about the buffers. */
+typedef unsigned long __attribute__((may_alias)) memcpy_word_t;
+
+#define WSIZE sizeof(unsigned long)
+#define WMASK (WSIZE - 1)
+
 void *memcpy(void *vdest, const void *vsrc, size_t bytes)
 {
-	const char *src = vsrc;
-	char *dest = vdest;
-	int i;
+	const u8 *src = vsrc;
+	u8 *dest = vdest;
+
+	/*
+	 * Word copies need both pointers to end up aligned at the same time. Otherwise fall
+	 * through to the byte loop, which handles the tail too.
+	 */
+	if (bytes >= 2 * WSIZE && !(((uintptr_t)dest ^ (uintptr_t)src) & WMASK)) {
+		while ((uintptr_t)dest & WMASK) {
+			*dest++ = *src++;
+			bytes--;
+		}
+
+		memcpy_word_t *d = (memcpy_word_t *)dest;
+		const memcpy_word_t *s = (const memcpy_word_t *)src;
+
+		for (; bytes >= 4 * WSIZE; bytes -= 4 * WSIZE, d += 4, s += 4) {
+			d[0] = s[0];
+			d[1] = s[1];
+			d[2] = s[2];
+			d[3] = s[3];
+		}
+		for (; bytes >= WSIZE; bytes -= WSIZE)
+			*d++ = *s++;
+
+		dest = (u8 *)d;
+		src = (const u8 *)s;
+	}
 
-	for (i = 0; i < (int)bytes; i++)
-		dest[i] = src[i];
+	while (bytes--)
+		*dest++ = *src++;
 
 	return vdest;
 }
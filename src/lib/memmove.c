@@ -1,19 +1,59 @@
 /* SPDX-License-Identifier: GPL-2.0-only */
 
 #include <string.h>
+#include <types.h>
+
+typedef unsigned long __attribute__((may_alias)) memmove_word_t;
+
+#define WSIZE sizeof(unsigned long)
+#define WMASK (WSIZE - 1)
+
+/* Word copies are only used when the buffers can be aligned together. Every word is loaded
+   before it is stored, so copying a word at a time in the same direction as the byte loops is
+   just as overlap-safe. */
+static inline bool memmove_use_words(const u8 *dest, const u8 *src, size_t count)
+{
+	return count >= 2 * WSIZE && !(((uintptr_t)dest ^ (uintptr_t)src) & WMASK);
+}
+
 void *memmove(void *vdest, const void *vsrc, size_t count)
 {
-	const char *src = vsrc;
-	char *dest = vdest;
+	const u8 *src = vsrc;
+	u8 *dest = vdest;
+
+	if (dest == src)
+		return vdest;
 
-	if (dest <= src) {
+	if (dest < src) {
+		if (memmove_use_words(dest, src, count)) {
+			while ((uintptr_t)dest & WMASK) {
+				*dest++ = *src++;
+				count--;
+			}
+			for (; count >= WSIZE; count -= WSIZE) {
+				*(memmove_word_t *)dest = *(const memmove_word_t *)src;
+				dest += WSIZE;
+				src += WSIZE;
+			}
+		}
 		while (count--)
 			*dest++ = *src++;
 	} else {
-		src  += count - 1;
-		dest += count - 1;
+		src += count;
+		dest += count;
+		if (memmove_use_words(dest, src, count)) {
+			while ((uintptr_t)dest & WMASK) {
+				*--dest = *--src;
+				count--;
+			}
+			for (; count >= WSIZE; count -= WSIZE) {
+				dest -= WSIZE;
+				src -= WSIZE;
+				*(memmove_word_t *)dest = *(const memmove_word_t *)src;
+			}
+		}
 		while (count--)
-			*dest-- = *src--;
+			*--dest = *--src;
 	}
 	return vdest;
 }
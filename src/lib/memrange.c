@@ -6,6 +6,184 @@
 #include <console/console.h>
 #include <memrange.h>
 
+/* Number of entries allocated at once when the free list runs empty. */
+#define RANGE_ENTRY_SLAB_SIZE 32
+
+/*
+ * Besides the sorted list used for iteration, the entries of a memranges are kept in an AVL
+ * tree ordered by address. Entries never overlap, so ordering by begin also orders by end.
+ * This lets every operation find the entries it affects in O(log n) instead of walking the
+ * list from the start. Each entry also caches the largest span in its subtree, which lets
+ * memranges_steal() skip subtrees that are too small for the request.
+ */
+static inline int tree_height(const struct range_entry *r)
+{
+	return r ? r->height : 0;
+}
+
+static inline resource_t tree_max_span(const struct range_entry *r)
+{
+	return r ? r->max_span : 0;
+}
+
+static void tree_update(struct range_entry *r)
+{
+	r->height = MAX(tree_height(r->left), tree_height(r->right)) + 1;
+	r->max_span = MAX(r->end - r->begin,
+			  MAX(tree_max_span(r->left), tree_max_span(r->right)));
+}
+
+static struct range_entry *tree_rotate_left(struct range_entry *r)
+{
+	struct range_entry *right = r->right;
+
+	r->right = right->left;
+	right->left = r;
+	tree_update(r);
+	tree_update(right);
+	return right;
+}
+
+static struct range_entry *tree_rotate_right(struct range_entry *r)
+{
+	struct range_entry *left = r->left;
+
+	r->left = left->right;
+	left->right = r;
+	tree_update(r);
+	tree_update(left);
+	return left;
+}
+
+static struct range_entry *tree_balance(struct range_entry *r)
+{
+	int diff;
+
+	tree_update(r);
+	diff = tree_height(r->left) - tree_height(r->right);
+
+	if (diff > 1) {
+		if (tree_height(r->left->left) < tree_height(r->left->right))
+			r->left = tree_rotate_left(r->left);
+		return tree_rotate_right(r);
+	}
+
+	if (diff < -1) {
+		if (tree_height(r->right->right) < tree_height(r->right->left))
+			r->right = tree_rotate_right(r->right);
+		return tree_rotate_left(r);
+	}
+
+	return r;
+}
+
+static struct range_entry *tree_insert(struct range_entry *root, struct range_entry *r)
+{
+	if (root == NULL) {
+		r->left = NULL;
+		r->right = NULL;
+		tree_update(r);
+		return r;
+	}
+
+	if (r->begin < root->begin)
+		root->left = tree_insert(root->left, r);
+	else
+		root->right = tree_insert(root->right, r);
+
+	return tree_balance(root);
+}
+
+static struct range_entry *tree_remove_min(struct range_entry *root,
+					   struct range_entry **min)
+{
+	if (root->left == NULL) {
+		*min = root;
+		return root->right;
+	}
+
+	root->left = tree_remove_min(root->left, min);
+	return tree_balance(root);
+}
+
+static struct range_entry *tree_remove(struct range_entry *root,
+				       const struct range_entry *r)
+{
+	struct range_entry *min;
+
+	if (root == NULL)
+		return NULL;
+
+	if (r->begin < root->begin) {
+		root->left = tree_remove(root->left, r);
+	} else if (r->begin > root->begin) {
+		root->right = tree_remove(root->right, r);
+	} else {
+		if (root->right == NULL)
+			return root->left;
+		root->right = tree_remove_min(root->right, &min);
+		min->left = root->left;
+		min->right = root->right;
+		root = min;
+	}
+
+	return tree_balance(root);
+}
+
+/* Refresh the cached spans on the path to an entry after its begin or end changed. Entries
+ * never move past their neighbors, so the shape of the tree stays valid. */
+static void tree_refresh(struct range_entry *root, const struct range_entry *r)
+{
+	if (root != r)
+		tree_refresh(r->begin < root->begin ? root->left : root->right, r);
+	tree_update(root);
+}
+
+/* Build a balanced tree out of the next |count| entries of the sorted list at |*list|. */
+static struct range_entry *tree_build(struct range_entry **list, size_t count)
+{
+	struct range_entry *left, *root;
+
+	if (count == 0)
+		return NULL;
+
+	left = tree_build(list, count / 2);
+	root = *list;
+	*list = root->next;
+	root->left = left;
+	root->right = tree_build(list, count - count / 2 - 1);
+	tree_update(root);
+
+	return root;
+}
+
+/* Return the last entry that ends before addr, or NULL if there is none. */
+static struct range_entry *tree_find_before(const struct memranges *ranges,
+					    resource_t addr)
+{
+	struct range_entry *r = ranges->root;
+	struct range_entry *found = NULL;
+
+	while (r != NULL) {
+		if (r->end < addr) {
+			found = r;
+			r = r->right;
+		} else {
+			r = r->left;
+		}
+	}
+
+	return found;
+}
+
+/* Return the link pointing to the first entry that doesn't end before addr. */
+static struct range_entry **range_list_find(struct memranges *ranges, resource_t addr)
+{
+	struct range_entry *prev = tree_find_before(ranges, addr);
+
+	return prev ? &prev->next : &ranges->entries;
+}
+
 static inline void range_entry_link(struct range_entry **prev_ptr,
 				    struct range_entry *r)
 {
@@ -24,12 +202,24 @@ static inline void range_entry_unlink_and_free(struct memranges *ranges,
 					       struct range_entry **prev_ptr,
 					       struct range_entry *r)
 {
+	ranges->root = tree_remove(ranges->root, r);
 	range_entry_unlink(prev_ptr, r);
 	range_entry_link(&ranges->free_list, r);
 }
 
 static struct range_entry *alloc_range(struct memranges *ranges)
 {
+	if (ranges->free_list == NULL && ENV_PAYLOAD_LOADER) {
+		struct range_entry *slab;
+		size_t i;
+
+		/* Allocate a batch of entries at once instead of one per insert. */
+		slab = malloc(RANGE_ENTRY_SLAB_SIZE * sizeof(*slab));
+		if (slab == NULL)
+			return NULL;
+		for (i = 0; i < RANGE_ENTRY_SLAB_SIZE; i++)
+			range_entry_link(&ranges->free_list, &slab[i]);
+	}
 	if (ranges->free_list != NULL) {
 		struct range_entry *r;
 
@@ -37,14 +227,13 @@ static struct range_entry *alloc_range(struct memranges *ranges)
 		range_entry_unlink(&ranges->free_list, r);
 		return r;
 	}
-	if (ENV_PAYLOAD_LOADER)
-		return malloc(sizeof(struct range_entry));
 	return NULL;
 }
 
+/* Add a new entry to the list only. The caller has to take care of the tree. */
 static inline struct range_entry *
-range_list_add(struct memranges *ranges, struct range_entry **prev_ptr,
-	       resource_t begin, resource_t end, unsigned long tag)
+range_list_link_new(struct memranges *ranges, struct range_entry **prev_ptr,
+		    resource_t begin, resource_t end, unsigned long tag)
 {
 	struct range_entry *new_entry;
 
@@ -61,33 +250,44 @@ range_list_add(struct memranges *ranges, struct range_entry **prev_ptr,
 	return new_entry;
 }
 
+static inline struct range_entry *
+range_list_add(struct memranges *ranges, struct range_entry **prev_ptr,
+	       resource_t begin, resource_t end, unsigned long tag)
+{
+	struct range_entry *new_entry;
+
+	new_entry = range_list_link_new(ranges, prev_ptr, begin, end, tag);
+	if (new_entry != NULL)
+		ranges->root = tree_insert(ranges->root, new_entry);
+
+	return new_entry;
+}
+
+/* Merge r with the entry following it if they touch and have the same tag. */
+static bool merge_with_next(struct memranges *ranges, struct range_entry *r)
+{
+	struct range_entry *next = r->next;
+
+	if (next == NULL || r->end + 1 < next->begin || r->tag != next->tag)
+		return false;
+
+	range_entry_unlink_and_free(ranges, &r->next, next);
+	r->end = next->end;
+	tree_refresh(ranges->root, r);
+
+	return true;
+}
+
 static void merge_neighbor_entries(struct memranges *ranges)
 {
 	struct range_entry *cur;
-	struct range_entry *prev;
 
-	prev = NULL;
-	/* Merge all neighbors and delete/free the leftover entry. */
+	/* Merge all neighbors and delete/free the leftover entries. */
 	for (cur = ranges->entries; cur != NULL; cur = cur->next) {
-		/* First entry. Just set prev. */
-		if (prev == NULL) {
-			prev = cur;
-			continue;
-		}
-
-		/* If the previous entry merges with the current update the
-		 * previous entry to cover full range and delete current from
-		 * the list. */
-		if (prev->end + 1 >= cur->begin && prev->tag == cur->tag) {
-			prev->end = cur->end;
-			range_entry_unlink_and_free(ranges, &prev->next, cur);
-			/* Set cur to prev so cur->next is valid since cur
-			 * was just unlinked and free. */
-			cur = prev;
-			continue;
-		}
-
-		prev = cur;
+		/* Keep merging into the current entry until its next neighbor
+		 * doesn't match any more. */
+		while (merge_with_next(ranges, cur))
+			;
 	}
 }
 
@@ -99,8 +299,9 @@ static void remove_memranges(struct memranges *ranges,
 	struct range_entry *next;
 	struct range_entry **prev_ptr;
 
-	prev_ptr = &ranges->entries;
-	for (cur = ranges->entries; cur != NULL; cur = next) {
+	/* Entries ending before the removal range aren't affected. */
+	prev_ptr = range_list_find(ranges, begin);
+	for (cur = *prev_ptr; cur != NULL; cur = next) {
 		resource_t tmp_end;
 
 		/* Cache the next value to handle unlinks. */
@@ -144,6 +345,7 @@ static void remove_memranges(struct memranges *ranges,
 			range_list_add(ranges, &cur->next, end + 1, cur->end,
 				       cur->tag);
 			cur->end = begin - 1;
+			tree_refresh(ranges->root, cur);
 			break;
 		}
 
@@ -154,6 +356,8 @@ static void remove_memranges(struct memranges *ranges,
 		/* Removal at end. */
 		if (tmp_end == cur->end)
 			cur->end = begin - 1;
+
+		tree_refresh(ranges->root, cur);
 	}
 }
 
@@ -161,10 +365,7 @@ static void merge_add_memranges(struct memranges *ranges,
 				resource_t begin, resource_t end,
 				unsigned long tag)
 {
-	struct range_entry *cur;
-	struct range_entry **prev_ptr;
-
-	prev_ptr = &ranges->entries;
+	struct range_entry *prev, *new_entry;
 
 	/* Remove all existing entries covered by the range. */
 	remove_memranges(ranges, begin, end, -1);
@@ -172,23 +373,16 @@ static void merge_add_memranges(struct memranges *ranges,
 	/* Find the entry to place the new entry after. Since
 	 * remove_memranges() was called above there is a guaranteed
 	 * spot for this new entry. */
-	for (cur = ranges->entries; cur != NULL; cur = cur->next) {
-		/* Found insertion spot before current entry. */
-		if (end < cur->begin)
-			break;
-
-		/* Keep track of previous entry to insert new entry after it. */
-		prev_ptr = &cur->next;
-
-		/* The new entry starts after this one. */
-		if (begin > cur->end)
-			continue;
-
-	}
+	prev = tree_find_before(ranges, begin);
 
 	/* Add new entry and merge with neighbors. */
-	range_list_add(ranges, prev_ptr, begin, end, tag);
-	merge_neighbor_entries(ranges);
+	new_entry = range_list_add(ranges, prev ? &prev->next : &ranges->entries,
+				   begin, end, tag);
+	if (new_entry == NULL)
+		return;
+	merge_with_next(ranges, new_entry);
+	if (prev != NULL)
+		merge_with_next(ranges, prev);
 }
 
 void memranges_update_tag(struct memranges *ranges, unsigned long old_tag,
@@ -239,6 +433,70 @@ void memranges_insert(struct memranges *ranges,
 	do_action(ranges, base, size, tag, merge_add_memranges);
 }
 
+/* Append sorted, non-overlapping entries to an empty memranges and build the tree in one
+ * pass. Returns false without changing anything if the entries don't qualify. */
+static bool memranges_build_sorted(struct memranges *ranges,
+				   const struct range_entry *entries, size_t count)
+{
+	const resource_t align = POWER_OF_2(ranges->align);
+	struct range_entry **prev_ptr = &ranges->entries;
+	struct range_entry *prev = NULL, *list;
+	resource_t begin, end, last_end = 0;
+	size_t i, n = 0;
+
+	if (!memranges_is_empty(ranges))
+		return false;
+
+	/* Same rounding as do_action(). */
+	for (i = 0; i < count; i++) {
+		if (range_entry_size(&entries[i]) == 0)
+			continue;
+		begin = ALIGN_DOWN(entries[i].begin, align);
+		end = ALIGN_UP(entries[i].end + 1, align) - 1;
+		if (n > 0 && begin <= last_end)
+			return false;
+		last_end = end;
+		n++;
+	}
+
+	n = 0;
+	for (i = 0; i < count; i++) {
+		if (range_entry_size(&entries[i]) == 0)
+			continue;
+		begin = ALIGN_DOWN(entries[i].begin, align);
+		end = ALIGN_UP(entries[i].end + 1, align) - 1;
+
+		if (prev != NULL && prev->end + 1 >= begin && prev->tag == entries[i].tag) {
+			prev->end = end;
+			continue;
+		}
+
+		prev = range_list_link_new(ranges, prev_ptr, begin, end, entries[i].tag);
+		if (prev == NULL)
+			break;
+		prev_ptr = &prev->next;
+		n++;
+	}
+
+	list = ranges->entries;
+	ranges->root = tree_build(&list, n);
+
+	return true;
+}
+
+void memranges_insert_bulk(struct memranges *ranges,
+			   const struct range_entry *entries, size_t count)
+{
+	size_t i;
+
+	if (memranges_build_sorted(ranges, entries, count))
+		return;
+
+	for (i = 0; i < count; i++)
+		memranges_insert(ranges, range_entry_base(&entries[i]),
+				 range_entry_size(&entries[i]), range_entry_tag(&entries[i]));
+}
+
 struct collect_context {
 	struct memranges *ranges;
 	unsigned long tag;
@@ -287,6 +545,7 @@ void memranges_init_empty_with_alignment(struct memranges *ranges,
 	size_t i;
 
 	ranges->entries = NULL;
+	ranges->root = NULL;
 	ranges->free_list = NULL;
 	ranges->align = align;
 
@@ -305,24 +564,36 @@ void memranges_init_with_alignment(struct memranges *ranges,
 /* Clone a memrange. The new memrange has the same entries as the old one. */
 void memranges_clone(struct memranges *newranges, struct memranges *oldranges)
 {
-	struct range_entry *r, *cur;
+	struct range_entry *r, *cur, *list;
 	struct range_entry **prev_ptr;
+	size_t count = 0;
 
 	memranges_init_empty_with_alignment(newranges, NULL, 0, oldranges->align);
 
 	prev_ptr = &newranges->entries;
 	memranges_each_entry(r, oldranges) {
-		cur = range_list_add(newranges, prev_ptr, r->begin, r->end,
-				     r->tag);
+		cur = range_list_link_new(newranges, prev_ptr, r->begin, r->end,
+					  r->tag);
+		if (cur == NULL)
+			break;
 		prev_ptr = &cur->next;
+		count++;
 	}
+
+	list = newranges->entries;
+	newranges->root = tree_build(&list, count);
 }
 
 void memranges_teardown(struct memranges *ranges)
 {
+	/* The whole tree goes away, so there's no need to remove entries
+	 * from it one by one. */
+	ranges->root = NULL;
 	while (ranges->entries != NULL) {
-		range_entry_unlink_and_free(ranges, &ranges->entries,
-					    ranges->entries);
+		struct range_entry *r = ranges->entries;
+
+		range_entry_unlink(&ranges->entries, r);
+		range_entry_link(&ranges->free_list, r);
 	}
 }
 
@@ -376,44 +647,101 @@ struct range_entry *memranges_next_entry(struct memranges *ranges,
 	return r->next;
 }
 
-/* Find a range entry that satisfies the given constraints to fit a hole that matches the
- * required alignment, is big enough, does not exceed the limit and has a matching tag. */
-static const struct range_entry *
-memranges_find_entry(struct memranges *ranges, resource_t limit, resource_t size,
-		     unsigned char align, unsigned long tag, bool last)
+struct find_context {
+	resource_t limit;
+	resource_t size;
+	unsigned char align;
+	unsigned long tag;
+};
+
+static bool entry_fits(const struct range_entry *r, const struct find_context *ctx,
+		       resource_t *hole_end)
 {
-	const struct range_entry *r, *last_entry = NULL;
-	resource_t base, end;
+	resource_t base;
 
-	if (size == 0)
+	if (r->tag != ctx->tag)
+		return false;
+
+	base = ALIGN_UP(r->begin, POWER_OF_2(ctx->align));
+	*hole_end = base + ctx->size - 1;
+
+	return *hole_end <= r->end;
+}
+
+/* Return the first entry in the subtree that fits the hole, regardless of the limit. */
+static const struct range_entry *tree_find_first(const struct range_entry *r,
+						 const struct find_context *ctx)
+{
+	const struct range_entry *found;
+	resource_t hole_end;
+
+	if (r == NULL || r->max_span < ctx->size - 1)
 		return NULL;
 
-	memranges_each_entry(r, ranges) {
+	found = tree_find_first(r->left, ctx);
+	if (found != NULL)
+		return found;
 
-		if (r->tag != tag)
-			continue;
+	if (entry_fits(r, ctx, &hole_end))
+		return r;
 
-		base = ALIGN_UP(r->begin, POWER_OF_2(align));
-		end = base + size - 1;
+	return tree_find_first(r->right, ctx);
+}
 
-		if (end > r->end)
-			continue;
+/* Return the last entry in the subtree that fits the hole below the limit. */
+static const struct range_entry *tree_find_last(const struct range_entry *r,
+						const struct find_context *ctx)
+{
+	const struct range_entry *found;
+	resource_t hole_end;
 
-		/*
-		 * If end for the hole in the current range entry goes beyond the requested
-		 * limit, then none of the following ranges can satisfy this request because all
-		 * range entries are maintained in increasing order.
-		 */
-		if (end > limit)
-			break;
+	if (r == NULL || r->max_span < ctx->size - 1)
+		return NULL;
 
-		if (!last)
-			return r;
+	/* A hole can't end below the beginning of its entry. */
+	if (r->begin <= ctx->limit) {
+		found = tree_find_last(r->right, ctx);
+		if (found != NULL)
+			return found;
 
-		last_entry = r;
+		if (entry_fits(r, ctx, &hole_end) && hole_end <= ctx->limit)
+			return r;
 	}
 
-	return last_entry;
+	return tree_find_last(r->left, ctx);
+}
+
+/* Find a range entry that satisfies the given constraints to fit a hole that matches the
+ * required alignment, is big enough, does not exceed the limit and has a matching tag. */
+static const struct range_entry *
+memranges_find_entry(struct memranges *ranges, resource_t limit, resource_t size,
+		     unsigned char align, unsigned long tag, bool last)
+{
+	const struct find_context ctx = {
+		.limit = limit,
+		.size = size,
+		.align = align,
+		.tag = tag,
+	};
+	const struct range_entry *r;
+	resource_t hole_end;
+
+	if (size == 0)
+		return NULL;
+
+	if (last)
+		return tree_find_last(ranges->root, &ctx);
+
+	/*
+	 * If the hole in the first matching entry goes beyond the requested limit, then none
+	 * of the following entries can satisfy this request either, because all range entries
+	 * are maintained in increasing order.
+	 */
+	r = tree_find_first(ranges->root, &ctx);
+	if (r == NULL || !entry_fits(r, &ctx, &hole_end) || hole_end > limit)
+		return NULL;
+
+	return r;
 }
 
 bool memranges_steal(struct memranges *ranges, resource_t limit, resource_t size,
@@ -1,14 +1,42 @@
 /* SPDX-License-Identifier: GPL-2.0-only */
 
 #include <string.h>
+#include <types.h>
+
+typedef unsigned long __attribute__((may_alias)) memset_word_t;
+
+#define WSIZE sizeof(unsigned long)
+#define WMASK (WSIZE - 1)
 
 void *memset(void *s, int c, size_t n)
 {
-	int i;
-	char *ss = (char *) s;
+	u8 *ss = (u8 *)s;
+
+	if (n >= 2 * WSIZE) {
+		/* Replicate the fill byte into every byte of a word. */
+		const unsigned long w = (unsigned long)(u8)c * (~0UL / 0xff);
+		memset_word_t *ws;
+
+		while ((uintptr_t)ss & WMASK) {
+			*ss++ = c;
+			n--;
+		}
+
+		ws = (memset_word_t *)ss;
+		for (; n >= 4 * WSIZE; n -= 4 * WSIZE, ws += 4) {
+			ws[0] = w;
+			ws[1] = w;
+			ws[2] = w;
+			ws[3] = w;
+		}
+		for (; n >= WSIZE; n -= WSIZE)
+			*ws++ = w;
+
+		ss = (u8 *)ws;
+	}
 
-	for (i = 0; i < (int)n; i++)
-		ss[i] = c;
+	while (n--)
+		*ss++ = c;
 
 	return s;
 }
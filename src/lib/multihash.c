@@ -0,0 +1,51 @@
+/* SPDX-License-Identifier: GPL-2.0-only */
+
+#include <commonlib/bsd/helpers.h>
+#include <multihash.h>
+
+/* Small enough to stay in the L1 cache between the algorithms. */
+#define MULTIHASH_CHUNK_SIZE (4 * KiB)
+
+vb2_error_t multihash_calculate(bool allow_hwcrypto, const void *buf, uint32_t size,
+				struct vb2_hash *hashes, size_t count)
+{
+	struct vb2_digest_context dc[MULTIHASH_MAX_DIGESTS];
+	const uint8_t *p = buf;
+	vb2_error_t rv;
+	size_t i;
+
+	if (count == 0 || count > ARRAY_SIZE(dc))
+		return VB2_ERROR_UNKNOWN;
+
+	for (i = 0; i < count; i++) {
+		rv = vb2_digest_init(&dc[i], allow_hwcrypto, hashes[i].algo, size);
+		if (rv)
+			return rv;
+		if (dc[i].using_hwcrypto)
+			allow_hwcrypto = false;
+	}
+
+	while (size) {
+		/* A single digest doesn't need to be split up. */
+		const uint32_t chunk = count > 1 ? MIN(size, MULTIHASH_CHUNK_SIZE) : size;
+
+		for (i = 0; i < count; i++) {
+			rv = vb2_digest_extend(&dc[i], p, chunk);
+			if (rv)
+				return rv;
+		}
+
+		p += chunk;
+		size -= chunk;
+	}
+
+	for (i = 0; i < count; i++) {
+		const size_t digest_size = vb2_digest_size(hashes[i].algo);
+
+		rv = vb2_digest_finalize(&dc[i], hashes[i].raw, digest_size);
+		if (rv)
+			return rv;
+	}
+
+	return VB2_SUCCESS;
+}
@@ -149,6 +149,9 @@ void payload_load(void)
 	if (prog_locate_hook(payload))
 		goto out;
 
+	if (selfload_pipelined(payload, BM_MEM_RAM))
+		goto out;
+
 	payload->cbfs_type = CBFS_TYPE_QUERY;
 	mapping = cbfs_type_map(prog_name(payload), NULL, &payload->cbfs_type);
 
@@ -1,6 +1,7 @@
 /* SPDX-License-Identifier: GPL-2.0-only */
 
 #include <arch/cache.h>
+#include <console/async.h>
 #include <console/console.h>
 #include <halt.h>
 #include <reset.h>
@@ -8,6 +9,7 @@
 __noreturn void board_reset(void)
 {
 	printk(BIOS_INFO, "%s() called!\n", __func__);
+	console_async_flush();
 	dcache_clean_all();
 	do_board_reset();
 	halt();
@@ -42,7 +42,8 @@ int rmodule_parse(void *ptr, struct rmodule *module)
 	/* Sanity check the raw data. */
 	if (rhdr->magic != RMODULE_MAGIC)
 		return -1;
-	if (rhdr->version != RMODULE_VERSION_1)
+	if (rhdr->version != RMODULE_VERSION_1 &&
+	    rhdr->version != RMODULE_VERSION_2)
 		return -1;
 
 	/* Indicate the module hasn't been loaded yet. */
@@ -101,14 +102,10 @@ static void rmodule_clear_bss(struct rmodule *module)
 	memset(begin, 0, size);
 }
 
-static inline size_t rmodule_number_relocations(const struct rmodule *module)
+static inline size_t rmodule_relocations_size(const struct rmodule *module)
 {
-	size_t r;
-
-	r = module->header->relocations_end_offset;
-	r -= module->header->relocations_begin_offset;
-	r /= sizeof(uintptr_t);
-	return r;
+	return module->header->relocations_end_offset -
+	       module->header->relocations_begin_offset;
 }
 
 static void rmodule_copy_payload(const struct rmodule *module)
@@ -126,36 +123,106 @@ static void rmodule_copy_payload(const struct rmodule *module)
 	memcpy(module->location, module->payload, module->payload_size);
 }
 
+static inline void rmodule_adjust(char *base, uintptr_t reloc, uintptr_t adjustment)
+{
+	uintptr_t *adjust_loc = (uintptr_t *)&base[reloc];
+
+	/* Compiled out unless PK_ADJ_LEVEL is changed above. */
+	if (PK_ADJ_LEVEL < BIOS_NEVER)
+		printk(PK_ADJ_LEVEL, "Adjusting %p: 0x%08lx -> 0x%08lx\n",
+		       adjust_loc, (unsigned long)*adjust_loc,
+		       (unsigned long)(*adjust_loc + adjustment));
+	*adjust_loc += adjustment;
+}
+
+static size_t rmodule_relocate_flat(const struct rmodule *module, char *base,
+				    uintptr_t adjustment)
+{
+	const size_t num_relocations = rmodule_relocations_size(module) / sizeof(uintptr_t);
+	const uintptr_t *reloc = module->relocations;
+
+	for (size_t i = 0; i < num_relocations; i++)
+		rmodule_adjust(base, reloc[i], adjustment);
+
+	return num_relocations;
+}
+
+/* Returns a pointer past the number, or NULL if it runs past |end|. */
+static const uint8_t *read_uleb128(const uint8_t *p, const uint8_t *end, uintptr_t *value)
+{
+	uintptr_t v = 0;
+	unsigned int shift = 0;
+
+	do {
+		if (p == end || shift >= 8 * sizeof(v))
+			return NULL;
+		v |= (uintptr_t)(*p & 0x7f) << shift;
+		shift += 7;
+	} while (*p++ & 0x80);
+
+	*value = v;
+	return p;
+}
+
+/* Returns the number of relocations, or -1 if the table is malformed. */
+static ssize_t rmodule_relocate_packed(const struct rmodule *module, char *base,
+				       uintptr_t adjustment)
+{
+	const uint8_t *p = module->relocations;
+	const uint8_t *const end = p + rmodule_relocations_size(module);
+	const uintptr_t link_start = module->header->module_link_start_address;
+	const uintptr_t max_offset = rmodule_memory_size(module) - sizeof(uintptr_t);
+	uintptr_t reloc = 0;
+	ssize_t num_relocations = 0;
+
+	while (p < end) {
+		uintptr_t entry, delta, count = 0;
+
+		p = read_uleb128(p, end, &entry);
+		if (p && (entry & RMODULE_RELOC_RUN))
+			p = read_uleb128(p, end, &count);
+		if (!p)
+			return -1;
+
+		delta = entry >> 1;
+		if (count && !delta)
+			return -1;
+		num_relocations += count + 1;
+		do {
+			reloc += delta;
+			if (reloc - link_start > max_offset)
+				return -1;
+			rmodule_adjust(base, reloc, adjustment);
+		} while (count--);
+	}
+
+	return num_relocations;
+}
+
 static int rmodule_relocate(const struct rmodule *module)
 {
-	size_t num_relocations;
-	const uintptr_t *reloc;
+	ssize_t num_relocations;
 	uintptr_t adjustment;
+	char *base;
 
 	/* Each relocation needs to be adjusted relative to the beginning of
 	 * the loaded program. */
-	adjustment = (uintptr_t)rmodule_load_addr(module, 0);
-
-	reloc = module->relocations;
-	num_relocations = rmodule_number_relocations(module);
+	base = rmodule_load_addr(module, 0);
+	adjustment = (uintptr_t)base;
 
-	printk(BIOS_DEBUG, "Processing %zu relocs. Offset value of 0x%08lx\n",
-	       num_relocations, (unsigned long)adjustment);
-
-	while (num_relocations > 0) {
-		uintptr_t *adjust_loc;
-
-		/* If the adjustment location is non-NULL adjust it. */
-		adjust_loc = rmodule_load_addr(module, *reloc);
-		printk(PK_ADJ_LEVEL, "Adjusting %p: 0x%08lx -> 0x%08lx\n",
-		       adjust_loc, (unsigned long) *adjust_loc,
-		       (unsigned long) (*adjust_loc + adjustment));
-		*adjust_loc += adjustment;
+	if (module->header->version == RMODULE_VERSION_1)
+		num_relocations = rmodule_relocate_flat(module, base, adjustment);
+	else
+		num_relocations = rmodule_relocate_packed(module, base, adjustment);
 
-		reloc++;
-		num_relocations--;
+	if (num_relocations < 0) {
+		printk(BIOS_ERR, "Malformed rmodule relocation table\n");
+		return -1;
 	}
 
+	printk(BIOS_DEBUG, "Processed %zd relocs. Offset value of 0x%08lx\n",
+	       num_relocations, (unsigned long)adjustment);
+
 	return 0;
 }
 
@@ -5,6 +5,7 @@
 #include <console/console.h>
 #include <string.h>
 #include <symbols.h>
+#include <thread.h>
 #include <cbfs.h>
 #include <lib.h>
 #include <bootmem.h>
@@ -89,7 +90,9 @@ static int load_one_segment(uint8_t *dest,
 	}
 	case CBFS_COMPRESS_NONE: {
 		printk(BIOS_DEBUG, "it's not compressed!\n");
-		memcpy(dest, src, len);
+		/* The pipelined loader reads uncompressed segments in place. */
+		if (src != dest)
+			memcpy(dest, src, len);
 		break;
 	}
 	default:
@@ -222,8 +225,10 @@ static int load_payload_segments(struct cbfs_payload_segment *cbfssegs, uintptr_
 		 * is always last. */
 		if (last_loadable_segment(seg))
 			flags = SEG_FINAL;
+		timestamp_add_now(TS_PAYLOAD_SEGMENT_START);
 		if (!load_one_segment(dest, src, filesz, memsz, compression, flags))
 			return -1;
+		timestamp_add_now(TS_PAYLOAD_SEGMENT_END);
 	}
 
 	return 1;
@@ -256,11 +261,206 @@ bool selfload_mapped(struct prog *payload, void *mapping,
 	return true;
 }
 
+/*
+ * Pipelined loading straight from the boot device. Instead of reading the whole payload into
+ * the cbfs_cache before the first segment is decompressed, every segment is read on its own
+ * and the read of the next one runs on a separate thread while the current one is being
+ * decompressed. Uncompressed segments are read directly to their load address. The compressed
+ * data of all segments goes to a single cbfs_cache buffer, so this never needs more memory
+ * than mapping the file would.
+ */
+#define PIPELINE_MAX_SEGMENTS 16
+
+struct segment_read {
+	const struct region_device *rdev;
+	void *buffer;
+	size_t offset;
+	size_t size;
+	struct thread_handle handle;
+	bool threaded;
+};
+
+static enum cb_err segment_read_now(void *arg)
+{
+	struct segment_read *r = arg;
+
+	if (r->size && rdev_readat(r->rdev, r->buffer, r->offset, r->size) != r->size)
+		return CB_ERR;
+	return CB_SUCCESS;
+}
+
+static void segment_read_start(struct segment_read *r)
+{
+	/* Without a free thread the read just happens in segment_read_finish(). */
+	r->threaded = ENV_SUPPORTS_COOP && r->size &&
+		      thread_run(&r->handle, segment_read_now, r) == 0;
+}
+
+static enum cb_err segment_read_finish(struct segment_read *r)
+{
+	if (ENV_SUPPORTS_COOP && r->threaded) {
+		r->threaded = false;
+		return thread_join(&r->handle);
+	}
+	return segment_read_now(r);
+}
+
+/* Read and decode the segment table. Returns the number of loadable segments, or -1 if the
+   payload can't be loaded this way. */
+static int read_segment_table(const struct region_device *rdev,
+			      struct cbfs_payload_segment *segs, enum bootmem_type dest_type,
+			      uintptr_t *entry)
+{
+	struct cbfs_payload_segment raw, *segment;
+	int i;
+
+	for (i = 0; i < PIPELINE_MAX_SEGMENTS; i++) {
+		segment = &segs[i];
+		if (rdev_readat(rdev, &raw, i * sizeof(raw), sizeof(raw)) != sizeof(raw))
+			return -1;
+		cbfs_decode_payload_segment(segment, &raw);
+
+		switch (segment->type) {
+		case PAYLOAD_SEGMENT_CODE:
+		case PAYLOAD_SEGMENT_DATA:
+			segment->len = MIN(segment->len, segment->mem_len);
+			break;
+		case PAYLOAD_SEGMENT_BSS:
+			segment->len = 0;
+			segment->compression = CBFS_COMPRESS_NONE;
+			break;
+		case PAYLOAD_SEGMENT_ENTRY:
+			*entry = segment->load_addr;
+			return i;
+		default:
+			printk(BIOS_EMERG, "Bad segment type %x\n", segment->type);
+			return -1;
+		}
+
+		if (dest_type != BM_MEM_INVALID &&
+		    !segment_targets_type((void *)(uintptr_t)segment->load_addr,
+					  segment->mem_len, dest_type))
+			return -1;
+	}
+
+	printk(BIOS_DEBUG, "Too many payload segments to pipeline\n");
+	return -1;
+}
+
+static void segment_read_setup(struct segment_read *r, const struct region_device *rdev,
+			       const struct cbfs_payload_segment *segment, uint8_t **staging)
+{
+	r->rdev = rdev;
+	r->offset = segment->offset;
+	r->size = segment->len;
+	if (segment->compression == CBFS_COMPRESS_NONE) {
+		r->buffer = (void *)(uintptr_t)segment->load_addr;
+	} else {
+		r->buffer = *staging;
+		*staging += segment->len;
+	}
+}
+
+static bool load_payload_segments_pipelined(const struct region_device *rdev,
+					    enum bootmem_type dest_type, uintptr_t *entry)
+{
+	struct cbfs_payload_segment segs[PIPELINE_MAX_SEGMENTS];
+	struct segment_read reads[2];
+	uint8_t *buffer = NULL, *staging;
+	size_t staging_size = 0;
+	bool ret = true;
+	int count, i, cur = 0;
+
+	count = read_segment_table(rdev, segs, dest_type, entry);
+	if (count < 0)
+		return false;
+
+	for (i = 0; i < count; i++)
+		if (segs[i].compression != CBFS_COMPRESS_NONE)
+			staging_size += segs[i].len;
+	if (staging_size) {
+		buffer = mem_pool_alloc(&cbfs_cache, staging_size);
+		if (!buffer)
+			return false;
+	}
+	staging = buffer;
+
+	if (count) {
+		segment_read_setup(&reads[cur], rdev, &segs[0], &staging);
+		segment_read_start(&reads[cur]);
+	}
+
+	for (i = 0; i < count; i++) {
+		const struct cbfs_payload_segment *segment = &segs[i];
+		uint8_t *dest = (uint8_t *)(uintptr_t)segment->load_addr;
+		enum cb_err err;
+
+		timestamp_add_now(TS_PAYLOAD_SEGMENT_START);
+		err = segment_read_finish(&reads[cur]);
+
+		/* Start reading the next segment before working on this one. */
+		if (i + 1 < count) {
+			segment_read_setup(&reads[!cur], rdev, &segs[i + 1], &staging);
+			segment_read_start(&reads[!cur]);
+		}
+
+		if (err != CB_SUCCESS) {
+			printk(BIOS_ERR, "Failed to read payload segment %d\n", i);
+			ret = false;
+			break;
+		}
+
+		if (!load_one_segment(dest, reads[cur].buffer, segment->len, segment->mem_len,
+				      segment->compression, i + 1 == count ? SEG_FINAL : 0)) {
+			ret = false;
+			break;
+		}
+		timestamp_add_now(TS_PAYLOAD_SEGMENT_END);
+		cur = !cur;
+	}
+
+	/* Don't free the buffer with a read into it still running. */
+	if (ENV_SUPPORTS_COOP && i + 1 < count && reads[!cur].threaded)
+		thread_join(&reads[!cur].handle);
+	if (buffer)
+		mem_pool_free(&cbfs_cache, buffer);
+
+	return ret;
+}
+
+bool selfload_pipelined(struct prog *payload, enum bootmem_type dest_type)
+{
+	struct region_device rdev;
+	union cbfs_mdata mdata;
+	uintptr_t entry = 0;
+
+	if (!CONFIG(PAYLOAD_PIPELINED_LOAD))
+		return false;
+
+	if (_cbfs_boot_lookup(prog_name(payload), false, &mdata, &rdev) != CB_SUCCESS)
+		return false;
+	if (be32toh(mdata.h.type) != CBFS_TYPE_SELF)
+		return false;
+
+	if (!load_payload_segments_pipelined(&rdev, dest_type, &entry))
+		return false;
+
+	printk(BIOS_SPEW, "Loaded segments\n");
+
+	payload->cbfs_type = CBFS_TYPE_SELF;
+	prog_set_entry(payload, (void *)entry, cbmem_find(CBMEM_ID_CBTABLE));
+
+	return true;
+}
+
 bool selfload_check(struct prog *payload, enum bootmem_type dest_type)
 {
 	if (prog_locate_hook(payload))
 		return false;
 
+	if (selfload_pipelined(payload, dest_type))
+		return true;
+
 	payload->cbfs_type = CBFS_TYPE_SELF;
 	void *mapping = cbfs_type_map(prog_name(payload), NULL, &payload->cbfs_type);
 	if (!mapping)
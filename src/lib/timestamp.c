@@ -8,12 +8,18 @@
 #include <timer.h>
 #include <timestamp.h>
 #include <smp/node.h>
+#include <string.h>
 
 #define MAX_TIMESTAMPS 192
+/* Continuation chunks are allocated once the table in CBMEM is full. */
+#define MAX_TIMESTAMP_CHUNKS 32
 
 /* This points to the active timestamp_table and can change within a stage
    as CBMEM comes available. */
 static struct timestamp_table *glob_ts_table;
+/* The chunk of the active table that new timestamps go to, and how many chunks it has. */
+static struct timestamp_table *glob_ts_tail;
+static unsigned int glob_ts_chunks;
 
 static void timestamp_cache_init(struct timestamp_table *ts_cache,
 				 uint64_t base)
@@ -41,19 +47,19 @@ static struct timestamp_table *timestamp_cache_get(void)
 	return ts_cache;
 }
 
-static struct timestamp_table *timestamp_alloc_cbmem_table(void)
+static struct timestamp_table *timestamp_alloc_cbmem_table(uint32_t id, size_t entries)
 {
 	struct timestamp_table *tst;
 
-	tst = cbmem_add(CBMEM_ID_TIMESTAMP,
+	tst = cbmem_add(id,
 			sizeof(struct timestamp_table) +
-			MAX_TIMESTAMPS * sizeof(struct timestamp_entry));
+			entries * sizeof(struct timestamp_entry));
 
 	if (!tst)
 		return NULL;
 
 	tst->base_time = 0;
-	tst->max_entries = MAX_TIMESTAMPS;
+	tst->max_entries = entries;
 	tst->num_entries = 0;
 
 	return tst;
@@ -74,19 +80,46 @@ static int timestamp_should_run(void)
 	return 1;
 }
 
-static struct timestamp_table *timestamp_table_get(void)
+static bool timestamp_is_bookkeeping(const struct timestamp_entry *tse)
 {
-	if (glob_ts_table)
-		return glob_ts_table;
+	return tse->entry_id == TS_TABLE_CONTINUATION || tse->entry_id == TS_TABLE_DROPPED;
+}
 
-	glob_ts_table = timestamp_cache_get();
+static struct timestamp_table *timestamp_next_chunk(const struct timestamp_table *ts)
+{
+	const struct timestamp_entry *last;
 
-	return glob_ts_table;
+	if (!ts->num_entries)
+		return NULL;
+
+	last = &ts->entries[ts->num_entries - 1];
+	if (last->entry_id != TS_TABLE_CONTINUATION)
+		return NULL;
+
+	return (void *)(uintptr_t)last->entry_stamp;
 }
 
 static void timestamp_table_set(struct timestamp_table *ts)
 {
 	glob_ts_table = ts;
+	glob_ts_tail = ts;
+	glob_ts_chunks = 0;
+
+	/* A table found in CBMEM may have grown in an earlier stage. */
+	while (glob_ts_tail && timestamp_next_chunk(glob_ts_tail)) {
+		glob_ts_tail = timestamp_next_chunk(glob_ts_tail);
+		glob_ts_chunks++;
+	}
+}
+
+static struct timestamp_table *timestamp_table_get(void)
+{
+	if (glob_ts_table)
+		return glob_ts_table;
+
+	timestamp_table_set(timestamp_cache_get());
+
+	return glob_ts_table;
 }
 
 static const char *timestamp_name(enum timestamp_id id)
@@ -101,20 +134,74 @@ static const char *timestamp_name(enum timestamp_id id)
 	return "Unknown timestamp ID";
 }
 
-static void timestamp_add_table_entry(struct timestamp_table *ts_table,
-				      enum timestamp_id id, int64_t ts_time)
+/*
+ * Continue a full table in a new chunk in CBMEM. The last slot of every table is kept free for
+ * the link to the next chunk, or for counting dropped timestamps if there can't be one.
+ */
+static struct timestamp_table *timestamp_grow(struct timestamp_table *tail)
+{
+	struct timestamp_table *chunk;
+	struct timestamp_entry *link;
+
+	if (!ENV_HAS_CBMEM || tail == timestamp_cache_get() ||
+	    tail->num_entries >= tail->max_entries || glob_ts_chunks >= MAX_TIMESTAMP_CHUNKS)
+		return NULL;
+
+	chunk = timestamp_alloc_cbmem_table(CBMEM_ID_TIMESTAMP_EXT + glob_ts_chunks,
+					    MAX_TIMESTAMPS);
+	if (!chunk)
+		return NULL;
+
+	chunk->base_time = tail->base_time;
+	chunk->tick_freq_mhz = tail->tick_freq_mhz;
+
+	link = &tail->entries[tail->num_entries++];
+	link->entry_id = TS_TABLE_CONTINUATION;
+	link->entry_stamp = (uintptr_t)chunk;
+
+	glob_ts_tail = chunk;
+	glob_ts_chunks++;
+
+	return chunk;
+}
+
+static void timestamp_count_dropped(struct timestamp_table *tail, uint64_t count)
 {
 	struct timestamp_entry *tse;
 
-	if (ts_table->num_entries >= ts_table->max_entries)
+	if (tail->num_entries) {
+		tse = &tail->entries[tail->num_entries - 1];
+		if (tse->entry_id == TS_TABLE_DROPPED) {
+			tse->entry_stamp += count;
+			return;
+		}
+	}
+
+	printk(BIOS_ERR, "Timestamp table full\n");
+	if (tail->num_entries >= tail->max_entries)
 		return;
 
-	tse = &ts_table->entries[ts_table->num_entries++];
+	tse = &tail->entries[tail->num_entries++];
+	tse->entry_id = TS_TABLE_DROPPED;
+	tse->entry_stamp = count;
+}
+
+static void timestamp_add_table_entry(enum timestamp_id id, int64_t ts_time)
+{
+	struct timestamp_table *tail = glob_ts_tail;
+	struct timestamp_entry *tse;
+
+	if (tail->num_entries + 1 >= tail->max_entries) {
+		tail = timestamp_grow(tail);
+		if (!tail) {
+			timestamp_count_dropped(glob_ts_tail, 1);
+			return;
+		}
+	}
+
+	tse = &tail->entries[tail->num_entries++];
 	tse->entry_id = id;
 	tse->entry_stamp = ts_time;
-
-	if (ts_table->num_entries == ts_table->max_entries)
-		printk(BIOS_ERR, "Timestamp table full\n");
 }
 
 void timestamp_add(enum timestamp_id id, int64_t ts_time)
@@ -132,7 +219,7 @@ void timestamp_add(enum timestamp_id id, int64_t ts_time)
 	}
 
 	ts_time -= ts_table->base_time;
-	timestamp_add_table_entry(ts_table, id, ts_time);
+	timestamp_add_table_entry(id, ts_time);
 
 	if (CONFIG(TIMESTAMPS_ON_CONSOLE))
 		printk(BIOS_INFO, "Timestamp - %s: %lld\n", timestamp_name(id), ts_time);
@@ -165,7 +252,6 @@ void timestamp_init(uint64_t base)
 
 static void timestamp_sync_cache_to_cbmem(struct timestamp_table *ts_cbmem_table)
 {
-	uint32_t i;
 	struct timestamp_table *ts_cache_table;
 
 	ts_cache_table = timestamp_table_get();
@@ -184,9 +270,6 @@ static void timestamp_sync_cache_to_cbmem(struct timestamp_table *ts_cbmem_table
 	 *    memlayout.ld (default on x86). The base_time from timestamp_init()
 	 *    (usually called from bootblock.c on most non-x86 boards) persists
 	 *    in that region until it gets synced to CBMEM in romstage.
-	 *    In ramstage, the BSS cache's base_time will be 0 until the second
-	 *    sync, which will adjust the timestamps in there to the correct
-	 *    base_time (from CBMEM) with the timestamp_add_table_entry() below.
 	 *
 	 * If you try to initialize timestamps before ramstage but don't define
 	 * a TIMESTAMP region, all operations will fail (safely), and coreboot
@@ -196,11 +279,11 @@ static void timestamp_sync_cache_to_cbmem(struct timestamp_table *ts_cbmem_table
 	/* Inherit cache base_time. */
 	ts_cbmem_table->base_time = ts_cache_table->base_time;
 
-	for (i = 0; i < ts_cache_table->num_entries; i++) {
-		struct timestamp_entry *tse = &ts_cache_table->entries[i];
-		timestamp_add_table_entry(ts_cbmem_table, tse->entry_id,
-					  tse->entry_stamp);
-	}
+	/* The CBMEM table is sized to take the whole cache, including a count of the
+	   timestamps that didn't fit into it. */
+	memcpy(ts_cbmem_table->entries, ts_cache_table->entries,
+	       ts_cache_table->num_entries * sizeof(ts_cache_table->entries[0]));
+	ts_cbmem_table->num_entries = ts_cache_table->num_entries;
 
 	/* Cache no longer required. */
 	ts_cache_table->num_entries = 0;
@@ -216,7 +299,14 @@ static void timestamp_reinit(int is_recovery)
 	/* First time into romstage we make a clean new table. For platforms that travel
 	   through this path on resume, ARCH_X86 S3, timestamps are also reset. */
 	if (ENV_CREATES_CBMEM) {
-		ts_cbmem_table = timestamp_alloc_cbmem_table();
+		struct timestamp_table *ts_cache_table = timestamp_table_get();
+		size_t entries = MAX_TIMESTAMPS;
+
+		/* Make sure the whole cache fits, with room for one more timestamp. The size
+		   mustn't depend on this boot, an S3 resume gets the old table back. */
+		if (ts_cache_table)
+			entries = MAX(entries, ts_cache_table->max_entries + 1);
+		ts_cbmem_table = timestamp_alloc_cbmem_table(CBMEM_ID_TIMESTAMP, entries);
 	} else {
 		/* Find existing table in cbmem. */
 		ts_cbmem_table = cbmem_find(CBMEM_ID_TIMESTAMP);
@@ -241,7 +331,7 @@ static void timestamp_reinit(int is_recovery)
 void timestamp_rescale_table(uint16_t N, uint16_t M)
 {
 	uint32_t i;
-	struct timestamp_table *ts_table;
+	struct timestamp_table *ts_table, *chunk;
 
 	if (!timestamp_should_run())
 		return;
@@ -257,12 +347,17 @@ void timestamp_rescale_table(uint16_t N, uint16_t M)
 		return;
 	}
 
-	ts_table->base_time /= M;
-	ts_table->base_time *= N;
-	for (i = 0; i < ts_table->num_entries; i++) {
-		struct timestamp_entry *tse = &ts_table->entries[i];
-		tse->entry_stamp /= M;
-		tse->entry_stamp *= N;
+	for (chunk = ts_table; chunk; chunk = timestamp_next_chunk(chunk)) {
+		chunk->base_time /= M;
+		chunk->base_time *= N;
+		for (i = 0; i < chunk->num_entries; i++) {
+			struct timestamp_entry *tse = &chunk->entries[i];
+
+			if (timestamp_is_bookkeeping(tse))
+				continue;
+			tse->entry_stamp /= M;
+			tse->entry_stamp *= N;
+		}
 	}
 }
 
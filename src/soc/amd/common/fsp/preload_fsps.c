@@ -1,11 +1,16 @@
 /* SPDX-License-Identifier: GPL-2.0-only */
 
+#include <acpi/acpi.h>
 #include <bootstate.h>
 #include <fsp/api.h>
 
 static void start_fsps_preload(void *unused)
 {
 	preload_fsps();
+
+	/* The DSDT is needed only once the ACPI tables get written, which S3 resume skips. */
+	if (!acpi_is_wakeup_s3())
+		preload_acpi_dsdt();
 }
 
 BOOT_STATE_INIT_ENTRY(BS_PRE_DEVICE, BS_ON_ENTRY, start_fsps_preload, NULL);
@@ -65,13 +65,13 @@ static void acpi_set_hybrid_cpu_apicid_order(void *unused)
 	}
 
 	if (perf_core_cnt > 1)
-		bubblesort(cpu_apic_info.apic_ids, perf_core_cnt, NUM_ASCENDING);
+		sort_int(cpu_apic_info.apic_ids, perf_core_cnt, NUM_ASCENDING);
 
 	for (i = perf_core_cnt; j < eff_core_cnt; i++, j++)
 		cpu_apic_info.apic_ids[i] = eff_apic_ids[j];
 
 	if (eff_core_cnt > 1)
-		bubblesort(&cpu_apic_info.apic_ids[perf_core_cnt], eff_core_cnt, NUM_ASCENDING);
+		sort_int(&cpu_apic_info.apic_ids[perf_core_cnt], eff_core_cnt, NUM_ASCENDING);
 
 	/* Populate total core count */
 	cpu_apic_info.total_cpu_cnt = perf_core_cnt + eff_core_cnt;
@@ -26,37 +26,39 @@
 /* Increase if necessary. Currently all x86 CPUs only have 2 SMP threads */
 #define MAX_THREAD 2
 
+static int cmp_cpu_apic_id(const void *a, const void *b)
+{
+	const struct device *x = *(const struct device *const *)a;
+	const struct device *y = *(const struct device *const *)b;
+
+	return (x->path.apic.apic_id > y->path.apic.apic_id) -
+	       (x->path.apic.apic_id < y->path.apic.apic_id);
+}
+
 unsigned long acpi_create_srat_lapics(unsigned long current)
 {
+	static struct device *cpus[CONFIG_MAX_CPUS];
 	struct device *cpu;
 	unsigned int num_cpus = 0;
-	int apic_ids[CONFIG_MAX_CPUS] = {};
 
 	unsigned int sort_start = 0;
 	for (unsigned int thread_id = 0; thread_id < MAX_THREAD; thread_id++) {
 		for (cpu = all_devices; cpu; cpu = cpu->next) {
 			if (!is_enabled_cpu(cpu))
 				continue;
-			if (num_cpus >= ARRAY_SIZE(apic_ids))
+			if (num_cpus >= ARRAY_SIZE(cpus))
 				break;
 			if (cpu->path.apic.thread_id != thread_id)
 				continue;
-			apic_ids[num_cpus++] = cpu->path.apic.apic_id;
+			cpus[num_cpus++] = cpu;
 		}
-		bubblesort(&apic_ids[sort_start], num_cpus - sort_start, NUM_ASCENDING);
+		/* Sort the devices themselves, so there's no need to look them up by APIC ID. */
+		sort(&cpus[sort_start], num_cpus - sort_start, sizeof(cpus[0]), cmp_cpu_apic_id);
 		sort_start = num_cpus;
 	}
 
 	for (unsigned int i = 0; i < num_cpus; i++) {
-		/* Match the sorted apic_ids to a struct device */
-		for (cpu = all_devices; cpu; cpu = cpu->next) {
-			if (!is_enabled_cpu(cpu))
-				continue;
-			if (cpu->path.apic.apic_id == apic_ids[i])
-				break;
-		}
-		if (!cpu)
-			continue;
+		cpu = cpus[i];
 
 		if (is_x2apic_mode()) {
 			printk(BIOS_DEBUG, "SRAT: x2apic cpu_index=%04x, node_id=%02x, apic_id=%08x\n",
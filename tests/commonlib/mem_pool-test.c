@@ -0,0 +1,177 @@
+/* SPDX-License-Identifier: GPL-2.0-only */
+
+#include <commonlib/helpers.h>
+#include <commonlib/mem_pool.h>
+#include <string.h>
+#include <tests/test.h>
+
+#define POOL_SIZE (64 * KiB)
+#define POOL_ALIGN 64
+
+static uint8_t pool_buf[POOL_SIZE] __aligned(POOL_ALIGN);
+
+static void test_mem_pool_stack(void **state)
+{
+	struct mem_pool mp = MEM_POOL_INIT(pool_buf, POOL_SIZE, POOL_ALIGN);
+	void *a, *b, *c;
+
+	a = mem_pool_alloc(&mp, 100);
+	b = mem_pool_alloc(&mp, 200);
+	assert_ptr_equal(pool_buf, a);
+	assert_ptr_equal(pool_buf + 128, b);
+	assert_int_equal(128 + 256, mem_pool_high_water(&mp));
+
+	/* Only the two most recent allocations can be freed, in reverse order. */
+	mem_pool_free(&mp, a);
+	c = mem_pool_alloc(&mp, 100);
+	assert_ptr_equal(pool_buf + 384, c);
+	mem_pool_free(&mp, c);
+	mem_pool_free(&mp, b);
+	assert_ptr_equal(b, mem_pool_alloc(&mp, 1));
+
+	assert_null(mem_pool_alloc(&mp, POOL_SIZE));
+	assert_int_equal(1, mem_pool_failures(&mp));
+	assert_int_equal(128 + 256 + 128, mem_pool_high_water(&mp));
+
+	mem_pool_reset(&mp);
+	assert_int_equal(0, mem_pool_high_water(&mp));
+	assert_int_equal(0, mem_pool_failures(&mp));
+	assert_ptr_equal(pool_buf, mem_pool_alloc(&mp, POOL_SIZE));
+}
+
+static void test_mem_pool_free_any_order(void **state)
+{
+	struct mem_pool mp = MEM_POOL_INIT_FREE_LIST(pool_buf, POOL_SIZE, POOL_ALIGN);
+	void *a, *b, *c, *d;
+
+	a = mem_pool_alloc(&mp, 1000);
+	b = mem_pool_alloc(&mp, 2000);
+	c = mem_pool_alloc(&mp, 3000);
+	assert_non_null(a);
+	assert_non_null(b);
+	assert_non_null(c);
+	assert_true(IS_ALIGNED((uintptr_t)a, POOL_ALIGN));
+	assert_true(IS_ALIGNED((uintptr_t)b, POOL_ALIGN));
+	assert_true(IS_ALIGNED((uintptr_t)c, POOL_ALIGN));
+	assert_true((uint8_t *)a + 1000 <= (uint8_t *)b);
+	assert_true((uint8_t *)b + 2000 <= (uint8_t *)c);
+
+	/* Like a preload that is freed before the mapping that was allocated first. */
+	mem_pool_free(&mp, a);
+	d = mem_pool_alloc(&mp, 500);
+	assert_ptr_equal(a, d);
+	mem_pool_free(&mp, d);
+
+	/* Free chunks on both sides merge with the middle one. */
+	mem_pool_free(&mp, c);
+	mem_pool_free(&mp, b);
+	assert_int_equal(0, mp.used);
+
+	/* Everything is one chunk again, which leaves room for one header. */
+	d = mem_pool_alloc(&mp, POOL_SIZE - POOL_ALIGN);
+	assert_ptr_equal(a, d);
+	mem_pool_free(&mp, d);
+	assert_int_equal(0, mem_pool_failures(&mp));
+}
+
+static void test_mem_pool_free_ignores_invalid(void **state)
+{
+	struct mem_pool mp = MEM_POOL_INIT_FREE_LIST(pool_buf, POOL_SIZE, POOL_ALIGN);
+	uint8_t outside[16];
+	void *a, *b;
+
+	/* Nothing allocated yet. */
+	mem_pool_free(&mp, pool_buf + POOL_ALIGN);
+
+	a = mem_pool_alloc(&mp, 100);
+	b = mem_pool_alloc(&mp, 100);
+	mem_pool_free(&mp, NULL);
+	mem_pool_free(&mp, outside);
+	mem_pool_free(&mp, pool_buf + POOL_SIZE);
+	mem_pool_free(&mp, (uint8_t *)b + 8);
+
+	mem_pool_free(&mp, a);
+	mem_pool_free(&mp, a);
+	mem_pool_free(&mp, b);
+	mem_pool_free(&mp, b);
+	assert_int_equal(0, mp.used);
+
+	assert_ptr_equal(a, mem_pool_alloc(&mp, POOL_SIZE - POOL_ALIGN));
+}
+
+static void test_mem_pool_statistics(void **state)
+{
+	struct mem_pool mp;
+	void *a, *b;
+
+	mem_pool_init_free_list(&mp, pool_buf, POOL_SIZE, POOL_ALIGN);
+
+	a = mem_pool_alloc(&mp, 3 * POOL_ALIGN);
+	b = mem_pool_alloc(&mp, 5 * POOL_ALIGN);
+	assert_int_equal(10 * POOL_ALIGN, mem_pool_high_water(&mp));
+	mem_pool_free(&mp, a);
+	mem_pool_free(&mp, b);
+	assert_int_equal(10 * POOL_ALIGN, mem_pool_high_water(&mp));
+
+	assert_null(mem_pool_alloc(&mp, POOL_SIZE));
+	assert_null(mem_pool_alloc(&mp, SIZE_MAX));
+	assert_int_equal(2, mem_pool_failures(&mp));
+
+	/* Too fragmented for a large allocation even though enough memory is free. */
+	a = mem_pool_alloc(&mp, POOL_SIZE / 2 - POOL_ALIGN);
+	b = mem_pool_alloc(&mp, POOL_SIZE / 4 - POOL_ALIGN);
+	assert_non_null(mem_pool_alloc(&mp, POOL_SIZE / 4 - POOL_ALIGN));
+	mem_pool_free(&mp, a);
+	assert_null(mem_pool_alloc(&mp, POOL_SIZE / 2 + POOL_ALIGN));
+	assert_int_equal(3, mem_pool_failures(&mp));
+	mem_pool_free(&mp, b);
+	assert_non_null(mem_pool_alloc(&mp, POOL_SIZE / 2 + POOL_ALIGN));
+	assert_int_equal(POOL_SIZE, mem_pool_high_water(&mp));
+}
+
+/* Random allocations and frees, checking that no two live allocations overlap. */
+static void test_mem_pool_random(void **state)
+{
+	struct mem_pool mp = MEM_POOL_INIT_FREE_LIST(pool_buf, POOL_SIZE, POOL_ALIGN);
+	struct {
+		uint8_t *p;
+		size_t size;
+	} live[32] = { 0 };
+	uint32_t rand_state = 0x2468ace1;
+
+	for (int round = 0; round < 10000; round++) {
+		rand_state = rand_state * 1103515245 + 12345;
+		const size_t i = (rand_state >> 16) % ARRAY_SIZE(live);
+
+		if (live[i].p) {
+			for (size_t j = 0; j < live[i].size; j++)
+				assert_int_equal((uint8_t)i, live[i].p[j]);
+			mem_pool_free(&mp, live[i].p);
+			live[i].p = NULL;
+			continue;
+		}
+
+		live[i].size = 1 + (rand_state >> 8) % (4 * KiB);
+		live[i].p = mem_pool_alloc(&mp, live[i].size);
+		if (live[i].p)
+			memset(live[i].p, i, live[i].size);
+	}
+
+	for (size_t i = 0; i < ARRAY_SIZE(live); i++)
+		mem_pool_free(&mp, live[i].p);
+	assert_int_equal(0, mp.used);
+	assert_non_null(mem_pool_alloc(&mp, POOL_SIZE - POOL_ALIGN));
+}
+
+int main(void)
+{
+	const struct CMUnitTest tests[] = {
+		cmocka_unit_test(test_mem_pool_stack),
+		cmocka_unit_test(test_mem_pool_free_any_order),
+		cmocka_unit_test(test_mem_pool_free_ignores_invalid),
+		cmocka_unit_test(test_mem_pool_statistics),
+		cmocka_unit_test(test_mem_pool_random),
+	};
+
+	return cb_run_group_tests(tests, NULL, NULL);
+}
@@ -0,0 +1,185 @@
+/* SPDX-License-Identifier: GPL-2.0-only */
+
+#include <commonlib/helpers.h>
+#include <commonlib/sort.h>
+#include <stdbool.h>
+#include <string.h>
+#include <tests/bench.h>
+#include <tests/test.h>
+
+#define MAX_ENTRIES 4096
+
+static const size_t counts[] = { 0, 1, 2, 3, 7, 64, 255, 1000, MAX_ENTRIES };
+
+enum pattern {
+	PATTERN_RANDOM,
+	PATTERN_SORTED,
+	PATTERN_REVERSED,
+	PATTERN_FEW_VALUES,
+};
+
+static int values[MAX_ENTRIES];
+
+static void fill_values(size_t count, enum pattern pattern)
+{
+	uint32_t rand_state = 0x13579bdf;
+
+	for (size_t i = 0; i < count; i++) {
+		rand_state = rand_state * 1103515245 + 12345;
+		switch (pattern) {
+		case PATTERN_RANDOM:
+			values[i] = (int)rand_state;
+			break;
+		case PATTERN_SORTED:
+			values[i] = i;
+			break;
+		case PATTERN_REVERSED:
+			values[i] = count - i;
+			break;
+		case PATTERN_FEW_VALUES:
+			values[i] = (rand_state >> 16) % 4 - 2;
+			break;
+		}
+	}
+}
+
+static unsigned int sum(const int *v, size_t count)
+{
+	unsigned int s = 0;
+
+	for (size_t i = 0; i < count; i++)
+		s += (unsigned int)v[i];
+	return s;
+}
+
+static void test_sort_int(void **state)
+{
+	for (size_t c = 0; c < ARRAY_SIZE(counts); c++) {
+		for (int pattern = PATTERN_RANDOM; pattern <= PATTERN_FEW_VALUES; pattern++) {
+			const size_t count = counts[c];
+			unsigned int s;
+
+			fill_values(count, pattern);
+			s = sum(values, count);
+
+			sort_int(values, count, NUM_ASCENDING);
+			for (size_t i = 1; i < count; i++)
+				assert_true(values[i - 1] <= values[i]);
+			assert_int_equal(s, sum(values, count));
+
+			sort_int(values, count, NUM_DESCENDING);
+			for (size_t i = 1; i < count; i++)
+				assert_true(values[i - 1] >= values[i]);
+			assert_int_equal(s, sum(values, count));
+		}
+	}
+}
+
+/* Elements that are neither 4 nor 8 bytes, sorted by key. */
+struct record {
+	uint16_t key;
+	uint8_t payload[9];
+} __packed;
+
+static int cmp_record(const void *a, const void *b)
+{
+	const struct record *x = a, *y = b;
+
+	return x->key - y->key;
+}
+
+static void test_sort_records(void **state)
+{
+	static struct record records[MAX_ENTRIES];
+	uint32_t rand_state = 0xdeadbeef;
+
+	for (size_t i = 0; i < ARRAY_SIZE(records); i++) {
+		rand_state = rand_state * 1103515245 + 12345;
+		records[i].key = rand_state >> 16;
+		memset(records[i].payload, records[i].key & 0xff, sizeof(records[i].payload));
+	}
+
+	sort(records, ARRAY_SIZE(records), sizeof(records[0]), cmp_record);
+
+	for (size_t i = 0; i < ARRAY_SIZE(records); i++) {
+		if (i)
+			assert_true(records[i - 1].key <= records[i].key);
+		/* The payload has to move along with its key. */
+		for (size_t j = 0; j < sizeof(records[i].payload); j++)
+			assert_int_equal(records[i].key & 0xff, records[i].payload[j]);
+	}
+}
+
+static int cmp_pointer(const void *a, const void *b)
+{
+	const uintptr_t x = (uintptr_t)*(void *const *)a, y = (uintptr_t)*(void *const *)b;
+
+	return (x > y) - (x < y);
+}
+
+static void test_sort_pointers(void **state)
+{
+	static void *pointers[MAX_ENTRIES];
+
+	fill_values(ARRAY_SIZE(pointers), PATTERN_RANDOM);
+	for (size_t i = 0; i < ARRAY_SIZE(pointers); i++)
+		pointers[i] = &values[(unsigned int)values[i] % ARRAY_SIZE(values)];
+
+	sort(pointers, ARRAY_SIZE(pointers), sizeof(pointers[0]), cmp_pointer);
+
+	for (size_t i = 1; i < ARRAY_SIZE(pointers); i++)
+		assert_true((uintptr_t)pointers[i - 1] <= (uintptr_t)pointers[i]);
+}
+
+/* The bubble sort this replaced, to compare against. */
+static void bubblesort_ascending(int *v, size_t num_entries)
+{
+	for (size_t j = 0; j + 1 < num_entries; j++) {
+		bool swapped = false;
+
+		for (size_t i = 0; i < num_entries - j - 1; i++) {
+			if (v[i] > v[i + 1]) {
+				SWAP(v[i], v[i + 1]);
+				swapped = true;
+			}
+		}
+		if (!swapped)
+			break;
+	}
+}
+
+static void bench_sort_int(void **state)
+{
+	static int copy[MAX_ENTRIES];
+
+	for (size_t count = 64; count <= MAX_ENTRIES; count *= 4) {
+		uint64_t start, sort_ns, bubble_ns;
+
+		fill_values(count, PATTERN_RANDOM);
+		memcpy(copy, values, count * sizeof(values[0]));
+
+		start = bench_time_ns();
+		sort_int(values, count, NUM_ASCENDING);
+		sort_ns = bench_time_ns() - start;
+
+		start = bench_time_ns();
+		bubblesort_ascending(copy, count);
+		bubble_ns = bench_time_ns() - start;
+
+		assert_memory_equal(values, copy, count * sizeof(values[0]));
+		print_message("%4zu entries: %8llu ns (bubble sort %10llu ns)\n", count,
+			      (unsigned long long)sort_ns, (unsigned long long)bubble_ns);
+	}
+}
+
+int main(void)
+{
+	const struct CMUnitTest tests[] = {
+		cmocka_unit_test(test_sort_int),
+		cmocka_unit_test(test_sort_records),
+		cmocka_unit_test(test_sort_pointers),
+		cmocka_unit_test(bench_sort_int),
+	};
+
+	return cb_run_group_tests(tests, NULL, NULL);
+}
@@ -0,0 +1,22 @@
+/* SPDX-License-Identifier: GPL-2.0-only */
+
+#ifndef _TESTS_BENCH_H
+#define _TESTS_BENCH_H
+
+#include <stdint.h>
+
+/*
+ * Helpers for tests that also report throughput numbers. They are implemented against the host
+ * libc, so tests using them need to add tests/helpers/bench.c to their syssrcs attribute.
+ */
+
+/* Returns a monotonic host timestamp in nanoseconds. */
+uint64_t bench_time_ns(void);
+
+/* Returns |count| events in |ns| nanoseconds scaled to events per second. */
+static inline uint64_t bench_per_second(uint64_t count, uint64_t ns)
+{
+	return ns ? count * 1000000000ULL / ns : 0;
+}
+
+#endif /* _TESTS_BENCH_H */
@@ -6,6 +6,7 @@
 #include <commonlib/bsd/cbfs_private.h>
 #include <commonlib/region.h>
 #include <string.h>
+#include <tests/bench.h>
 #include <tests/lib/cbfs_util.h>
 #include <tests/test.h>
 
@@ -20,6 +21,15 @@ static uintptr_t unaligned_cbfs_buffer_size = sizeof(aligned_cbfs_buffer) - 3;
 
 static u8 cbfs_mcache[TEST_MCACHE_SIZE] __aligned(CBFS_MCACHE_ALIGNMENT);
 
+/* Synthetic CBFS with many small files to exercise and measure mcache lookups. */
+#define MANY_FILES_COUNT 1000
+#define MANY_FILES_ROUNDS 100
+#define MANY_FILES_STRIDE ALIGN_UP(sizeof(struct cbfs_file) + FILENAME_SIZE, CBFS_ALIGNMENT)
+
+static u8 many_files_cbfs_buffer[MANY_FILES_COUNT * MANY_FILES_STRIDE] __aligned(CBFS_ALIGNMENT);
+static char many_files_names[MANY_FILES_COUNT][FILENAME_SIZE];
+static u8 mcache_copy[TEST_MCACHE_SIZE] __aligned(CBFS_MCACHE_ALIGNMENT);
+
 /* Add files to CBFS buffer. NULL in files list equals to one CBFS_ALIGNMENT of spacing. */
 static int create_cbfs(const struct cbfs_test_file *files[], const size_t nfiles, u8 *buffer,
 		       const size_t buffer_size)
@@ -935,6 +945,108 @@ static void test_cbfs_attributes_offset_uint32_max(void **state)
 	assert_null(mapping);
 }
 
+static void create_many_files_cbfs(void)
+{
+	const struct cbfs_file header = HEADER_INITIALIZER(CBFS_TYPE_RAW, 0, 0);
+
+	memset(many_files_cbfs_buffer, 0, sizeof(many_files_cbfs_buffer));
+	for (size_t i = 0; i < MANY_FILES_COUNT; i++) {
+		u8 *file = &many_files_cbfs_buffer[i * MANY_FILES_STRIDE];
+		char *name = many_files_names[i];
+
+		memcpy(name, "many/file-", 10);
+		name[10] = '0' + i / 1000 % 10;
+		name[11] = '0' + i / 100 % 10;
+		name[12] = '0' + i / 10 % 10;
+		name[13] = '0' + i % 10;
+		name[14] = '\0';
+
+		memcpy(file, &header, sizeof(header));
+		memcpy(file + sizeof(header), name, FILENAME_SIZE);
+	}
+
+	rdev_chain_mem(&cbd.rdev, many_files_cbfs_buffer, sizeof(many_files_cbfs_buffer));
+	cbd.mcache = cbfs_mcache;
+	cbd.mcache_size = TEST_MCACHE_SIZE;
+}
+
+static void check_many_files_lookup(const void *mcache, size_t mcache_size, size_t i)
+{
+	union cbfs_mdata mdata;
+	size_t data_offset;
+
+	assert_int_equal(CB_SUCCESS, __real_cbfs_mcache_lookup(mcache, mcache_size,
+							       many_files_names[i], &mdata,
+							       &data_offset));
+	assert_int_equal(i * MANY_FILES_STRIDE + sizeof(struct cbfs_file) + FILENAME_SIZE,
+			 data_offset);
+	assert_string_equal(many_files_names[i], mdata.h.filename);
+}
+
+/* Test that a copy of the mcache (as done when migrating it to CBMEM) can still be used. */
+static void test_cbfs_mcache_copy(void **state)
+{
+	union cbfs_mdata mdata;
+	size_t data_offset;
+
+	if (CONFIG(NO_CBFS_MCACHE))
+		skip();
+
+	create_many_files_cbfs();
+	assert_int_equal(CB_SUCCESS, cbfs_init_boot_device(&cbd, NULL));
+
+	const size_t real_size = cbfs_mcache_real_size(cbd.mcache, cbd.mcache_size);
+	assert_true(real_size < cbd.mcache_size);
+	memset(mcache_copy, 0xff, sizeof(mcache_copy));
+	cbfs_mcache_copy(mcache_copy, cbd.mcache, cbd.mcache_size);
+
+	for (size_t i = 0; i < MANY_FILES_COUNT; i++)
+		check_many_files_lookup(mcache_copy, real_size, i);
+	assert_int_equal(CB_CBFS_NOT_FOUND,
+			 __real_cbfs_mcache_lookup(mcache_copy, real_size, "many/file-x",
+						   &mdata, &data_offset));
+}
+
+/* Test that lookups of files not fitting the mcache report a full cache. */
+static void test_cbfs_mcache_full(void **state)
+{
+	union cbfs_mdata mdata;
+	size_t data_offset;
+
+	if (CONFIG(NO_CBFS_MCACHE))
+		skip();
+
+	create_many_files_cbfs();
+	cbd.mcache_size = MANY_FILES_COUNT / 2 * (sizeof(struct cbfs_file) + FILENAME_SIZE);
+	assert_int_equal(CB_CBFS_CACHE_FULL, cbfs_init_boot_device(&cbd, NULL));
+
+	check_many_files_lookup(cbd.mcache, cbd.mcache_size, 0);
+	assert_int_equal(CB_CBFS_CACHE_FULL,
+			 __real_cbfs_mcache_lookup(cbd.mcache, cbd.mcache_size,
+						   many_files_names[MANY_FILES_COUNT - 1],
+						   &mdata, &data_offset));
+}
+
+/* Measure mcache lookup throughput for a large CBFS, with or without CBFS_MCACHE_INDEX. */
+static void test_cbfs_mcache_lookup_speed(void **state)
+{
+	if (CONFIG(NO_CBFS_MCACHE))
+		skip();
+
+	create_many_files_cbfs();
+	assert_int_equal(CB_SUCCESS, cbfs_init_boot_device(&cbd, NULL));
+
+	const uint64_t start = bench_time_ns();
+	for (size_t round = 0; round < MANY_FILES_ROUNDS; round++)
+		for (size_t i = 0; i < MANY_FILES_COUNT; i++)
+			check_many_files_lookup(cbd.mcache, cbd.mcache_size, i);
+	const uint64_t elapsed = bench_time_ns() - start;
+
+	print_message("mcache lookups in %d-file CBFS (index %s): %llu lookups/s\n",
+		      MANY_FILES_COUNT, CONFIG(CBFS_MCACHE_INDEX) ? "on" : "off",
+		      bench_per_second(MANY_FILES_ROUNDS * MANY_FILES_COUNT, elapsed));
+}
+
 #define CBFS_LOOKUP_NAME_SETUP_PRESTATE_COMMON_TEST(name, test_fn, setup_fn, prestate)         \
 	{                                                                                      \
 		(name), (test_fn), (setup_fn), teardown_test_cbfs, (prestate),                 \
@@ -1061,5 +1173,12 @@ int main(void)
 		CBFS_LOOKUP_TEST(test_cbfs_attributes_offset_uint32_max),
 	};
 
-	return cb_run_group_tests(cbfs_lookup_aligned_and_unaligned_tests, NULL, NULL);
+	const struct CMUnitTest cbfs_mcache_many_files_tests[] = {
+		cmocka_unit_test_teardown(test_cbfs_mcache_copy, teardown_test_cbfs),
+		cmocka_unit_test_teardown(test_cbfs_mcache_full, teardown_test_cbfs),
+		cmocka_unit_test_teardown(test_cbfs_mcache_lookup_speed, teardown_test_cbfs),
+	};
+
+	return cb_run_group_tests(cbfs_lookup_aligned_and_unaligned_tests, NULL, NULL)
+	       + cb_run_group_tests(cbfs_mcache_many_files_tests, NULL, NULL);
 }
@@ -3,6 +3,7 @@
 #include <stdlib.h>
 #include <types.h>
 #include <string.h>
+#include <tests/bench.h>
 #include <tests/test.h>
 #include <imd.h>
 #include <imd_private.h>
@@ -26,6 +27,18 @@
 
 #define INVALID_REGION_ID 0xC001
 
+/* A root as large as an imd allows, with room for the entries below it. */
+#define MANY_ROOT_SIZE LIMIT_ALIGN
+#define MANY_ENTRY_ALIGN sizeof(uint32_t)
+#define MANY_REGION_SIZE (3 * LIMIT_ALIGN)
+#define BENCH_LOOKUPS 100000
+
+/* Spread the ids, but keep them close enough for some to collide in a hash. */
+static uint32_t many_entry_id(size_t i)
+{
+	return 0x1000 + i * 0x101;
+}
+
 static uint32_t align_up_pow2(uint32_t x)
 {
 	return (1 << log2_ceil(x));
@@ -547,6 +560,115 @@ static void test_imd_entry_find(void **state)
 	free(base);
 }
 
+static void test_imd_entry_find_many(void **state)
+{
+	struct imd imd = {0};
+	struct imd_root *r;
+	size_t max, i, j;
+	void *base;
+
+	base = malloc(MANY_REGION_SIZE);
+	if (base == NULL)
+		fail_msg("Cannot allocate enough memory - fail test");
+	imd_handle_init(&imd, (void *)(MANY_REGION_SIZE + (uintptr_t)base));
+
+	assert_int_equal(0, imd_create_empty(&imd, MANY_ROOT_SIZE, MANY_ENTRY_ALIGN));
+	r = imd.lg.r;
+	max = max_entries(MANY_ROOT_SIZE);
+
+	/* Fill the root, which also goes past the number of entries a lookup table takes. */
+	for (i = 1; i < max; i++) {
+		assert_non_null(imd_entry_add(&imd, many_entry_id(i), MANY_ENTRY_ALIGN));
+		for (j = 1; j <= i; j++)
+			assert_ptr_equal(&r->entries[j],
+					 imd_entry_find(&imd, many_entry_id(j)));
+		assert_null(imd_entry_find(&imd, many_entry_id(i + 1)));
+	}
+	assert_null(imd_entry_add(&imd, INVALID_REGION_ID, MANY_ENTRY_ALIGN));
+
+	/* Remove entries until lookups go through a table again. */
+	for (i = max - 1; i > max / 2; i--) {
+		assert_int_equal(0, imd_entry_remove(&imd, &r->entries[i]));
+		assert_null(imd_entry_find(&imd, many_entry_id(i)));
+		assert_ptr_equal(&r->entries[i - 1],
+				 imd_entry_find(&imd, many_entry_id(i - 1)));
+	}
+
+	/* The first of duplicate ids is found, like with a scan. */
+	assert_non_null(imd_entry_add(&imd, many_entry_id(1), MANY_ENTRY_ALIGN));
+	assert_ptr_equal(&r->entries[1], imd_entry_find(&imd, many_entry_id(1)));
+
+	/* Entries are still found after recovering the imd with a new handle. */
+	memset(&imd, 0, sizeof(imd));
+	imd_handle_init(&imd, (void *)(MANY_REGION_SIZE + (uintptr_t)base));
+	assert_int_equal(0, imd_recover(&imd));
+	for (i = 1; i <= max / 2; i++)
+		assert_ptr_equal(&r->entries[i], imd_entry_find(&imd, many_entry_id(i)));
+	assert_null(imd_entry_find(&imd, INVALID_REGION_ID));
+
+	/* Entries added behind the handle's back, e.g. by another stage, are found too. */
+	r->entries[r->num_entries] = r->entries[r->num_entries - 1];
+	r->entries[r->num_entries].id = INVALID_REGION_ID;
+	r->num_entries++;
+	assert_ptr_equal(&r->entries[r->num_entries - 1],
+			 imd_entry_find(&imd, INVALID_REGION_ID));
+
+	free(base);
+}
+
+/* The scan imd_entry_find() used for every lookup, kept as a baseline. */
+static const struct imd_entry *scan_entry_find(const struct imd_root *r, uint32_t id)
+{
+	for (size_t i = 1; i < r->num_entries; i++) {
+		if (r->entries[i].id == id)
+			return &r->entries[i];
+	}
+
+	return NULL;
+}
+
+static void test_imd_entry_find_cost(void **state)
+{
+	const size_t counts[] = { 8, 32, 64, 128 };
+	const struct imd_entry *volatile e;
+	uint64_t start, find_ns, scan_ns;
+	struct imd imd;
+	void *base;
+
+	base = malloc(MANY_REGION_SIZE);
+	if (base == NULL)
+		fail_msg("Cannot allocate enough memory - fail test");
+
+	for (size_t c = 0; c < ARRAY_SIZE(counts); c++) {
+		const size_t count = counts[c];
+
+		memset(&imd, 0, sizeof(imd));
+		imd_handle_init(&imd, (void *)(MANY_REGION_SIZE + (uintptr_t)base));
+		assert_int_equal(0, imd_create_empty(&imd, MANY_ROOT_SIZE, MANY_ENTRY_ALIGN));
+		for (size_t i = 1; i < count; i++)
+			assert_non_null(imd_entry_add(&imd, many_entry_id(i),
+						      MANY_ENTRY_ALIGN));
+
+		/* Half of the lookups are for ids that aren't there yet. */
+		start = bench_time_ns();
+		for (size_t i = 0; i < BENCH_LOOKUPS; i++)
+			e = imd_entry_find(&imd, many_entry_id(i % (2 * count)));
+		find_ns = bench_time_ns() - start;
+
+		start = bench_time_ns();
+		for (size_t i = 0; i < BENCH_LOOKUPS; i++)
+			e = scan_entry_find(imd.lg.r, many_entry_id(i % (2 * count)));
+		scan_ns = bench_time_ns() - start;
+
+		(void)e;
+		print_message("%4zu entries: %4llu ns per lookup (scan %4llu ns)\n", count,
+			      (unsigned long long)(find_ns / BENCH_LOOKUPS),
+			      (unsigned long long)(scan_ns / BENCH_LOOKUPS));
+	}
+
+	free(base);
+}
+
 static void test_imd_entry_find_or_add(void **state)
 {
 	struct imd imd = {0};
@@ -748,6 +870,8 @@ int main(void)
 		cmocka_unit_test(test_imd_region_used),
 		cmocka_unit_test(test_imd_entry_add),
 		cmocka_unit_test(test_imd_entry_find),
+		cmocka_unit_test(test_imd_entry_find_many),
+		cmocka_unit_test(test_imd_entry_find_cost),
 		cmocka_unit_test(test_imd_entry_find_or_add),
 		cmocka_unit_test(test_imd_entry_size),
 		cmocka_unit_test(test_imd_entry_at),
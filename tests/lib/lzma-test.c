@@ -1,5 +1,6 @@
 /* SPDX-License-Identifier: GPL-2.0-only */
 
+#include <commonlib/region.h>
 #include <fcntl.h>
 #include <lib.h>
 #include <lib/lzmadecode.h>
@@ -8,6 +9,7 @@
 #include <sys/types.h>
 #include <sys/stat.h>
 #include <tests/test.h>
+#include <thread.h>
 #include <unistd.h>
 
 
@@ -128,6 +130,84 @@ static void test_ulzman_correct_file(void **state)
 	test_free(comp_buf);
 }
 
+/* Run stream reads to completion right away, which is what a coop thread does when nothing
+   yields. Return an error for every other thread to exercise the synchronous fallback too. */
+int thread_run(struct thread_handle *handle, enum cb_err (*func)(void *), void *arg)
+{
+	static int calls;
+
+	if (calls++ % 2)
+		return -1;
+	handle->error = func(arg);
+	handle->state = THREAD_DONE;
+	return 0;
+}
+
+enum cb_err thread_join(struct thread_handle *handle)
+{
+	assert_int_equal(THREAD_DONE, handle->state);
+	handle->state = THREAD_UNINITIALIZED;
+	return handle->error;
+}
+
+static void test_ulzman_rdev_correct_file(void **state)
+{
+	struct lzma_test_state *s = *state;
+	struct region_device rdev;
+	uint8_t *raw_buf = test_malloc(s->raw_file_sz);
+	uint8_t *decomp_buf = test_malloc(s->raw_file_sz);
+	uint8_t *comp_buf = test_malloc(s->comp_file_sz);
+	/* Odd sizes make chunk boundaries fall everywhere relative to the decoder's reads. */
+	const size_t work_sizes[] = { 2 * 16, 2 * 17 + 1, 2 * 1000, 8 * KiB };
+	uint8_t work[8 * KiB];
+
+	assert_non_null(raw_buf);
+	assert_non_null(decomp_buf);
+	assert_non_null(comp_buf);
+	assert_int_equal(s->raw_file_sz, read_file(s->raw_filename, raw_buf, s->raw_file_sz));
+	assert_int_equal(s->comp_file_sz,
+			 read_file(s->comp_filename, comp_buf, s->comp_file_sz));
+	rdev_chain_mem(&rdev, comp_buf, s->comp_file_sz);
+
+	for (size_t i = 0; i < ARRAY_SIZE(work_sizes); i++) {
+		memset(decomp_buf, 0, s->raw_file_sz);
+		assert_int_equal(s->raw_file_sz, ulzman_rdev(&rdev, decomp_buf, s->raw_file_sz,
+							     work, work_sizes[i]));
+		assert_memory_equal(raw_buf, decomp_buf, s->raw_file_sz);
+	}
+
+	test_free(raw_buf);
+	test_free(decomp_buf);
+	test_free(comp_buf);
+}
+
+static void test_ulzman_rdev_truncated_file(void **state)
+{
+	struct lzma_test_state *s = *state;
+	struct region_device rdev;
+	uint8_t *decomp_buf = test_malloc(s->raw_file_sz);
+	uint8_t *comp_buf = test_malloc(s->comp_file_sz);
+	uint8_t work[1 * KiB];
+
+	assert_non_null(decomp_buf);
+	assert_non_null(comp_buf);
+	assert_int_equal(s->comp_file_sz,
+			 read_file(s->comp_filename, comp_buf, s->comp_file_sz));
+
+	/* Running out of input in the middle of the stream must fail cleanly. */
+	rdev_chain_mem(&rdev, comp_buf, s->comp_file_sz / 2);
+	assert_int_equal(0, ulzman_rdev(&rdev, decomp_buf, s->raw_file_sz, work,
+					sizeof(work)));
+
+	/* Same for a stream buffer that can't even hold the header. */
+	rdev_chain_mem(&rdev, comp_buf, s->comp_file_sz);
+	assert_int_equal(0, ulzman_rdev(&rdev, decomp_buf, s->raw_file_sz, work,
+					LZMA_PROPERTIES_SIZE));
+
+	test_free(decomp_buf);
+	test_free(comp_buf);
+}
+
 static void test_ulzman_input_too_small(void **state)
 {
 	uint8_t in_buf[32] = {0};
@@ -147,13 +227,17 @@ static void test_ulzman_zero_buffer(void **state)
 	assert_int_equal(0, ulzman(in_buf, sizeof(in_buf), out_buf, sizeof(out_buf)));
 }
 
-#define ULZMAN_CORRECT_FILE_TEST(_file_prefix)                                                 \
+#define ULZMAN_FILE_TEST(_test_func, _file_prefix)                                              \
 	{                                                                                      \
-		.name = "test_ulzman_correct_file(" _file_prefix ")",                          \
-		.test_func = test_ulzman_correct_file, .setup_func = setup_ulzman_file,        \
+		.name = #_test_func "(" _file_prefix ")",                                      \
+		.test_func = _test_func, .setup_func = setup_ulzman_file,                      \
 		.teardown_func = teardown_ulzman_file, .initial_state = (_file_prefix)         \
 	}
 
+#define ULZMAN_CORRECT_FILE_TEST(_file_prefix)                                                 \
+	ULZMAN_FILE_TEST(test_ulzman_correct_file, _file_prefix),                              \
+	ULZMAN_FILE_TEST(test_ulzman_rdev_correct_file, _file_prefix)
+
 int main(void)
 {
 	const struct CMUnitTest tests[] = {
@@ -179,6 +263,8 @@ int main(void)
 		   Another binary file, shared object. */
 		ULZMAN_CORRECT_FILE_TEST("data.4"),
 
+		ULZMAN_FILE_TEST(test_ulzman_rdev_truncated_file, "data.2"),
+
 		cmocka_unit_test(test_ulzman_input_too_small),
 
 		cmocka_unit_test(test_ulzman_zero_buffer),
@@ -0,0 +1,206 @@
+/* SPDX-License-Identifier: GPL-2.0-only */
+
+/* Include the coreboot implementations under different names so they can be compared with both
+   the host libc and the simple byte loops they replaced. */
+#define memcpy cb_memcpy
+#define memmove cb_memmove
+#define memset cb_memset
+#include "../lib/memcpy.c"
+#include "../lib/memmove.c"
+#include "../lib/memset.c"
+#undef memcpy
+#undef memmove
+#undef memset
+
+#include <stdlib.h>
+#include <tests/bench.h>
+#include <tests/test.h>
+#include <commonlib/helpers.h>
+#include <types.h>
+
+/* Prototypes from string.h were renamed above. They have to be declared again. */
+void *memcpy(void *dest, const void *src, size_t n);
+void *memmove(void *dest, const void *src, size_t n);
+void *memset(void *s, int c, size_t n);
+
+#define CHECK_MAX_OFFSET 16
+#define CHECK_MAX_LEN 128
+#define CHECK_BUFFER_SZ (2 * CHECK_MAX_OFFSET + CHECK_MAX_LEN)
+
+#define BENCH_MIN_SZ 16
+#define BENCH_MAX_SZ (16 * MiB)
+/* Bytes processed per measurement, so that every size takes roughly the same time. */
+#define BENCH_BYTES_PER_SZ (16 * MiB)
+
+/* The byte-wise implementations the word-sized ones replaced, kept as a baseline. */
+static void *byte_memcpy(void *vdest, const void *vsrc, size_t bytes)
+{
+	const char *src = vsrc;
+	char *dest = vdest;
+	int i;
+
+	for (i = 0; i < (int)bytes; i++)
+		dest[i] = src[i];
+
+	return vdest;
+}
+
+static void *byte_memmove(void *vdest, const void *vsrc, size_t count)
+{
+	const char *src = vsrc;
+	char *dest = vdest;
+
+	if (dest <= src) {
+		while (count--)
+			*dest++ = *src++;
+	} else {
+		src  += count - 1;
+		dest += count - 1;
+		while (count--)
+			*dest-- = *src--;
+	}
+	return vdest;
+}
+
+static void *byte_memset(void *s, int c, size_t n)
+{
+	int i;
+	char *ss = (char *)s;
+
+	for (i = 0; i < (int)n; i++)
+		ss[i] = c;
+
+	return s;
+}
+
+static void fill_pattern(u8 *buf, size_t sz, u8 seed)
+{
+	for (size_t i = 0; i < sz; i++)
+		buf[i] = seed + i * 7;
+}
+
+static void test_memcpy_all_alignments(void **state)
+{
+	u8 src[CHECK_BUFFER_SZ];
+	u8 dst[CHECK_BUFFER_SZ];
+	u8 expected[CHECK_BUFFER_SZ];
+
+	fill_pattern(src, sizeof(src), 1);
+
+	for (size_t soff = 0; soff < CHECK_MAX_OFFSET; soff++)
+		for (size_t doff = 0; doff < CHECK_MAX_OFFSET; doff++)
+			for (size_t len = 0; len <= CHECK_MAX_LEN; len++) {
+				fill_pattern(dst, sizeof(dst), 0x80);
+				memcpy(expected, dst, sizeof(dst));
+				memcpy(expected + doff, src + soff, len);
+
+				assert_ptr_equal(dst + doff, cb_memcpy(dst + doff, src + soff, len));
+				assert_memory_equal(expected, dst, sizeof(dst));
+			}
+}
+
+static void test_memmove_all_overlaps(void **state)
+{
+	u8 buf[CHECK_BUFFER_SZ];
+	u8 expected[CHECK_BUFFER_SZ];
+
+	/* Source and destination in the same buffer, overlapping in both directions. */
+	for (size_t soff = 0; soff < 2 * CHECK_MAX_OFFSET; soff++)
+		for (size_t doff = 0; doff < 2 * CHECK_MAX_OFFSET; doff++)
+			for (size_t len = 0; len <= CHECK_MAX_LEN; len++) {
+				fill_pattern(buf, sizeof(buf), 3);
+				memcpy(expected, buf, sizeof(buf));
+				memmove(expected + doff, expected + soff, len);
+
+				assert_ptr_equal(buf + doff, cb_memmove(buf + doff, buf + soff, len));
+				assert_memory_equal(expected, buf, sizeof(buf));
+			}
+}
+
+static void test_memset_all_alignments(void **state)
+{
+	const int values[] = { 0, 0x5a, 0xff, -1, 0x1234 };
+	u8 buf[CHECK_BUFFER_SZ];
+	u8 expected[CHECK_BUFFER_SZ];
+
+	for (size_t v = 0; v < ARRAY_SIZE(values); v++)
+		for (size_t off = 0; off < CHECK_MAX_OFFSET; off++)
+			for (size_t len = 0; len <= CHECK_MAX_LEN; len++) {
+				fill_pattern(buf, sizeof(buf), 5);
+				memcpy(expected, buf, sizeof(buf));
+				memset(expected + off, values[v], len);
+
+				assert_ptr_equal(buf + off, cb_memset(buf + off, values[v], len));
+				assert_memory_equal(expected, buf, sizeof(buf));
+			}
+}
+
+enum bench_op { BENCH_MEMCPY, BENCH_MEMMOVE, BENCH_MEMSET };
+
+static const char *const bench_op_names[] = {
+	[BENCH_MEMCPY] = "memcpy",
+	[BENCH_MEMMOVE] = "memmove",
+	[BENCH_MEMSET] = "memset",
+};
+
+/* Returns MiB/s for running |op| over |sz| bytes, using the byte loops if |baseline| is set. */
+static uint64_t bench_one(enum bench_op op, bool baseline, u8 *dst, const u8 *src, size_t sz)
+{
+	const size_t rounds = MAX(BENCH_BYTES_PER_SZ / sz, (size_t)1);
+	const uint64_t start = bench_time_ns();
+
+	for (size_t i = 0; i < rounds; i++) {
+		switch (op) {
+		case BENCH_MEMCPY:
+			baseline ? byte_memcpy(dst, src, sz) : cb_memcpy(dst, src, sz);
+			break;
+		case BENCH_MEMMOVE:
+			/* Overlapping backwards move, the direction that can't use memcpy(). */
+			baseline ? byte_memmove(dst + WSIZE, dst, sz)
+				 : cb_memmove(dst + WSIZE, dst, sz);
+			break;
+		case BENCH_MEMSET:
+			baseline ? byte_memset(dst, i, sz) : cb_memset(dst, i, sz);
+			break;
+		}
+	}
+
+	return bench_per_second((uint64_t)rounds * sz, bench_time_ns() - start) / MiB;
+}
+
+static void test_mem_functions_throughput(void **state)
+{
+	/* One extra word for the overlapping memmove(). */
+	u8 *src = malloc(BENCH_MAX_SZ);
+	u8 *dst = malloc(BENCH_MAX_SZ + WSIZE);
+
+	assert_non_null(src);
+	assert_non_null(dst);
+	fill_pattern(src, BENCH_MAX_SZ, 9);
+	fill_pattern(dst, BENCH_MAX_SZ + WSIZE, 11);
+
+	for (enum bench_op op = BENCH_MEMCPY; op <= BENCH_MEMSET; op++)
+		for (size_t sz = BENCH_MIN_SZ; sz <= BENCH_MAX_SZ; sz *= 4) {
+			const uint64_t words = bench_one(op, false, dst, src, sz);
+			const uint64_t bytes = bench_one(op, true, dst, src, sz);
+
+			print_message("%-7s %8zu bytes: %6llu MiB/s (byte loop %6llu MiB/s)\n",
+				      bench_op_names[op], sz, (unsigned long long)words,
+				      (unsigned long long)bytes);
+		}
+
+	free(src);
+	free(dst);
+}
+
+int main(void)
+{
+	const struct CMUnitTest tests[] = {
+		cmocka_unit_test(test_memcpy_all_alignments),
+		cmocka_unit_test(test_memmove_all_overlaps),
+		cmocka_unit_test(test_memset_all_alignments),
+		cmocka_unit_test(test_mem_functions_throughput),
+	};
+
+	return cb_run_group_tests(tests, NULL, NULL);
+}
@@ -1,11 +1,13 @@
 /* SPDX-License-Identifier: GPL-2.0-only */
 
+#include <tests/bench.h>
 #include <tests/test.h>
 
 #include <device/device.h>
 #include <device/resource.h>
 #include <commonlib/helpers.h>
 #include <memrange.h>
+#include <string.h>
 
 #define MEMRANGE_ALIGN (POWER_OF_2(12))
 
@@ -690,6 +692,217 @@ static void test_memrange_add_resources_filter(void **state)
 	memranges_teardown(&test_memrange);
 }
 
+/* Model of the address space for the randomized tests: one tag per 4KiB page, 0 is empty. */
+#define MODEL_PAGES 4096
+#define MODEL_TAGS 3
+#define MODEL_OPS 20000
+#define BENCH_MAX_RANGES 4096
+
+static unsigned long model[MODEL_PAGES];
+static uint32_t rand_state;
+
+static uint32_t next_rand(void)
+{
+	/* Numerical Recipes LCG, good enough and reproducible. */
+	rand_state = rand_state * 1664525 + 1013904223;
+	return rand_state >> 8;
+}
+
+/* Check that the search tree contains the list entries in order, is balanced and has the
+   right spans cached. Returns the height of the subtree. */
+static int check_tree(const struct range_entry *r, const struct range_entry **next)
+{
+	int left, right;
+
+	if (r == NULL)
+		return 0;
+
+	left = check_tree(r->left, next);
+	assert_ptr_equal(*next, r);
+	*next = r->next;
+	right = check_tree(r->right, next);
+
+	assert_true(left <= right + 1 && right <= left + 1);
+	assert_int_equal(r->height, MAX(left, right) + 1);
+	assert_true(r->max_span >= r->end - r->begin);
+	if (r->left)
+		assert_true(r->max_span >= r->left->max_span);
+	if (r->right)
+		assert_true(r->max_span >= r->right->max_span);
+
+	return r->height;
+}
+
+static void check_against_model(struct memranges *ranges)
+{
+	const struct range_entry *next = ranges->entries;
+	const struct range_entry *r;
+	size_t page = 0;
+
+	check_tree(ranges->root, &next);
+	assert_null(next);
+
+	memranges_each_entry(r, ranges) {
+		const size_t begin = range_entry_base(r) / MEMRANGE_ALIGN;
+		const size_t end = range_entry_end(r) / MEMRANGE_ALIGN;
+
+		/* Nothing in the model before this entry. */
+		for (; page < begin; page++)
+			assert_int_equal(0, model[page]);
+		/* The entry covers pages of its tag. */
+		for (; page < end; page++)
+			assert_int_equal(range_entry_tag(r), model[page]);
+		/* Neighbors with the same tag must have been merged. */
+		if (r->next)
+			assert_true(r->next->begin > r->end + 1 || r->next->tag != r->tag);
+	}
+	for (; page < MODEL_PAGES; page++)
+		assert_int_equal(0, model[page]);
+}
+
+/* Random inserts and holes compared against a page based model after every step. */
+static void test_memrange_random_ops(void **state)
+{
+	struct memranges test_memrange;
+	resource_t stolen;
+	size_t i, j;
+
+	rand_state = 1;
+	memset(model, 0, sizeof(model));
+	memranges_init_empty(&test_memrange, NULL, 0);
+
+	for (i = 0; i < MODEL_OPS; i++) {
+		const size_t begin = next_rand() % MODEL_PAGES;
+		const size_t pages = 1 + next_rand() % MIN(MODEL_PAGES - begin, (size_t)64);
+		const unsigned long tag = 1 + next_rand() % MODEL_TAGS;
+
+		switch (next_rand() % 4) {
+		case 0:
+			memranges_create_hole(&test_memrange, begin * MEMRANGE_ALIGN,
+					      pages * MEMRANGE_ALIGN);
+			for (j = begin; j < begin + pages; j++)
+				model[j] = 0;
+			break;
+		case 1:
+			/* Stealing is checked against the model by the next comparison. */
+			if (memranges_steal(&test_memrange, MODEL_PAGES * MEMRANGE_ALIGN - 1,
+					    pages * MEMRANGE_ALIGN, 12, tag, &stolen, i & 1)) {
+				const size_t page = stolen / MEMRANGE_ALIGN;
+
+				for (j = page; j < page + pages; j++) {
+					assert_int_equal(tag, model[j]);
+					model[j] = 0;
+				}
+			}
+			break;
+		default:
+			memranges_insert(&test_memrange, begin * MEMRANGE_ALIGN,
+					 pages * MEMRANGE_ALIGN, tag);
+			for (j = begin; j < begin + pages; j++)
+				model[j] = tag;
+			break;
+		}
+
+		check_against_model(&test_memrange);
+	}
+
+	memranges_teardown(&test_memrange);
+}
+
+/* Fill the memranges with |count| ranges of one page that are two pages apart, so that they
+   don't merge, inserted in a scrambled order. */
+static void insert_spread_ranges(struct memranges *ranges, size_t count)
+{
+	for (size_t i = 0; i < count; i++) {
+		/* Visit all indices in a different order, count is a power of two. */
+		const size_t index = (i * 2654435761u) % count;
+
+		memranges_insert(ranges, index * 2 * MEMRANGE_ALIGN, MEMRANGE_ALIGN, 1);
+	}
+}
+
+static void test_memrange_bulk_insert(void **state)
+{
+	static struct range_entry entries[BENCH_MAX_RANGES];
+	struct memranges bulk, single;
+	const struct range_entry *r, *s;
+	size_t i;
+
+	for (i = 0; i < ARRAY_SIZE(entries); i++)
+		range_entry_init(&entries[i], i * 3 * MEMRANGE_ALIGN,
+				 (i * 3 + 1 + i % 2) * MEMRANGE_ALIGN, 1 + i % 3);
+
+	/* Sorted input goes through the single pass path. */
+	memranges_init_empty(&bulk, NULL, 0);
+	memranges_insert_bulk(&bulk, entries, ARRAY_SIZE(entries));
+	memranges_init_empty(&single, NULL, 0);
+	for (i = 0; i < ARRAY_SIZE(entries); i++)
+		memranges_insert(&single, range_entry_base(&entries[i]),
+				 range_entry_size(&entries[i]), range_entry_tag(&entries[i]));
+
+	s = single.entries;
+	memranges_each_entry(r, &bulk) {
+		assert_non_null(s);
+		assert_int_equal(range_entry_base(s), range_entry_base(r));
+		assert_int_equal(range_entry_end(s), range_entry_end(r));
+		assert_int_equal(range_entry_tag(s), range_entry_tag(r));
+		s = s->next;
+	}
+	assert_null(s);
+
+	r = bulk.entries;
+	check_tree(bulk.root, &r);
+
+	/* Inserting into a non-empty memranges falls back to one insert per entry. */
+	memranges_insert_bulk(&bulk, entries, ARRAY_SIZE(entries));
+	r = bulk.entries;
+	check_tree(bulk.root, &r);
+	assert_null(r);
+
+	memranges_teardown(&bulk);
+	memranges_teardown(&single);
+}
+
+static void test_memrange_many_ranges_bench(void **state)
+{
+	static struct range_entry entries[BENCH_MAX_RANGES];
+	struct memranges test_memrange;
+	resource_t stolen;
+	uint64_t start, insert_ns, steal_ns, bulk_ns;
+	size_t count, i;
+
+	for (count = 256; count <= BENCH_MAX_RANGES; count *= 4) {
+		memranges_init_empty(&test_memrange, NULL, 0);
+
+		start = bench_time_ns();
+		insert_spread_ranges(&test_memrange, count);
+		insert_ns = bench_time_ns() - start;
+
+		/* Steal from the top, the worst case for walking the list. */
+		start = bench_time_ns();
+		for (i = 0; i < count; i++)
+			assert_true(memranges_steal(&test_memrange, count * 2 * MEMRANGE_ALIGN,
+						    MEMRANGE_ALIGN, 12, 1, &stolen, true));
+		steal_ns = bench_time_ns() - start;
+		assert_true(memranges_is_empty(&test_memrange));
+
+		for (i = 0; i < count; i++)
+			range_entry_init(&entries[i], i * 2 * MEMRANGE_ALIGN,
+					 (i * 2 + 1) * MEMRANGE_ALIGN, 1);
+		start = bench_time_ns();
+		memranges_insert_bulk(&test_memrange, entries, count);
+		bulk_ns = bench_time_ns() - start;
+
+		print_message("%5zu ranges: insert %6llu ns, steal %6llu ns, "
+			      "bulk insert %4llu ns per range\n", count,
+			      (unsigned long long)(insert_ns / count),
+			      (unsigned long long)(steal_ns / count),
+			      (unsigned long long)(bulk_ns / count));
+
+		memranges_teardown(&test_memrange);
+	}
+}
+
 int main(void)
 {
 	const struct CMUnitTest tests[] = {
@@ -700,11 +913,18 @@ int main(void)
 		cmocka_unit_test(test_memrange_init_and_teardown),
 		cmocka_unit_test(test_memrange_add_resources_filter),
 	};
+	const struct CMUnitTest many_ranges_tests[] = {
+		cmocka_unit_test(test_memrange_random_ops),
+		cmocka_unit_test(test_memrange_bulk_insert),
+		cmocka_unit_test(test_memrange_many_ranges_bench),
+	};
 
 	return cmocka_run_group_tests_name(__TEST_NAME__ "(Boundary on 4GiB)", tests,
 					   setup_test_1, NULL)
 	       + cmocka_run_group_tests_name(__TEST_NAME__ "(Boundaries 1 byte from 4GiB)",
 					     tests, setup_test_2, NULL)
 	       + cmocka_run_group_tests_name(__TEST_NAME__ "(Range over 4GiB boundary)", tests,
-					     setup_test_3, NULL);
+					     setup_test_3, NULL)
+	       + cmocka_run_group_tests_name(__TEST_NAME__ "(Many ranges)", many_ranges_tests,
+					     NULL, NULL);
 }
@@ -0,0 +1,247 @@
+/* SPDX-License-Identifier: GPL-2.0-only */
+
+#include <commonlib/bsd/helpers.h>
+#include <multihash.h>
+#include <stdlib.h>
+#include <string.h>
+#include <tests/bench.h>
+#include <tests/test.h>
+
+#define TEST_BUFFER_SZ (64 * KiB + 123)
+#define BENCH_BUFFER_SZ (64 * MiB)
+#define MAX_EXTENDS 64
+
+/*
+ * vboot isn't available to the unit tests, so the digests are replaced by a cheap stand-in
+ * that still reads every byte: a multiplicative hash per algorithm. The hardware is pretended
+ * to support SHA-256 only.
+ */
+static struct {
+	const struct vb2_digest_context *dc;
+	const uint8_t *buf;
+	uint32_t size;
+} extends[MAX_EXTENDS];
+static size_t num_extends;
+static bool record_extends;
+static vb2_error_t extend_error;
+
+static uint64_t *standin_state(struct vb2_digest_context *dc)
+{
+	return (uint64_t *)dc->sha512.h;
+}
+
+size_t vb2_digest_size(enum vb2_hash_algorithm hash_alg)
+{
+	switch (hash_alg) {
+	case VB2_HASH_SHA256:
+		return VB2_SHA256_DIGEST_SIZE;
+	case VB2_HASH_SHA512:
+		return VB2_SHA512_DIGEST_SIZE;
+	default:
+		return 0;
+	}
+}
+
+vb2_error_t vb2_digest_init(struct vb2_digest_context *dc, bool allow_hwcrypto,
+			    enum vb2_hash_algorithm hash_alg, uint32_t data_size)
+{
+	if (!vb2_digest_size(hash_alg))
+		return VB2_ERROR_SHA_INIT_ALGORITHM;
+
+	memset(dc, 0, sizeof(*dc));
+	dc->hash_alg = hash_alg;
+	dc->using_hwcrypto = allow_hwcrypto && hash_alg == VB2_HASH_SHA256;
+	*standin_state(dc) = hash_alg;
+	return VB2_SUCCESS;
+}
+
+vb2_error_t vb2_digest_extend(struct vb2_digest_context *dc, const uint8_t *buf, uint32_t size)
+{
+	uint64_t h = *standin_state(dc);
+
+	if (record_extends && num_extends < ARRAY_SIZE(extends)) {
+		extends[num_extends].dc = dc;
+		extends[num_extends].buf = buf;
+		extends[num_extends].size = size;
+		num_extends++;
+	}
+
+	if (extend_error)
+		return extend_error;
+
+	for (uint32_t i = 0; i < size; i++)
+		h = (h ^ buf[i]) * (dc->hash_alg == VB2_HASH_SHA256 ? 0x100000001b3ULL
+								    : 0x9e3779b97f4a7c15ULL);
+	*standin_state(dc) = h;
+	return VB2_SUCCESS;
+}
+
+vb2_error_t vb2_digest_finalize(struct vb2_digest_context *dc, uint8_t *digest, uint32_t size)
+{
+	if (size != vb2_digest_size(dc->hash_alg))
+		return VB2_ERROR_SHA_FINALIZE_DIGEST_SIZE;
+
+	memset(digest, 0, size);
+	memcpy(digest, standin_state(dc), sizeof(uint64_t));
+	digest[size - 1] = dc->using_hwcrypto;
+	return VB2_SUCCESS;
+}
+
+static uint8_t *alloc_buffer(size_t size)
+{
+	uint8_t *buf = malloc(size);
+
+	assert_non_null(buf);
+	for (size_t i = 0; i < size; i++)
+		buf[i] = i * 31 + (i >> 11);
+
+	return buf;
+}
+
+static int setup_multihash(void **state)
+{
+	num_extends = 0;
+	record_extends = true;
+	extend_error = VB2_SUCCESS;
+	return 0;
+}
+
+static void test_multihash_matches_single(void **state)
+{
+	uint8_t *buf = alloc_buffer(TEST_BUFFER_SZ);
+	struct vb2_hash both[2] = { { .algo = VB2_HASH_SHA512 }, { .algo = VB2_HASH_SHA256 } };
+	struct vb2_hash single;
+
+	record_extends = false;
+	assert_int_equal(VB2_SUCCESS, multihash_calculate(false, buf, TEST_BUFFER_SZ, both,
+							  ARRAY_SIZE(both)));
+
+	for (size_t i = 0; i < ARRAY_SIZE(both); i++) {
+		single.algo = both[i].algo;
+		assert_int_equal(VB2_SUCCESS,
+				 multihash_calculate(false, buf, TEST_BUFFER_SZ, &single, 1));
+		assert_memory_equal(single.raw, both[i].raw, vb2_digest_size(single.algo));
+	}
+
+	free(buf);
+}
+
+static void test_multihash_single_pass(void **state)
+{
+	uint8_t *buf = alloc_buffer(TEST_BUFFER_SZ);
+	struct vb2_hash hashes[2] = { { .algo = VB2_HASH_SHA256 },
+				      { .algo = VB2_HASH_SHA512 } };
+	size_t offset = 0;
+
+	assert_int_equal(VB2_SUCCESS, multihash_calculate(false, buf, TEST_BUFFER_SZ, hashes,
+							  ARRAY_SIZE(hashes)));
+
+	/* Each chunk is hashed by both algorithms before moving on to the next one. */
+	assert_int_equal(0, num_extends % 2);
+	for (size_t i = 0; i < num_extends; i += 2) {
+		assert_ptr_equal(buf + offset, extends[i].buf);
+		assert_ptr_equal(extends[i].buf, extends[i + 1].buf);
+		assert_int_equal(extends[i].size, extends[i + 1].size);
+		assert_ptr_not_equal(extends[i].dc, extends[i + 1].dc);
+		assert_true(extends[i].size <= 4 * KiB);
+		offset += extends[i].size;
+	}
+	assert_int_equal(TEST_BUFFER_SZ, offset);
+
+	/* A single digest is calculated in one go. */
+	num_extends = 0;
+	assert_int_equal(VB2_SUCCESS,
+			 multihash_calculate(false, buf, TEST_BUFFER_SZ, hashes, 1));
+	assert_int_equal(1, num_extends);
+	assert_int_equal(TEST_BUFFER_SZ, extends[0].size);
+
+	free(buf);
+}
+
+static void test_multihash_hwcrypto_once(void **state)
+{
+	uint8_t buf[64] = { 0 };
+	struct vb2_hash hashes[2];
+
+	/* The first algorithm the hardware supports gets it. */
+	hashes[0].algo = VB2_HASH_SHA512;
+	hashes[1].algo = VB2_HASH_SHA256;
+	assert_int_equal(VB2_SUCCESS, multihash_calculate(true, buf, sizeof(buf), hashes, 2));
+	assert_false(hashes[0].raw[VB2_SHA512_DIGEST_SIZE - 1]);
+	assert_true(hashes[1].raw[VB2_SHA256_DIGEST_SIZE - 1]);
+
+	/* The hardware keeps the state of one digest only. */
+	hashes[0].algo = VB2_HASH_SHA256;
+	assert_int_equal(VB2_SUCCESS, multihash_calculate(true, buf, sizeof(buf), hashes, 2));
+	assert_true(hashes[0].raw[VB2_SHA256_DIGEST_SIZE - 1]);
+	assert_false(hashes[1].raw[VB2_SHA256_DIGEST_SIZE - 1]);
+
+	assert_int_equal(VB2_SUCCESS, multihash_calculate(false, buf, sizeof(buf), hashes, 2));
+	assert_false(hashes[0].raw[VB2_SHA256_DIGEST_SIZE - 1]);
+}
+
+static void test_multihash_errors(void **state)
+{
+	uint8_t buf[64] = { 0 };
+	struct vb2_hash hashes[MULTIHASH_MAX_DIGESTS + 1];
+
+	for (size_t i = 0; i < ARRAY_SIZE(hashes); i++)
+		hashes[i].algo = VB2_HASH_SHA256;
+
+	assert_int_not_equal(VB2_SUCCESS, multihash_calculate(false, buf, sizeof(buf), hashes,
+							      0));
+	assert_int_not_equal(VB2_SUCCESS, multihash_calculate(false, buf, sizeof(buf), hashes,
+							      ARRAY_SIZE(hashes)));
+
+	hashes[1].algo = VB2_HASH_INVALID;
+	assert_int_equal(VB2_ERROR_SHA_INIT_ALGORITHM,
+			 multihash_calculate(false, buf, sizeof(buf), hashes, 2));
+
+	hashes[1].algo = VB2_HASH_SHA256;
+	extend_error = VB2_ERROR_SHA_EXTEND_ALGORITHM;
+	assert_int_equal(VB2_ERROR_SHA_EXTEND_ALGORITHM,
+			 multihash_calculate(false, buf, sizeof(buf), hashes, 2));
+}
+
+/* Compare one pass for both digests with hashing the buffer once per digest. */
+static void test_multihash_throughput(void **state)
+{
+	uint8_t *buf = alloc_buffer(BENCH_BUFFER_SZ);
+	struct vb2_hash hashes[2] = { { .algo = VB2_HASH_SHA512 },
+				      { .algo = VB2_HASH_SHA256 } };
+	uint64_t start, one_pass_ns, two_pass_ns;
+	const size_t count = ARRAY_SIZE(hashes);
+
+	record_extends = false;
+
+	start = bench_time_ns();
+	assert_int_equal(VB2_SUCCESS,
+			 multihash_calculate(false, buf, BENCH_BUFFER_SZ, hashes, count));
+	one_pass_ns = bench_time_ns() - start;
+
+	start = bench_time_ns();
+	for (size_t i = 0; i < count; i++)
+		assert_int_equal(VB2_SUCCESS, multihash_calculate(false, buf, BENCH_BUFFER_SZ,
+								  &hashes[i], 1));
+	two_pass_ns = bench_time_ns() - start;
+
+	print_message("%u MiB, 2 digests: one pass %llu MiB/s, two passes %llu MiB/s\n",
+		      BENCH_BUFFER_SZ / MiB,
+		      (unsigned long long)bench_per_second(BENCH_BUFFER_SZ / MiB, one_pass_ns),
+		      (unsigned long long)bench_per_second(BENCH_BUFFER_SZ / MiB, two_pass_ns));
+
+	free(buf);
+}
+
+int main(void)
+{
+	const struct CMUnitTest tests[] = {
+		cmocka_unit_test_setup(test_multihash_matches_single, setup_multihash),
+		cmocka_unit_test_setup(test_multihash_single_pass, setup_multihash),
+		cmocka_unit_test_setup(test_multihash_hwcrypto_once, setup_multihash),
+		cmocka_unit_test_setup(test_multihash_errors, setup_multihash),
+		cmocka_unit_test_setup(test_multihash_throughput, setup_multihash),
+	};
+
+	return cb_run_group_tests(tests, NULL, NULL);
+}
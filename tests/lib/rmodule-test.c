@@ -0,0 +1,200 @@
+/* SPDX-License-Identifier: GPL-2.0-only */
+
+#include <commonlib/rmodule-defs.h>
+#include <program_loading.h>
+#include <rmodule.h>
+#include <string.h>
+#include <tests/test.h>
+#include <types.h>
+
+/* Program of PROGRAM_WORDS pointer-sized words, followed by BSS_WORDS of bss. The words at
+   the indices in relocs[] hold link addresses that need adjusting. */
+#define PROGRAM_WORDS 256
+#define BSS_WORDS 64
+#define MAX_RELOCS_SIZE (PROGRAM_WORDS * sizeof(uintptr_t))
+
+/* Mix of single relocations and runs of pointers at the same distance. */
+static const size_t relocs[] = { 0, 3, 4, 9, 10, 11, 12, 13, 14, 40, 42, 44, 46, 48, 100, 101,
+				 102, 200, 255 };
+
+static struct {
+	struct rmodule_header header;
+	uintptr_t program[PROGRAM_WORDS];
+	uint8_t relocs[MAX_RELOCS_SIZE];
+} blob;
+
+static uintptr_t load_area[PROGRAM_WORDS + BSS_WORDS];
+
+void prog_segment_loaded(uintptr_t start, size_t size, int flags)
+{
+}
+
+static uint8_t *put_uleb128(uint8_t *p, uintptr_t value)
+{
+	do {
+		*p = value & 0x7f;
+		value >>= 7;
+		if (value)
+			*p |= 0x80;
+		p++;
+	} while (value);
+
+	return p;
+}
+
+static size_t pack_relocs(uint8_t *p)
+{
+	uint8_t *const start = p;
+	uintptr_t prev = 0;
+	size_t i = 0;
+
+	while (i < ARRAY_SIZE(relocs)) {
+		const uintptr_t addr = relocs[i] * sizeof(uintptr_t);
+		const uintptr_t delta = addr - prev;
+		size_t run = 0;
+
+		while (i + run + 1 < ARRAY_SIZE(relocs) &&
+		       (relocs[i + run + 1] - relocs[i + run]) * sizeof(uintptr_t) == delta)
+			run++;
+
+		if (run) {
+			p = put_uleb128(p, delta << 1 | RMODULE_RELOC_RUN);
+			p = put_uleb128(p, run);
+		} else {
+			p = put_uleb128(p, delta << 1);
+		}
+
+		i += run + 1;
+		prev = relocs[i - 1] * sizeof(uintptr_t);
+	}
+
+	return p - start;
+}
+
+static void setup_blob(uint8_t version)
+{
+	struct rmodule_header *h = &blob.header;
+	size_t relocs_size;
+
+	for (size_t i = 0; i < PROGRAM_WORDS; i++)
+		blob.program[i] = i * 0x1111;
+
+	if (version == RMODULE_VERSION_1) {
+		uintptr_t *flat = (uintptr_t *)blob.relocs;
+
+		for (size_t i = 0; i < ARRAY_SIZE(relocs); i++)
+			flat[i] = relocs[i] * sizeof(uintptr_t);
+		relocs_size = ARRAY_SIZE(relocs) * sizeof(uintptr_t);
+	} else {
+		relocs_size = pack_relocs(blob.relocs);
+	}
+
+	memset(h, 0, sizeof(*h));
+	h->magic = RMODULE_MAGIC;
+	h->version = version;
+	h->payload_begin_offset = offsetof(typeof(blob), program);
+	h->payload_end_offset = h->payload_begin_offset + sizeof(blob.program);
+	h->relocations_begin_offset = offsetof(typeof(blob), relocs);
+	h->relocations_end_offset = h->relocations_begin_offset + relocs_size;
+	h->module_link_start_address = 0;
+	h->module_program_size = sizeof(load_area);
+	h->bss_begin = sizeof(blob.program);
+	h->bss_end = sizeof(load_area);
+
+	memset(load_area, 0xa5, sizeof(load_area));
+}
+
+static void check_loaded(const struct rmodule *module)
+{
+	const uintptr_t adjustment = (uintptr_t)load_area;
+	size_t r = 0;
+
+	assert_ptr_equal(load_area, module->location);
+
+	for (size_t i = 0; i < PROGRAM_WORDS; i++) {
+		if (r < ARRAY_SIZE(relocs) && relocs[r] == i) {
+			assert_int_equal(i * 0x1111 + adjustment, load_area[i]);
+			r++;
+		} else {
+			assert_int_equal(i * 0x1111, load_area[i]);
+		}
+	}
+
+	for (size_t i = PROGRAM_WORDS; i < ARRAY_SIZE(load_area); i++)
+		assert_int_equal(0, load_area[i]);
+}
+
+static void test_rmodule_load(void **state)
+{
+	const uint8_t version = *(uint8_t *)*state;
+	struct rmodule module;
+
+	setup_blob(version);
+
+	assert_int_equal(0, rmodule_parse(&blob, &module));
+	assert_int_equal(0, rmodule_load(load_area, &module));
+	check_loaded(&module);
+}
+
+static void test_rmodule_packed_is_smaller(void **state)
+{
+	setup_blob(RMODULE_VERSION_2);
+
+	assert_true(blob.header.relocations_end_offset - blob.header.relocations_begin_offset
+		    < ARRAY_SIZE(relocs) * sizeof(uintptr_t) / 2);
+}
+
+static void test_rmodule_packed_truncated(void **state)
+{
+	struct rmodule module;
+
+	setup_blob(RMODULE_VERSION_2);
+	/* Cut off the count of the last run. */
+	blob.relocs[blob.header.relocations_end_offset - blob.header.relocations_begin_offset
+		    - 1] |= 0x80;
+
+	assert_int_equal(0, rmodule_parse(&blob, &module));
+	assert_int_equal(-1, rmodule_load(load_area, &module));
+}
+
+static void test_rmodule_packed_out_of_bounds(void **state)
+{
+	uint8_t *p = blob.relocs;
+	struct rmodule module;
+
+	setup_blob(RMODULE_VERSION_2);
+	/* A run that continues past the end of the program. */
+	p = put_uleb128(p, sizeof(uintptr_t) << 1 | RMODULE_RELOC_RUN);
+	p = put_uleb128(p, PROGRAM_WORDS + BSS_WORDS);
+	blob.header.relocations_end_offset = blob.header.relocations_begin_offset
+					     + (p - blob.relocs);
+
+	assert_int_equal(0, rmodule_parse(&blob, &module));
+	assert_int_equal(-1, rmodule_load(load_area, &module));
+}
+
+static void test_rmodule_parse_unknown_version(void **state)
+{
+	struct rmodule module;
+
+	setup_blob(RMODULE_VERSION_2);
+	blob.header.version = RMODULE_VERSION_2 + 1;
+
+	assert_int_equal(-1, rmodule_parse(&blob, &module));
+}
+
+int main(void)
+{
+	static const uint8_t flat = RMODULE_VERSION_1;
+	static const uint8_t packed = RMODULE_VERSION_2;
+	const struct CMUnitTest tests[] = {
+		cmocka_unit_test_prestate(test_rmodule_load, (void *)&flat),
+		cmocka_unit_test_prestate(test_rmodule_load, (void *)&packed),
+		cmocka_unit_test(test_rmodule_packed_is_smaller),
+		cmocka_unit_test(test_rmodule_packed_truncated),
+		cmocka_unit_test(test_rmodule_packed_out_of_bounds),
+		cmocka_unit_test(test_rmodule_parse_unknown_version),
+	};
+
+	return cb_run_group_tests(tests, NULL, NULL);
+}
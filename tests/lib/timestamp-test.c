@@ -9,6 +9,40 @@
 #define TIMESTAMP_REGION_SIZE (1 * KiB)
 TEST_REGION(timestamp, TIMESTAMP_REGION_SIZE);
 
+/* Minimal CBMEM that hands out one buffer per ID, like imd does. */
+static struct {
+	uint32_t id;
+	void *ptr;
+} fake_cbmem[MAX_TIMESTAMP_CHUNKS + 1];
+static size_t fake_cbmem_count;
+static bool fake_cbmem_full;
+
+void *cbmem_add(u32 id, u64 size)
+{
+	void *ptr = cbmem_find(id);
+
+	if (ptr)
+		return ptr;
+	if (fake_cbmem_full || fake_cbmem_count == ARRAY_SIZE(fake_cbmem))
+		return NULL;
+
+	ptr = test_malloc(size);
+	fake_cbmem[fake_cbmem_count].id = id;
+	fake_cbmem[fake_cbmem_count].ptr = ptr;
+	fake_cbmem_count++;
+
+	return ptr;
+}
+
+void *cbmem_find(u32 id)
+{
+	for (size_t i = 0; i < fake_cbmem_count; i++)
+		if (fake_cbmem[i].id == id)
+			return fake_cbmem[i].ptr;
+
+	return NULL;
+}
+
 void test_timestamp_init(void **state)
 {
 	timestamp_init(1000);
@@ -111,6 +145,131 @@ void test_get_us_since_boot(void **state)
 	assert_int_equal((base_multipler - timestamp_base) / freq_base, get_us_since_boot());
 }
 
+/* Timestamps with ID |first| and up, |count| of them, each 10 ticks after the one before. */
+static void add_timestamps(uint32_t first, uint32_t count)
+{
+	for (uint32_t i = 0; i < count; i++)
+		timestamp_add(first + i, (first + i) * 10);
+}
+
+/* Checks the whole chain of chunks holds timestamps 1 to |count| and |dropped| are missing. */
+static void check_timestamp_chain(const struct timestamp_table *ts, uint32_t count,
+				  uint64_t dropped)
+{
+	uint64_t seen_dropped = 0;
+	uint32_t next_id = 1;
+
+	for (; ts; ts = timestamp_next_chunk(ts)) {
+		assert_true(ts->num_entries <= ts->max_entries);
+
+		for (uint32_t i = 0; i < ts->num_entries; i++) {
+			const struct timestamp_entry *tse = &ts->entries[i];
+
+			if (tse->entry_id == TS_TABLE_CONTINUATION) {
+				/* Links only ever go into the last slot. */
+				assert_int_equal(ts->max_entries, ts->num_entries);
+				assert_int_equal(ts->num_entries - 1, i);
+			} else if (tse->entry_id == TS_TABLE_DROPPED) {
+				seen_dropped += tse->entry_stamp;
+			} else {
+				assert_int_equal(next_id, tse->entry_id);
+				assert_int_equal(next_id * 10, tse->entry_stamp);
+				next_id++;
+			}
+		}
+	}
+
+	assert_int_equal(count, next_id - 1);
+	assert_int_equal(dropped, seen_dropped);
+}
+
+void test_timestamp_cache_overflow(void **state)
+{
+	timestamp_init(0);
+	const uint32_t cache_max = glob_ts_table->max_entries;
+
+	add_timestamps(1, cache_max + 10);
+
+	/* The cache can't grow, the last slot counts what was lost instead. */
+	assert_int_equal(cache_max, glob_ts_table->num_entries);
+	assert_int_equal(TS_TABLE_DROPPED, glob_ts_table->entries[cache_max - 1].entry_id);
+	check_timestamp_chain(glob_ts_table, cache_max - 1, 11);
+}
+
+void test_timestamp_migrate_cache(void **state)
+{
+	struct timestamp_table *cache;
+
+	timestamp_init(0);
+	cache = glob_ts_table;
+	add_timestamps(1, cache->max_entries + 5);
+	cache->base_time = 1000;
+
+	timestamp_reinit(0);
+
+	/* Everything in the cache, including the dropped count, moves to CBMEM. */
+	assert_ptr_equal(cbmem_find(CBMEM_ID_TIMESTAMP), glob_ts_table);
+	assert_int_equal(1000, glob_ts_table->base_time);
+	assert_int_equal(0, cache->num_entries);
+	check_timestamp_chain(glob_ts_table, cache->max_entries - 1, 6);
+
+	/* New timestamps go after the migrated ones. */
+	timestamp_add(TS_ROMSTAGE_END, 1000);
+	assert_int_equal(TS_ROMSTAGE_END,
+			 glob_ts_table->entries[glob_ts_table->num_entries - 1].entry_id);
+}
+
+void test_timestamp_grow(void **state)
+{
+	const uint32_t count = 5 * MAX_TIMESTAMPS;
+
+	timestamp_init(0);
+	add_timestamps(1, 10);
+	timestamp_reinit(0);
+	add_timestamps(11, count - 10);
+
+	check_timestamp_chain(glob_ts_table, count, 0);
+	assert_true(glob_ts_chunks >= 4);
+	assert_ptr_equal(cbmem_find(CBMEM_ID_TIMESTAMP_EXT + glob_ts_chunks - 1), glob_ts_tail);
+
+	/* A later stage finds the whole chain again, starting from the table in CBMEM. */
+	timestamp_table_set(cbmem_find(CBMEM_ID_TIMESTAMP));
+	add_timestamps(count + 1, 1);
+	check_timestamp_chain(glob_ts_table, count + 1, 0);
+}
+
+void test_timestamp_grow_fails(void **state)
+{
+	timestamp_init(0);
+	timestamp_reinit(0);
+	fake_cbmem_full = true;
+
+	add_timestamps(1, MAX_TIMESTAMPS + 20);
+
+	check_timestamp_chain(glob_ts_table, MAX_TIMESTAMPS - 1, 21);
+	assert_null(timestamp_next_chunk(glob_ts_table));
+}
+
+void test_timestamp_rescale_chunks(void **state)
+{
+	const uint32_t count = 3 * MAX_TIMESTAMPS;
+	const struct timestamp_table *ts;
+
+	timestamp_init(0);
+	timestamp_reinit(0);
+	add_timestamps(1, count);
+
+	timestamp_rescale_table(2, 1);
+
+	/* All chunks are rescaled, but the links between them are left alone. */
+	for (ts = glob_ts_table; ts; ts = timestamp_next_chunk(ts))
+		for (uint32_t i = 0; i < ts->num_entries; i++)
+			if (ts->entries[i].entry_id != TS_TABLE_CONTINUATION)
+				assert_int_equal(ts->entries[i].entry_id * 20,
+						 ts->entries[i].entry_stamp);
+	assert_ptr_equal(cbmem_find(CBMEM_ID_TIMESTAMP_EXT + 2), glob_ts_tail);
+}
+
 int setup_timestamp_and_freq(void **state)
 {
 	dummy_timestamp_set(0);
@@ -119,6 +278,17 @@ int setup_timestamp_and_freq(void **state)
 	return 0;
 }
 
+int teardown_fake_cbmem(void **state)
+{
+	for (size_t i = 0; i < fake_cbmem_count; i++)
+		test_free(fake_cbmem[i].ptr);
+	fake_cbmem_count = 0;
+	fake_cbmem_full = false;
+	timestamp_table_set(NULL);
+
+	return 0;
+}
+
 int main(void)
 {
 	const struct CMUnitTest tests[] = {
@@ -127,6 +297,16 @@ int main(void)
 		cmocka_unit_test_setup(test_timestamp_add_now, setup_timestamp_and_freq),
 		cmocka_unit_test_setup(test_timestamp_rescale_table, setup_timestamp_and_freq),
 		cmocka_unit_test_setup(test_get_us_since_boot, setup_timestamp_and_freq),
+		cmocka_unit_test_setup_teardown(test_timestamp_cache_overflow,
+						setup_timestamp_and_freq, teardown_fake_cbmem),
+		cmocka_unit_test_setup_teardown(test_timestamp_migrate_cache,
+						setup_timestamp_and_freq, teardown_fake_cbmem),
+		cmocka_unit_test_setup_teardown(test_timestamp_grow, setup_timestamp_and_freq,
+						teardown_fake_cbmem),
+		cmocka_unit_test_setup_teardown(test_timestamp_grow_fails,
+						setup_timestamp_and_freq, teardown_fake_cbmem),
+		cmocka_unit_test_setup_teardown(test_timestamp_rescale_chunks,
+						setup_timestamp_and_freq, teardown_fake_cbmem),
 	};
 
 #if CONFIG(COLLECT_TIMESTAMPS)
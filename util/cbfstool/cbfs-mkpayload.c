@@ -63,6 +63,8 @@ int parse_elf_to_payload(const struct buffer *input, struct buffer *output,
 	int isize = 0, osize = 0;
 	int doffset = 0;
 	struct cbfs_payload_segment *segs = NULL;
+	struct compression_job *jobs = NULL;
+	int njobs = 0;
 	int i;
 	int ret = 0;
 
@@ -144,6 +146,28 @@ int parse_elf_to_payload(const struct buffer *input, struct buffer *output,
 	 */
 	segments = 0;
 
+	/* Segments are compressed independently, so do them all up front (in
+	   parallel with --jobs) and only lay them out in order below. */
+	jobs = calloc(headers, sizeof(*jobs));
+	if (jobs == NULL) {
+		ret = -1;
+		goto out;
+	}
+	for (i = 0; i < headers; i++) {
+		if (phdr[i].p_type != PT_LOAD || phdr[i].p_memsz == 0 ||
+		    phdr[i].p_filesz == 0)
+			continue;
+		jobs[njobs].in = &header[phdr[i].p_offset];
+		jobs[njobs].in_len = phdr[i].p_filesz;
+		jobs[njobs].out = malloc(phdr[i].p_filesz);
+		if (jobs[njobs++].out == NULL) {
+			ret = -1;
+			goto out;
+		}
+	}
+	compress_parallel(compress, jobs, njobs);
+	njobs = 0;
+
 	for (i = 0; i < ehdr.e_shnum; i++) {
 		char *name;
 		if (i == ehdr.e_shstrndx)
@@ -194,10 +218,9 @@ int parse_elf_to_payload(const struct buffer *input, struct buffer *output,
 		/* If the compression failed or made the section is larger,
 		   use the original stuff */
 
-		int len;
-		if (compress((char *)&header[phdr[i].p_offset],
-			     phdr[i].p_filesz, output->data + doffset, &len) ||
-		    (unsigned int)len > phdr[i].p_filesz) {
+		const struct compression_job *job = &jobs[njobs++];
+		int len = job->out_len;
+		if (job->ret || (unsigned int)len > phdr[i].p_filesz) {
 			WARN("Compression failed or would make the data bigger "
 			     "- disabled.\n");
 			segs[segments].compression = 0;
@@ -207,6 +230,7 @@ int parse_elf_to_payload(const struct buffer *input, struct buffer *output,
 		} else {
 			segs[segments].compression = algo;
 			segs[segments].len = len;
+			memcpy(output->data + doffset, job->out, len);
 		}
 
 		doffset += segs[segments].len;
@@ -222,6 +246,11 @@ int parse_elf_to_payload(const struct buffer *input, struct buffer *output,
 	xdr_segs(output, segs, segments);
 
 out:
+	if (jobs) {
+		for (i = 0; i < headers; i++)
+			free(jobs[i].out);
+		free(jobs);
+	}
 	if (segs) free(segs);
 	if (shdr) free(shdr);
 	if (phdr) free(phdr);
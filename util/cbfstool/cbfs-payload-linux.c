@@ -36,6 +36,8 @@ struct bzpayload {
 	/* Output variables. */
 	enum cbfs_compression algo;
 	comp_func_ptr compress;
+	struct compression_job jobs[MAX_NUM_SEGMENTS];
+	int num_jobs;
 	struct buffer output;
 	size_t offset;
 	struct cbfs_payload_segment *out_seg;
@@ -138,11 +140,62 @@ static int bzp_init_output(struct bzpayload *bzp, const char *name)
 	return 0;
 }
 
+/* Compress all segments up front, so that --jobs can spread them (mostly the
+ * kernel and the initrd) over several threads. */
+static int bzp_compress_segments(struct bzpayload *bzp)
+{
+	struct buffer *bufs[] = { &bzp->parameters, &bzp->kernel,
+				  &bzp->trampoline, &bzp->cmdline,
+				  &bzp->initrd };
+	size_t i;
+
+	for (i = 0; i < ARRAY_SIZE(bufs); i++) {
+		struct compression_job *job = &bzp->jobs[bzp->num_jobs];
+
+		if (buffer_size(bufs[i]) == 0)
+			continue;
+
+		job->in = buffer_get(bufs[i]);
+		job->in_len = buffer_size(bufs[i]);
+		job->out = malloc(job->in_len);
+		if (job->out == NULL)
+			return -1;
+		bzp->num_jobs++;
+	}
+
+	compress_parallel(bzp->compress, bzp->jobs, bzp->num_jobs);
+
+	return 0;
+}
+
+static const struct compression_job *bzp_find_job(struct bzpayload *bzp,
+						  struct buffer *b)
+{
+	int i;
+
+	for (i = 0; i < bzp->num_jobs; i++) {
+		if (bzp->jobs[i].in == buffer_get(b))
+			return &bzp->jobs[i];
+	}
+
+	return NULL;
+}
+
+static void bzp_free_jobs(struct bzpayload *bzp)
+{
+	int i;
+
+	for (i = 0; i < bzp->num_jobs; i++)
+		free(bzp->jobs[i].out);
+	bzp->num_jobs = 0;
+}
+
 static void bzp_output_segment(struct bzpayload *bzp, struct buffer *b,
                                uint32_t type, uint64_t load_addr)
 {
 	struct buffer out;
 	struct cbfs_payload_segment *seg;
+	const struct compression_job *job;
 	int len = 0;
 
 	/* Don't process empty buffers. */
@@ -163,7 +216,11 @@ static void bzp_output_segment(struct bzpayload *bzp, struct buffer *b,
 
 	seg->mem_len = buffer_size(b);
 	seg->offset = bzp->offset;
-	bzp->compress(buffer_get(b), buffer_size(b), buffer_get(&out), &len);
+	job = bzp_find_job(bzp, b);
+	if (job) {
+		len = job->out_len;
+		memcpy(buffer_get(&out), job->out, MIN(len, job->in_len));
+	}
 	seg->compression = bzp->algo;
 	seg->len = len;
 
@@ -291,6 +348,11 @@ int parse_bzImage_to_payload(const struct buffer *input,
 	if (bzp_init_output(&bzp, input->name) != 0)
 		return -1;
 
+	if (bzp_compress_segments(&bzp) != 0) {
+		bzp_free_jobs(&bzp);
+		return -1;
+	}
+
 	/* parameter block */
 	bzp_output_segment(&bzp, &bzp.parameters,
 	                   PAYLOAD_SEGMENT_DATA, LINUX_PARAM_LOC);
@@ -321,5 +383,6 @@ int parse_bzImage_to_payload(const struct buffer *input,
 
 	/* Serialize the segments with the correct encoding. */
 	xdr_segs(output, bzp.segs, bzp.num_segments);
+	bzp_free_jobs(&bzp);
 	return 0;
 }
@@ -353,6 +353,8 @@ int cbfs_image_from_buffer(struct cbfs_image *out, struct buffer *in,
 	return 1;
 }
 
+static void cbfs_release_index(const struct buffer *buffer);
+
 int cbfs_copy_instance(struct cbfs_image *image, struct buffer *dst)
 {
 	assert(image);
@@ -366,6 +368,7 @@ int cbfs_copy_instance(struct cbfs_image *image, struct buffer *dst)
 	align = CBFS_ALIGNMENT;
 
 	dst_entry = (struct cbfs_file *)buffer_get(dst);
+	cbfs_release_index(dst);
 
 	/* Copy non-empty files */
 	for (src_entry = cbfs_find_first_entry(image);
@@ -420,6 +423,7 @@ int cbfs_expand_to_region(struct buffer *region)
 	}
 
 	uint32_t region_sz = buffer_size(region);
+	cbfs_release_index(region);
 
 	struct cbfs_file *entry;
 	for (entry = buffer_get(region);
@@ -480,6 +484,7 @@ int cbfs_truncate_space(struct buffer *region, uint32_t *size)
 	}
 	*size = (uint8_t *)trailer - (uint8_t *)buffer_get(region);
 	memset(trailer, 0xff, buffer_size(region) - *size);
+	cbfs_release_index(region);
 
 	return 0;
 }
@@ -506,6 +511,9 @@ int cbfs_compact_instance(struct cbfs_image *image)
 	struct cbfs_file *prev;
 	struct cbfs_file *cur;
 
+	/* Files are moved around below, so the index would be stale. */
+	cbfs_release_index(&image->buffer);
+
 	/* The prev entry will always be an empty entry. */
 	prev = NULL;
 
@@ -608,10 +616,252 @@ int cbfs_image_delete(struct cbfs_image *image)
 	if (image == NULL)
 		return 0;
 
+	cbfs_release_index(&image->buffer);
 	buffer_delete(&image->buffer);
 	return 0;
 }
 
+enum cbfs_placement cbfs_placement = CBFS_PLACEMENT_FIRST_FIT;
+
+/* An empty entry, from the address of its header to that of the next entry. */
+struct cbfs_free_extent {
+	uint32_t addr;
+	uint32_t addr_next;
+};
+
+/*
+ * Index of all empty entries of an image, so that placing a file doesn't have
+ * to walk (and merge) the whole entry chain every time. The same extents are
+ * kept sorted twice: by address for first-fit and fixed offset placement, and
+ * by size (then address) for best-fit placement. Adjacent empty entries are
+ * always merged, so an extent is never followed directly by another one.
+ *
+ * Indexes belong to the buffer an image was created from rather than to the
+ * cbfs_image, so that later images of the same region (e.g. for the next
+ * command of a cbfstool batch) find the index already built.
+ */
+struct cbfs_free_space {
+	const char *data;
+	size_t size;
+	struct cbfs_free_extent *by_addr;
+	struct cbfs_free_extent *by_size;
+	size_t count;
+	size_t capacity;
+	struct cbfs_free_space *next;
+};
+
+static struct cbfs_free_space *free_spaces;
+
+static uint32_t extent_size(const struct cbfs_free_extent *e)
+{
+	return e->addr_next - e->addr;
+}
+
+/* Returns the index of the first extent in |by_addr| at or above |addr|. */
+static size_t free_space_addr_bound(const struct cbfs_free_space *fs,
+				    uint32_t addr)
+{
+	size_t lo = 0, hi = fs->count;
+
+	while (lo < hi) {
+		size_t mid = lo + (hi - lo) / 2;
+		if (fs->by_addr[mid].addr < addr)
+			lo = mid + 1;
+		else
+			hi = mid;
+	}
+	return lo;
+}
+
+/* Returns the index of the first extent in |by_size| that is at least |size|
+ * bytes large, or at |addr| or above among the ones of exactly that size. */
+static size_t free_space_size_bound(const struct cbfs_free_space *fs,
+				    uint32_t size, uint32_t addr)
+{
+	size_t lo = 0, hi = fs->count;
+
+	while (lo < hi) {
+		size_t mid = lo + (hi - lo) / 2;
+		const struct cbfs_free_extent *e = &fs->by_size[mid];
+		if (extent_size(e) < size ||
+		    (extent_size(e) == size && e->addr < addr))
+			lo = mid + 1;
+		else
+			hi = mid;
+	}
+	return lo;
+}
+
+static int free_space_insert(struct cbfs_free_space *fs, uint32_t addr,
+			     uint32_t addr_next)
+{
+	const struct cbfs_free_extent e = { addr, addr_next };
+	size_t i;
+
+	if (fs->count == fs->capacity) {
+		size_t capacity = fs->capacity ? 2 * fs->capacity : 16;
+		struct cbfs_free_extent *by_addr, *by_size;
+
+		by_addr = realloc(fs->by_addr, capacity * sizeof(e));
+		if (!by_addr)
+			return -1;
+		fs->by_addr = by_addr;
+		by_size = realloc(fs->by_size, capacity * sizeof(e));
+		if (!by_size)
+			return -1;
+		fs->by_size = by_size;
+		fs->capacity = capacity;
+	}
+
+	i = free_space_addr_bound(fs, addr);
+	memmove(&fs->by_addr[i + 1], &fs->by_addr[i],
+		(fs->count - i) * sizeof(e));
+	fs->by_addr[i] = e;
+
+	i = free_space_size_bound(fs, extent_size(&e), addr);
+	memmove(&fs->by_size[i + 1], &fs->by_size[i],
+		(fs->count - i) * sizeof(e));
+	fs->by_size[i] = e;
+
+	fs->count++;
+	return 0;
+}
+
+/* Removes the extent at index |i| of |by_addr|. */
+static void free_space_remove(struct cbfs_free_space *fs, size_t i)
+{
+	const struct cbfs_free_extent e = fs->by_addr[i];
+	size_t j = free_space_size_bound(fs, extent_size(&e), e.addr);
+
+	assert(j < fs->count && fs->by_size[j].addr == e.addr);
+	fs->count--;
+	memmove(&fs->by_addr[i], &fs->by_addr[i + 1],
+		(fs->count - i) * sizeof(e));
+	memmove(&fs->by_size[j], &fs->by_size[j + 1],
+		(fs->count - j) * sizeof(e));
+}
+
+/* Replaces the extents in [addr, addr_next) by the empty entries now found
+ * there in the image. */
+static int free_space_rescan(struct cbfs_image *image,
+			     struct cbfs_free_space *fs, uint32_t addr,
+			     uint32_t addr_next)
+{
+	struct cbfs_file *entry;
+	size_t i = free_space_addr_bound(fs, addr);
+
+	while (i < fs->count && fs->by_addr[i].addr < addr_next)
+		free_space_remove(fs, i);
+
+	for (entry = (struct cbfs_file *)(image->buffer.data + addr);
+	     cbfs_is_valid_entry(image, entry) &&
+	     cbfs_get_entry_addr(image, entry) < addr_next;
+	     entry = cbfs_find_next_entry(image, entry)) {
+		if (be32toh(entry->type) != CBFS_TYPE_NULL)
+			continue;
+		if (free_space_insert(fs, cbfs_get_entry_addr(image, entry),
+				      cbfs_get_entry_addr(image,
+					cbfs_find_next_entry(image, entry))))
+			return -1;
+	}
+	return 0;
+}
+
+static void free_space_delete(struct cbfs_free_space *fs)
+{
+	free(fs->by_addr);
+	free(fs->by_size);
+	free(fs);
+}
+
+/* Returns the existing empty entry index of the image's buffer, or NULL. */
+static struct cbfs_free_space *cbfs_find_free_space(struct cbfs_image *image)
+{
+	struct cbfs_free_space *fs;
+
+	for (fs = free_spaces; fs; fs = fs->next) {
+		if (fs->data != image->buffer.data ||
+		    fs->size != image->buffer.size)
+			continue;
+
+		/* Building the index merges all empty entries, which also grows
+		   the last one over the room cbfs_add_entry_at() left for the
+		   master header pointer. Do the same here, so that the image
+		   doesn't depend on whether an earlier command built the index. */
+		if (fs->count)
+			cbfs_merge_empty_entry(image, (struct cbfs_file *)
+				(image->buffer.data +
+				 fs->by_addr[fs->count - 1].addr), NULL);
+		return fs;
+	}
+	return NULL;
+}
+
+/* Drops the empty entry index of |buffer|, which is about to change in ways
+ * the index can't follow. */
+static void cbfs_release_index(const struct buffer *buffer)
+{
+	struct cbfs_free_space **link, *fs;
+
+	for (link = &free_spaces; (fs = *link); link = &fs->next) {
+		if (fs->data == buffer->data && fs->size == buffer->size) {
+			*link = fs->next;
+			free_space_delete(fs);
+			return;
+		}
+	}
+}
+
+void cbfs_image_release_indexes(void)
+{
+	struct cbfs_free_space *fs;
+
+	while ((fs = free_spaces)) {
+		free_spaces = fs->next;
+		free_space_delete(fs);
+	}
+}
+
+/* Returns the empty entry index of the image, building it on first use. */
+static struct cbfs_free_space *cbfs_get_free_space(struct cbfs_image *image)
+{
+	struct cbfs_free_space *fs;
+	struct cbfs_file *entry;
+
+	fs = cbfs_find_free_space(image);
+	if (fs)
+		return fs;
+
+	fs = calloc(1, sizeof(*fs));
+	if (!fs) {
+		ERROR("Out of memory\n");
+		return NULL;
+	}
+	fs->data = image->buffer.data;
+	fs->size = image->buffer.size;
+
+	// Merge empty entries so each free range is a single entry.
+	cbfs_legacy_walk(image, cbfs_merge_empty_entry, NULL);
+
+	for (entry = cbfs_find_first_entry(image);
+	     entry && cbfs_is_valid_entry(image, entry);
+	     entry = cbfs_find_next_entry(image, entry)) {
+		if (be32toh(entry->type) != CBFS_TYPE_NULL)
+			continue;
+		if (free_space_insert(fs, cbfs_get_entry_addr(image, entry),
+				      cbfs_get_entry_addr(image,
+					cbfs_find_next_entry(image, entry)))) {
+			ERROR("Out of memory\n");
+			free_space_delete(fs);
+			return NULL;
+		}
+	}
+
+	fs->next = free_spaces;
+	free_spaces = fs;
+	return fs;
+}
+
 /* Tries to add an entry with its data (CBFS_SUBHEADER) at given offset. */
 static int cbfs_add_entry_at(struct cbfs_image *image,
 			     struct cbfs_file *entry,
@@ -718,6 +968,56 @@ static int cbfs_add_entry_at(struct cbfs_image *image,
 	return 0;
 }
 
+/* Tries to add an entry into the empty entry |extent| of the index. */
+static int cbfs_add_entry_in(struct cbfs_image *image,
+			     struct cbfs_free_space *fs,
+			     const struct cbfs_free_extent *extent,
+			     struct buffer *buffer, uint32_t content_offset,
+			     struct cbfs_file *header, const size_t len_align)
+{
+	/* The extent moves around in the index once that is updated. */
+	const uint32_t addr = extent->addr, addr_next = extent->addr_next;
+	uint32_t header_size = be32toh(header->offset);
+
+	DEBUG("cbfs_add_entry: space at 0x%x+0x%x(%d) bytes\n",
+	      addr, addr_next - addr, addr_next - addr);
+
+	// Test for complicated cases
+	if (content_offset > 0) {
+		if (addr + header_size > content_offset) {
+			ERROR("Not enough space for header.\n");
+			return -1;
+		} else if (content_offset + buffer->size > addr_next) {
+			ERROR("Not enough space for content.\n");
+			return -1;
+		}
+	}
+
+	// TODO there are more few tricky cases that we may
+	// want to fit by altering offset.
+
+	if (content_offset == 0) {
+		// we tested every condition earlier under which
+		// placing the file there might fail
+		content_offset = addr + header_size;
+	}
+
+	DEBUG("section 0x%x+0x%x for content_offset 0x%x.\n",
+	      addr, addr_next - addr, content_offset);
+
+	if (cbfs_add_entry_at(image,
+			      (struct cbfs_file *)(image->buffer.data + addr),
+			      buffer->data, content_offset, header,
+			      len_align))
+		return -1;
+
+	/* If this fails, the image is fine, the index just has to be built
+	   again next time. */
+	if (free_space_rescan(image, fs, addr, addr_next))
+		cbfs_release_index(&image->buffer);
+	return 0;
+}
+
 int cbfs_add_entry(struct cbfs_image *image, struct buffer *buffer,
 		   uint32_t content_offset,
 		   struct cbfs_file *header,
@@ -736,77 +1036,59 @@ int cbfs_add_entry(struct cbfs_image *image, struct buffer *buffer,
 		return -1;
 	}
 
-	uint32_t entry_type;
-	uint32_t addr, addr_next;
-	struct cbfs_file *entry, *next;
+	struct cbfs_free_space *fs;
 	uint32_t need_size;
 	uint32_t header_size = be32toh(header->offset);
+	size_t i;
 
 	need_size = header_size + buffer->size;
 	DEBUG("cbfs_add_entry('%s'@0x%x) => need_size = %u+%zu=%u\n",
 	      name, content_offset, header_size, buffer->size, need_size);
 
-	// Merge empty entries.
-	DEBUG("(trying to merge empty entries...)\n");
-	cbfs_legacy_walk(image, cbfs_merge_empty_entry, NULL);
-
-	for (entry = cbfs_find_first_entry(image);
-	     entry && cbfs_is_valid_entry(image, entry);
-	     entry = cbfs_find_next_entry(image, entry)) {
-
-		entry_type = be32toh(entry->type);
-		if (entry_type != CBFS_TYPE_NULL)
-			continue;
-
-		addr = cbfs_get_entry_addr(image, entry);
-		next = cbfs_find_next_entry(image, entry);
-		addr_next = cbfs_get_entry_addr(image, next);
-
-		DEBUG("cbfs_add_entry: space at 0x%x+0x%x(%d) bytes\n",
-		      addr, addr_next - addr, addr_next - addr);
-
-		/* Will the file fit? Don't yet worry if we have space for a new
-		 * "empty" entry. We take care of that later.
-		 */
-		if (addr + need_size > addr_next)
-			continue;
-
-		// Test for complicated cases
-		if (content_offset > 0) {
-			if (addr_next < content_offset) {
-				DEBUG("Not for specified offset yet");
-				continue;
-			} else if (addr > content_offset) {
-				DEBUG("Exceed specified content_offset.");
-				break;
-			} else if (addr + header_size > content_offset) {
-				ERROR("Not enough space for header.\n");
-				break;
-			} else if (content_offset + buffer->size > addr_next) {
-				ERROR("Not enough space for content.\n");
-				break;
-			}
-		}
-
-		// TODO there are more few tricky cases that we may
-		// want to fit by altering offset.
+	fs = cbfs_get_free_space(image);
+	if (!fs)
+		return -1;
 
-		if (content_offset == 0) {
-			// we tested every condition earlier under which
-			// placing the file there might fail
-			content_offset = addr + header_size;
+	/* Will the file fit? Don't yet worry if we have space for a new "empty"
+	 * entry. We take care of that later.
+	 */
+	if (content_offset > 0) {
+		/* Only the empty entry containing content_offset (or ending
+		 * right at it) can hold the file. */
+		i = free_space_addr_bound(fs, content_offset);
+		if (i > 0 && fs->by_addr[i - 1].addr_next >= content_offset)
+			i--;
+		if (i < fs->count && fs->by_addr[i].addr <= content_offset &&
+		    extent_size(&fs->by_addr[i]) >= need_size) {
+			if (cbfs_add_entry_in(image, fs, &fs->by_addr[i], buffer,
+					      content_offset, header,
+					      len_align) == 0)
+				return 0;
+		} else {
+			DEBUG("No empty entry at specified content_offset.");
 		}
+		goto fail;
+	}
 
-		DEBUG("section 0x%x+0x%x for content_offset 0x%x.\n",
-		      addr, addr_next - addr, content_offset);
+	if (cbfs_placement == CBFS_PLACEMENT_BEST_FIT) {
+		i = free_space_size_bound(fs, need_size, 0);
+		if (i < fs->count &&
+		    cbfs_add_entry_in(image, fs, &fs->by_size[i], buffer, 0,
+				      header, len_align) == 0)
+			return 0;
+		/* Otherwise fall back to the lowest empty entry that fits. */
+	}
 
-		if (cbfs_add_entry_at(image, entry, buffer->data,
-				      content_offset, header, len_align) == 0) {
+	for (i = 0; i < fs->count; i++) {
+		if (extent_size(&fs->by_addr[i]) < need_size)
+			continue;
+		if (cbfs_add_entry_in(image, fs, &fs->by_addr[i], buffer, 0,
+				      header, len_align) == 0)
 			return 0;
-		}
 		break;
 	}
 
+fail:
 	ERROR("Could not add [%s, %zd bytes (%zd KB)@0x%x]; too big?\n",
 	      buffer->name, buffer->size, buffer->size / 1024, content_offset);
 	return -1;
@@ -1315,7 +1597,25 @@ int cbfs_remove_entry(struct cbfs_image *image, const char *name)
 	DEBUG("cbfs_remove_entry: Removed %s @ 0x%x\n",
 	      entry->filename, cbfs_get_entry_addr(image, entry));
 	entry->type = htobe32(CBFS_TYPE_DELETED);
-	cbfs_legacy_walk(image, cbfs_merge_empty_entry, NULL);
+
+	struct cbfs_free_space *fs = cbfs_find_free_space(image);
+	if (!fs) {
+		cbfs_legacy_walk(image, cbfs_merge_empty_entry, NULL);
+		return 0;
+	}
+
+	/* All other empty entries are merged already, so only the ones right
+	   before and after this one can have to be merged with it. */
+	uint32_t addr = cbfs_get_entry_addr(image, entry);
+	size_t i = free_space_addr_bound(fs, addr);
+	if (i > 0 && fs->by_addr[i - 1].addr_next == addr) {
+		addr = fs->by_addr[i - 1].addr;
+		entry = (struct cbfs_file *)(image->buffer.data + addr);
+	}
+	cbfs_merge_empty_entry(image, entry, NULL);
+	if (free_space_rescan(image, fs, addr, cbfs_get_entry_addr(image,
+				cbfs_find_next_entry(image, entry))))
+		cbfs_release_index(&image->buffer);
 	return 0;
 }
 
@@ -1942,7 +2242,8 @@ static size_t absolute_align(const struct cbfs_image *image, size_t val,
 int32_t cbfs_locate_entry(struct cbfs_image *image, size_t size,
 			  size_t page_size, size_t align, size_t metadata_size)
 {
-	struct cbfs_file *entry;
+	struct cbfs_free_space *fs;
+	size_t i;
 	size_t need_len;
 	size_t addr, addr_next, addr2, addr3, offset;
 
@@ -1966,7 +2267,9 @@ int32_t cbfs_locate_entry(struct cbfs_image *image, size_t size,
 	need_len = metadata_size + size;
 
 	// Merge empty entries to build get max available space.
-	cbfs_legacy_walk(image, cbfs_merge_empty_entry, NULL);
+	fs = cbfs_get_free_space(image);
+	if (!fs)
+		return -1;
 
 	/* Three cases of content location on memory page:
 	 * case 1.
@@ -1989,17 +2292,20 @@ int32_t cbfs_locate_entry(struct cbfs_image *image, size_t size,
 	 * For stage targets, the address is also used to re-link stage before
 	 * being added into CBFS.
 	 */
-	for (entry = cbfs_find_first_entry(image);
-	     entry && cbfs_is_valid_entry(image, entry);
-	     entry = cbfs_find_next_entry(image, entry)) {
+	/* Best-fit tries the empty entries from the smallest that is large
+	 * enough, first-fit from the lowest one. */
+	if (cbfs_placement == CBFS_PLACEMENT_BEST_FIT)
+		i = free_space_size_bound(fs, need_len, 0);
+	else
+		i = 0;
 
-		uint32_t type = be32toh(entry->type);
-		if (type != CBFS_TYPE_NULL)
-			continue;
+	for (; i < fs->count; i++) {
+		const struct cbfs_free_extent *extent =
+			cbfs_placement == CBFS_PLACEMENT_BEST_FIT ?
+			&fs->by_size[i] : &fs->by_addr[i];
 
-		addr = cbfs_get_entry_addr(image, entry);
-		addr_next = cbfs_get_entry_addr(image, cbfs_find_next_entry(
-				image, entry));
+		addr = extent->addr;
+		addr_next = extent->addr_next;
 		if (addr_next - addr < need_len)
 			continue;
 
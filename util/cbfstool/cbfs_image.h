@@ -19,6 +19,17 @@ struct cbfs_image {
 	struct cbfs_header header;
 };
 
+/* How cbfs_add_entry() and cbfs_locate_entry() pick an empty entry for files
+ * that aren't placed at a fixed offset. */
+enum cbfs_placement {
+	/* The lowest empty entry the file fits in. */
+	CBFS_PLACEMENT_FIRST_FIT,
+	/* The smallest empty entry the file fits in, to reduce fragmentation. */
+	CBFS_PLACEMENT_BEST_FIT,
+};
+
+extern enum cbfs_placement cbfs_placement;
+
 /* Given the string name of a compression algorithm, return the corresponding
  * enum comp_algo if it's supported, or a number < 0 otherwise. */
 int cbfs_parse_comp_algo(const char *name);
@@ -83,6 +94,12 @@ int cbfs_truncate_space(struct buffer *region, uint32_t *size);
 /* Releases the CBFS image. Returns 0 on success, otherwise non-zero. */
 int cbfs_image_delete(struct cbfs_image *image);
 
+/* The index of empty entries that cbfs_add_entry(), cbfs_remove_entry() and
+ * cbfs_locate_entry() keep is tied to the buffer of the image, and is reused
+ * by later images of the same buffer. Releases all of them, which has to be
+ * done after a CBFS was changed by anything other than these functions. */
+void cbfs_image_release_indexes(void);
+
 /* Returns a pointer to entry by name, or NULL if name is not found. */
 struct cbfs_file *cbfs_get_entry(struct cbfs_image *image, const char *name);
 
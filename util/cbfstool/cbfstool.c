@@ -118,6 +118,20 @@ static struct param {
 	.u64val = -1,
 };
 
+/*
+ * State of a running "batch" command. While it is active, the commands it runs
+ * only modify the image in memory: the regions they touch are recorded and
+ * written back once, and the metadata and FMAP hash updates that would follow
+ * every single command are only flagged and performed once at the end.
+ */
+static struct {
+	bool active;
+	bool metadata_hash_pending;
+	bool fmap_hash_pending;
+	char **regions;
+	size_t num_regions;
+} batch;
+
 /*
  * This "metadata_hash cache" caches the value and location of the CBFS metadata
  * hash embedded in the bootblock when CBFS verification is enabled. The first
@@ -135,14 +149,14 @@ struct mh_cache {
 	bool initialized;
 };
 
+static struct mh_cache mh_cache;
+
 static struct mh_cache *get_mh_cache(void)
 {
-	static struct mh_cache mhc;
-
-	if (mhc.initialized)
-		return &mhc;
+	if (mh_cache.initialized)
+		return &mh_cache;
 
-	mhc.initialized = true;
+	mh_cache.initialized = true;
 
 	const struct fmap *fmap = partitioned_file_get_fmap(param.image_file);
 	if (!fmap)
@@ -156,7 +170,7 @@ static struct mh_cache *get_mh_cache(void)
 		if (!partitioned_file_read_region(&buffer, param.image_file,
 						  SECTION_NAME_BOOTBLOCK))
 			goto no_metadata_hash;
-		mhc.region = SECTION_NAME_BOOTBLOCK;
+		mh_cache.region = SECTION_NAME_BOOTBLOCK;
 		offset = 0;
 		size = buffer.size;
 	} else {
@@ -165,7 +179,7 @@ static struct mh_cache *get_mh_cache(void)
 		if (!partitioned_file_read_region(&buffer, param.image_file,
 						  SECTION_NAME_PRIMARY_CBFS))
 			goto no_metadata_hash;
-		mhc.region = SECTION_NAME_PRIMARY_CBFS;
+		mh_cache.region = SECTION_NAME_PRIMARY_CBFS;
 		if (cbfs_image_from_buffer(&cbfs, &buffer, param.headeroffset))
 			goto no_metadata_hash;
 		mh_container = cbfs_get_entry(&cbfs, "bootblock");
@@ -191,16 +205,16 @@ static struct mh_cache *get_mh_cache(void)
 			      anchor->cbfs_hash.algo);
 			goto no_metadata_hash;
 		}
-		mhc.cbfs_hash = anchor->cbfs_hash;
-		mhc.offset = (void *)anchor - buffer_get(&buffer);
-		mhc.fixup = platform_fixups_probe(&buffer, mhc.offset,
-						  mhc.region);
-		return &mhc;
+		mh_cache.cbfs_hash = anchor->cbfs_hash;
+		mh_cache.offset = (void *)anchor - buffer_get(&buffer);
+		mh_cache.fixup = platform_fixups_probe(&buffer, mh_cache.offset,
+						       mh_cache.region);
+		return &mh_cache;
 	}
 
 no_metadata_hash:
-	mhc.cbfs_hash.algo = VB2_HASH_INVALID;
-	return &mhc;
+	mh_cache.cbfs_hash.algo = VB2_HASH_INVALID;
+	return &mh_cache;
 }
 
 static void update_and_info(const char *name, void *dst, void *src, size_t size)
@@ -241,13 +255,8 @@ static int update_anchor(struct mh_cache *mhc, uint8_t *fmap_hash)
 
 }
 
-/* This should be called after every time CBFS metadata might have changed. It
-   will recalculate and update the metadata hash in the bootblock if needed. */
-static int maybe_update_metadata_hash(struct cbfs_image *cbfs)
+static int update_metadata_hash(struct cbfs_image *cbfs)
 {
-	if (strcmp(param.region_name, SECTION_NAME_PRIMARY_CBFS))
-		return 0;  /* Metadata hash only embedded in primary CBFS. */
-
 	struct mh_cache *mhc = get_mh_cache();
 	if (mhc->cbfs_hash.algo == VB2_HASH_INVALID)
 		return 0;
@@ -262,6 +271,35 @@ static int maybe_update_metadata_hash(struct cbfs_image *cbfs)
 	return update_anchor(mhc, NULL);
 }
 
+/* This should be called after every time CBFS metadata might have changed. It
+   will recalculate and update the metadata hash in the bootblock if needed. */
+static int maybe_update_metadata_hash(struct cbfs_image *cbfs)
+{
+	if (strcmp(param.region_name, SECTION_NAME_PRIMARY_CBFS))
+		return 0;  /* Metadata hash only embedded in primary CBFS. */
+
+	if (batch.active) {
+		batch.metadata_hash_pending = true;
+		return 0;
+	}
+
+	return update_metadata_hash(cbfs);
+}
+
+static int update_fmap_hash(void)
+{
+	struct mh_cache *mhc = get_mh_cache();
+	if (mhc->cbfs_hash.algo == VB2_HASH_INVALID)
+		return 0;
+
+	struct vb2_hash fmap_hash;
+	const struct fmap *fmap = partitioned_file_get_fmap(param.image_file);
+	if (!fmap || vb2_hash_calculate(false, fmap, fmap_size(fmap),
+					mhc->cbfs_hash.algo, &fmap_hash))
+		return -1;
+	return update_anchor(mhc, fmap_hash.raw);
+}
+
 /* This should be called after every time the FMAP or the bootblock itself might
    have changed, and will write the new FMAP hash into the metadata hash anchor
    in the bootblock if required (usually when the bootblock is first added). */
@@ -273,16 +311,12 @@ static int maybe_update_fmap_hash(void)
 	    param.type != CBFS_TYPE_AMDFW)
 		return 0;	/* FMAP and bootblock didn't change. */
 
-	struct mh_cache *mhc = get_mh_cache();
-	if (mhc->cbfs_hash.algo == VB2_HASH_INVALID)
+	if (batch.active) {
+		batch.fmap_hash_pending = true;
 		return 0;
+	}
 
-	struct vb2_hash fmap_hash;
-	const struct fmap *fmap = partitioned_file_get_fmap(param.image_file);
-	if (!fmap || vb2_hash_calculate(false, fmap, fmap_size(fmap),
-					mhc->cbfs_hash.algo, &fmap_hash))
-		return -1;
-	return update_anchor(mhc, fmap_hash.raw);
+	return update_fmap_hash();
 }
 
 static bool verification_exclude(enum cbfs_type type)
@@ -1778,6 +1812,8 @@ static int cbfs_truncate(void)
 	return result;
 }
 
+static int cbfs_batch(void);
+
 static const struct command commands[] = {
 	{"add", "H:r:f:n:t:c:b:a:p:yvA:j:gh?", cbfs_add, true, true},
 	{"add-flat-binary", "H:r:f:n:l:e:c:b:p:vA:gh?", cbfs_add_flat_binary,
@@ -1788,6 +1824,7 @@ static const struct command commands[] = {
 				true, true},
 	{"add-int", "H:r:i:n:b:vgh?", cbfs_add_integer, true, true},
 	{"add-master-header", "H:r:vh?j:", cbfs_add_master_header, true, true},
+	{"batch", "f:vh?", cbfs_batch, false, true},
 	{"compact", "r:h?", cbfs_compact, true, true},
 	{"copy", "r:R:h?", cbfs_copy, true, true},
 	{"create", "M:r:s:B:b:H:o:m:vh?", cbfs_create, true, true},
@@ -1806,6 +1843,8 @@ enum {
 	LONGOPT_START = 256,
 	LONGOPT_IBB = LONGOPT_START,
 	LONGOPT_MMAP,
+	LONGOPT_JOBS,
+	LONGOPT_BEST_FIT,
 	LONGOPT_END,
 };
 
@@ -1848,6 +1887,8 @@ static struct option long_options[] = {
 	{"unprocessed",   no_argument,       0, 'U' },
 	{"ibb",           no_argument,       0, LONGOPT_IBB },
 	{"mmap",          required_argument, 0, LONGOPT_MMAP },
+	{"jobs",          required_argument, 0, LONGOPT_JOBS },
+	{"best-fit",      no_argument,       0, LONGOPT_BEST_FIT },
 	{NULL,            0,                 0,  0  }
 };
 
@@ -1950,6 +1991,10 @@ static void usage(char *name)
 	     "  -U               Unprocessed; don't decompress or make ELF\n"
 	     "  -v               Provide verbose output (-v=INFO -vv=DEBUG output)\n"
 	     "  -h               Display this help message\n\n"
+	     "  --jobs N         Compress independent parts of a file (e.g. payload\n"
+	     "                   segments) on up to N threads\n"
+	     "  --best-fit       Place files in the smallest free space they fit\n"
+	     "                   in instead of the first one\n"
 	     "  --ext-win-base   Base of extended decode window in host address\n"
 	     "                   space(x86 only)\n"
 	     "  --ext-win-size   Size of extended decode window in host address\n"
@@ -1985,6 +2030,10 @@ static void usage(char *name)
 			"Add a legacy CBFS master header\n"
 	     " remove [-r image,regions] -n NAME                           "
 			"Remove a component\n"
+	     " batch -f FILE                                               "
+			"Run the commands in FILE (one per line, - for stdin)\n"
+	     "                                                             "
+			"on the image and write it back once at the end\n"
 	     " compact -r image,regions                                    "
 			"Defragment CBFS image.\n"
 	     " copy -r image,regions -R source-region                      "
@@ -2056,251 +2105,565 @@ static bool valid_opt(size_t i, int c)
 	return false;
 }
 
-int main(int argc, char **argv)
+/* Parses the options of commands[i] from argv, starting at optind, into param. */
+static int parse_command_options(size_t i, int argc, char **argv)
 {
-	size_t i;
 	int c;
 
-	if (argc < 3) {
-		usage(argv[0]);
-		return 1;
-	}
-
-	char *image_name = argv[1];
-	char *cmd = argv[2];
-	optind += 2;
+	while (1) {
+		char *suffix = NULL;
+		int option_index = 0;
 
-	for (i = 0; i < ARRAY_SIZE(commands); i++) {
-		if (strcmp(cmd, commands[i].name) != 0)
-			continue;
+		c = getopt_long(argc, argv, commands[i].optstring,
+					long_options, &option_index);
+		if (c == -1) {
+			if (optind < argc) {
+				ERROR("%s: excessive argument -- '%s'"
+					"\n", argv[0], argv[optind]);
+				return 1;
+			}
+			break;
+		}
 
-		while (1) {
-			char *suffix = NULL;
-			int option_index = 0;
+		/* Filter out illegal long options */
+		if (!valid_opt(i, c)) {
+			ERROR("%s: invalid option -- '%d'\n",
+			      argv[0], c);
+			c = '?';
+		}
 
-			c = getopt_long(argc, argv, commands[i].optstring,
-						long_options, &option_index);
-			if (c == -1) {
-				if (optind < argc) {
-					ERROR("%s: excessive argument -- '%s'"
-						"\n", argv[0], argv[optind]);
-					return 1;
-				}
+		switch(c) {
+		case 'n':
+			param.name = optarg;
+			break;
+		case 't':
+			if (intfiletype(optarg) != ((uint64_t) - 1))
+				param.type = intfiletype(optarg);
+			else
+				param.type = strtoul(optarg, NULL, 0);
+			if (param.type == 0)
+				WARN("Unknown type '%s' ignored\n",
+						optarg);
+			break;
+		case 'c': {
+			if (strcmp(optarg, "precompression") == 0) {
+				param.precompression = 1;
 				break;
 			}
-
-			/* Filter out illegal long options */
-			if (!valid_opt(i, c)) {
-				ERROR("%s: invalid option -- '%d'\n",
-				      argv[0], c);
-				c = '?';
+			int algo = cbfs_parse_comp_algo(optarg);
+			if (algo >= 0)
+				param.compression = algo;
+			else
+				WARN("Unknown compression '%s' ignored.\n",
+								optarg);
+			break;
+		}
+		case 'A': {
+			if (!vb2_lookup_hash_alg(optarg, &param.hash)) {
+				ERROR("Unknown hash algorithm '%s'.\n",
+					optarg);
+				return 1;
 			}
-
-			switch(c) {
-			case 'n':
-				param.name = optarg;
-				break;
-			case 't':
-				if (intfiletype(optarg) != ((uint64_t) - 1))
-					param.type = intfiletype(optarg);
-				else
-					param.type = strtoul(optarg, NULL, 0);
-				if (param.type == 0)
-					WARN("Unknown type '%s' ignored\n",
-							optarg);
-				break;
-			case 'c': {
-				if (strcmp(optarg, "precompression") == 0) {
-					param.precompression = 1;
-					break;
-				}
-				int algo = cbfs_parse_comp_algo(optarg);
-				if (algo >= 0)
-					param.compression = algo;
-				else
-					WARN("Unknown compression '%s' ignored.\n",
-									optarg);
-				break;
+			break;
+		}
+		case 'M':
+			param.fmap = optarg;
+			break;
+		case 'r':
+			param.region_name = optarg;
+			break;
+		case 'R':
+			param.source_region = optarg;
+			break;
+		case 'b':
+			param.baseaddress_input = strtoll(optarg, &suffix, 0);
+			if (!*optarg || (suffix && *suffix)) {
+				ERROR("Invalid base address '%s'.\n",
+					optarg);
+				return 1;
 			}
-			case 'A': {
-				if (!vb2_lookup_hash_alg(optarg, &param.hash)) {
-					ERROR("Unknown hash algorithm '%s'.\n",
-						optarg);
-					return 1;
-				}
-				break;
+			// baseaddress may be zero on non-x86, so we
+			// need an explicit "baseaddress_assigned".
+			param.baseaddress_assigned = 1;
+			break;
+		case 'l':
+			param.loadaddress = strtoul(optarg, &suffix, 0);
+			if (!*optarg || (suffix && *suffix)) {
+				ERROR("Invalid load address '%s'.\n",
+					optarg);
+				return 1;
 			}
-			case 'M':
-				param.fmap = optarg;
-				break;
-			case 'r':
-				param.region_name = optarg;
-				break;
-			case 'R':
-				param.source_region = optarg;
-				break;
-			case 'b':
-				param.baseaddress_input = strtoll(optarg, &suffix, 0);
-				if (!*optarg || (suffix && *suffix)) {
-					ERROR("Invalid base address '%s'.\n",
-						optarg);
-					return 1;
-				}
-				// baseaddress may be zero on non-x86, so we
-				// need an explicit "baseaddress_assigned".
-				param.baseaddress_assigned = 1;
-				break;
-			case 'l':
-				param.loadaddress = strtoul(optarg, &suffix, 0);
-				if (!*optarg || (suffix && *suffix)) {
-					ERROR("Invalid load address '%s'.\n",
-						optarg);
-					return 1;
-				}
-				break;
-			case 'e':
-				param.entrypoint = strtoul(optarg, &suffix, 0);
-				if (!*optarg || (suffix && *suffix)) {
-					ERROR("Invalid entry point '%s'.\n",
-						optarg);
-					return 1;
-				}
-				break;
-			case 's':
-				param.size = strtoul(optarg, &suffix, 0);
-				if (!*optarg) {
-					ERROR("Empty size specified.\n");
-					return 1;
-				}
-				switch (tolower((int)suffix[0])) {
-				case 'k':
-					param.size *= 1024;
-					break;
-				case 'm':
-					param.size *= 1024 * 1024;
-					break;
-				case '\0':
-					break;
-				default:
-					ERROR("Invalid suffix for size '%s'.\n",
-						optarg);
-					return 1;
-				}
-				break;
-			case 'B':
-				param.bootblock = optarg;
-				break;
-			case 'H':
-				param.headeroffset_input = strtoll(optarg, &suffix, 0);
-				if (!*optarg || (suffix && *suffix)) {
-					ERROR("Invalid header offset '%s'.\n",
-						optarg);
-					return 1;
-				}
-				param.headeroffset_assigned = 1;
-				break;
-			case 'a':
-				param.alignment = strtoul(optarg, &suffix, 0);
-				if (!*optarg || (suffix && *suffix)) {
-					ERROR("Invalid alignment '%s'.\n",
-						optarg);
-					return 1;
-				}
-				break;
-			case 'p':
-				param.padding = strtoul(optarg, &suffix, 0);
-				if (!*optarg || (suffix && *suffix)) {
-					ERROR("Invalid pad size '%s'.\n",
-						optarg);
-					return 1;
-				}
-				break;
-			case 'Q':
-				param.force_pow2_pagesize = 1;
-				break;
-			case 'o':
-				param.cbfsoffset_input = strtoll(optarg, &suffix, 0);
-				if (!*optarg || (suffix && *suffix)) {
-					ERROR("Invalid cbfs offset '%s'.\n",
-						optarg);
-					return 1;
-				}
-				param.cbfsoffset_assigned = 1;
-				break;
-			case 'f':
-				param.filename = optarg;
-				break;
-			case 'F':
-				param.force = 1;
-				break;
-			case 'i':
-				param.u64val = strtoull(optarg, &suffix, 0);
-				param.u64val_assigned = 1;
-				if (!*optarg || (suffix && *suffix)) {
-					ERROR("Invalid int parameter '%s'.\n",
-						optarg);
-					return 1;
-				}
-				break;
-			case 'u':
-				param.fill_partial_upward = true;
-				break;
-			case 'd':
-				param.fill_partial_downward = true;
-				break;
-			case 'w':
-				param.show_immutable = true;
-				break;
-			case 'j':
-				param.topswap_size = strtol(optarg, NULL, 0);
-				if (!is_valid_topswap())
-					return 1;
-				break;
-			case 'q':
-				param.ucode_region = optarg;
-				break;
-			case 'v':
-				verbose++;
-				break;
-			case 'm':
-				param.arch = string_to_arch(optarg);
-				break;
-			case 'I':
-				param.initrd = optarg;
-				break;
-			case 'C':
-				param.cmdline = optarg;
-				break;
-			case 'S':
-				param.ignore_sections = optarg;
-				break;
-			case 'y':
-				param.stage_xip = true;
-				break;
-			case 'g':
-				param.autogen_attr = true;
-				break;
+			break;
+		case 'e':
+			param.entrypoint = strtoul(optarg, &suffix, 0);
+			if (!*optarg || (suffix && *suffix)) {
+				ERROR("Invalid entry point '%s'.\n",
+					optarg);
+				return 1;
+			}
+			break;
+		case 's':
+			param.size = strtoul(optarg, &suffix, 0);
+			if (!*optarg) {
+				ERROR("Empty size specified.\n");
+				return 1;
+			}
+			switch (tolower((int)suffix[0])) {
 			case 'k':
-				param.machine_parseable = true;
-				break;
-			case 'U':
-				param.unprocessed = true;
+				param.size *= 1024;
 				break;
-			case LONGOPT_IBB:
-				param.ibb = true;
+			case 'm':
+				param.size *= 1024 * 1024;
 				break;
-			case LONGOPT_MMAP:
-				if (decode_mmap_arg(optarg))
-					return 1;
+			case '\0':
 				break;
-			case 'h':
-			case '?':
-				usage(argv[0]);
-				return 1;
 			default:
-				break;
+				ERROR("Invalid suffix for size '%s'.\n",
+					optarg);
+				return 1;
+			}
+			break;
+		case 'B':
+			param.bootblock = optarg;
+			break;
+		case 'H':
+			param.headeroffset_input = strtoll(optarg, &suffix, 0);
+			if (!*optarg || (suffix && *suffix)) {
+				ERROR("Invalid header offset '%s'.\n",
+					optarg);
+				return 1;
+			}
+			param.headeroffset_assigned = 1;
+			break;
+		case 'a':
+			param.alignment = strtoul(optarg, &suffix, 0);
+			if (!*optarg || (suffix && *suffix)) {
+				ERROR("Invalid alignment '%s'.\n",
+					optarg);
+				return 1;
+			}
+			break;
+		case 'p':
+			param.padding = strtoul(optarg, &suffix, 0);
+			if (!*optarg || (suffix && *suffix)) {
+				ERROR("Invalid pad size '%s'.\n",
+					optarg);
+				return 1;
 			}
+			break;
+		case 'Q':
+			param.force_pow2_pagesize = 1;
+			break;
+		case 'o':
+			param.cbfsoffset_input = strtoll(optarg, &suffix, 0);
+			if (!*optarg || (suffix && *suffix)) {
+				ERROR("Invalid cbfs offset '%s'.\n",
+					optarg);
+				return 1;
+			}
+			param.cbfsoffset_assigned = 1;
+			break;
+		case 'f':
+			param.filename = optarg;
+			break;
+		case 'F':
+			param.force = 1;
+			break;
+		case 'i':
+			param.u64val = strtoull(optarg, &suffix, 0);
+			param.u64val_assigned = 1;
+			if (!*optarg || (suffix && *suffix)) {
+				ERROR("Invalid int parameter '%s'.\n",
+					optarg);
+				return 1;
+			}
+			break;
+		case 'u':
+			param.fill_partial_upward = true;
+			break;
+		case 'd':
+			param.fill_partial_downward = true;
+			break;
+		case 'w':
+			param.show_immutable = true;
+			break;
+		case 'j':
+			param.topswap_size = strtol(optarg, NULL, 0);
+			if (!is_valid_topswap())
+				return 1;
+			break;
+		case 'q':
+			param.ucode_region = optarg;
+			break;
+		case 'v':
+			verbose++;
+			break;
+		case 'm':
+			param.arch = string_to_arch(optarg);
+			break;
+		case 'I':
+			param.initrd = optarg;
+			break;
+		case 'C':
+			param.cmdline = optarg;
+			break;
+		case 'S':
+			param.ignore_sections = optarg;
+			break;
+		case 'y':
+			param.stage_xip = true;
+			break;
+		case 'g':
+			param.autogen_attr = true;
+			break;
+		case 'k':
+			param.machine_parseable = true;
+			break;
+		case 'U':
+			param.unprocessed = true;
+			break;
+		case LONGOPT_IBB:
+			param.ibb = true;
+			break;
+		case LONGOPT_MMAP:
+			if (decode_mmap_arg(optarg))
+				return 1;
+			break;
+		case LONGOPT_JOBS:
+			compression_jobs = strtoul(optarg, &suffix, 0);
+			if (!*optarg || (suffix && *suffix) ||
+			    !compression_jobs) {
+				ERROR("Invalid number of jobs '%s'.\n",
+					optarg);
+				return 1;
+			}
+			break;
+		case LONGOPT_BEST_FIT:
+			cbfs_placement = CBFS_PLACEMENT_BEST_FIT;
+			break;
+		case 'h':
+		case '?':
+			usage(argv[0]);
+			return 1;
+		default:
+			break;
+		}
+	}
+
+	return 0;
+}
+
+/* Adds |region| to the regions written back at the end of the batch. */
+static int batch_add_region(const char *region)
+{
+	for (size_t i = 0; i < batch.num_regions; i++)
+		if (!strcmp(batch.regions[i], region))
+			return 0;
+
+	char **regions = realloc(batch.regions,
+				 (batch.num_regions + 1) * sizeof(*regions));
+	if (!regions) {
+		ERROR("Out of memory\n");
+		return 1;
+	}
+	batch.regions = regions;
+	batch.regions[batch.num_regions] = strdup(region);
+	if (!batch.regions[batch.num_regions]) {
+		ERROR("Out of memory\n");
+		return 1;
+	}
+	batch.num_regions++;
+	return 0;
+}
+
+/*
+ * Runs commands[i] on every region in the comma-separated param.region_name
+ * list and writes the regions it modifies back to param.image_file, or only
+ * records them when running as part of a batch.
+ */
+static int run_command(size_t i)
+{
+	unsigned num_regions = 1;
+	for (const char *list = strchr(param.region_name, ','); list;
+					list = strchr(list + 1, ','))
+		++num_regions;
+
+	// If the action needs to read an image region, as indicated by
+	// having accesses_region set in its command struct, that
+	// region's buffer struct will be stored here and the client
+	// will receive a pointer to it via param.image_region. It
+	// need not write the buffer back to the image file itself,
+	// since this behavior can be requested via its modifies_region
+	// field. Additionally, it should never free the region buffer,
+	// as that is performed automatically once it completes.
+	struct buffer image_regions[num_regions];
+	memset(image_regions, 0, sizeof(image_regions));
+
+	bool seen_primary_cbfs = false;
+	char region_name_scratch[strlen(param.region_name) + 1];
+	strcpy(region_name_scratch, param.region_name);
+	param.region_name = strtok(region_name_scratch, ",");
+	for (unsigned region = 0; region < num_regions; ++region) {
+		if (!param.region_name) {
+			ERROR("Encountered illegal degenerate region name in -r list\n");
+			ERROR("The image will be left unmodified.\n");
+			return 1;
+		}
+
+		if (strcmp(param.region_name, SECTION_NAME_PRIMARY_CBFS)
+								== 0)
+			seen_primary_cbfs = true;
+
+		param.image_region = image_regions + region;
+		if (dispatch_command(commands[i]))
+			return 1;
+
+		if (batch.active && commands[i].modifies_region &&
+		    batch_add_region(param.region_name))
+			return 1;
+
+		param.region_name = strtok(NULL, ",");
+	}
+
+	if (commands[i].function == cbfs_create && !seen_primary_cbfs) {
+		ERROR("The creation -r list must include the mandatory '%s' section.\n",
+					SECTION_NAME_PRIMARY_CBFS);
+		ERROR("The image will be left unmodified.\n");
+		return 1;
+	}
+
+	if (commands[i].modifies_region && !batch.active) {
+		assert(param.image_file);
+		for (unsigned region = 0; region < num_regions;
+							++region) {
+
+			if (!partitioned_file_write_region(
+						param.image_file,
+					image_regions + region))
+				return 1;
+		}
+	}
+
+	return 0;
+}
+
+
+#define BATCH_MAX_ARGS 64
+
+/*
+ * Splits |line| in place into at most |max_args| whitespace separated words,
+ * which may be quoted with ' or ". Everything after an unquoted # is ignored.
+ * Returns the number of words, or -1 on error.
+ */
+static int batch_split_line(char *line, char **words, int max_args)
+{
+	int count = 0;
+
+	while (1) {
+		while (isspace((unsigned char)*line))
+			line++;
+		if (!*line || *line == '#')
+			return count;
+		if (count == max_args)
+			return -1;
+
+		char *dst = line;
+		char quote = 0;
+		words[count++] = dst;
+		while (*line && (quote || !isspace((unsigned char)*line))) {
+			if (quote && *line == quote) {
+				quote = 0;
+				line++;
+			} else if (!quote && (*line == '"' || *line == '\'')) {
+				quote = *line++;
+			} else {
+				*dst++ = *line++;
+			}
+		}
+		if (quote)
+			return -1;
+		if (*line)
+			line++;
+		*dst = '\0';
+	}
+}
+
+/* Whether |function| changes CBFS entries only through cbfs_add_entry() and
+   cbfs_remove_entry(), which keep the index of empty entries up to date. */
+static bool batch_keeps_indexes(int (*function)(void))
+{
+	return function == cbfs_add || function == cbfs_add_flat_binary ||
+	       function == cbfs_add_payload || function == cbfs_add_stage ||
+	       function == cbfs_add_integer || function == cbfs_remove;
+}
+
+/* Performs the hash updates and region writes deferred while in the batch. */
+static int batch_finish(void)
+{
+	if (batch.metadata_hash_pending &&
+	    get_mh_cache()->cbfs_hash.algo != VB2_HASH_INVALID) {
+		struct buffer buffer;
+		struct cbfs_image image;
+
+		param.region_name = SECTION_NAME_PRIMARY_CBFS;
+		if (!partitioned_file_read_region(&buffer, param.image_file,
+						  param.region_name))
+			return 1;
+		if (cbfs_image_from_buffer(&image, &buffer, param.headeroffset))
+			return 1;
+		if (update_metadata_hash(&image))
+			return 1;
+	}
+
+	if (batch.fmap_hash_pending && update_fmap_hash())
+		return 1;
+
+	for (size_t i = 0; i < batch.num_regions; i++) {
+		struct buffer buffer;
+
+		if (!partitioned_file_read_region(&buffer, param.image_file,
+						  batch.regions[i]) ||
+		    !partitioned_file_write_region(param.image_file, &buffer))
+			return 1;
+	}
+
+	return 0;
+}
+
+static const struct param *param_defaults;
+
+/*
+ * Runs every command listed in param.filename on the image as if cbfstool had
+ * been invoked once per line, but only reads and writes the image file once.
+ * If any command fails, the image is left unmodified.
+ */
+static int cbfs_batch(void)
+{
+	partitioned_file_t *image_file = param.image_file;
+	const char *filename = param.filename;
+	FILE *file;
+	char *line = NULL;
+	size_t line_size = 0;
+	unsigned int line_num = 0;
+	int ret = 0;
+
+	if (!filename) {
+		ERROR("You need to specify -f/--file.\n");
+		return 1;
+	}
+
+	if (!strcmp(filename, "-")) {
+		file = stdin;
+	} else {
+		file = fopen(filename, "r");
+		if (!file) {
+			ERROR("Could not open '%s'\n", filename);
+			return 1;
 		}
+	}
+
+	batch.active = true;
+	while (getline(&line, &line_size, file) != -1) {
+		static char prog_name[] = "cbfstool";
+		/* Room for the program name and the getopt terminator. */
+		char *argv[BATCH_MAX_ARGS + 2] = { prog_name };
+		int argc;
+		size_t i;
+
+		line_num++;
+		argc = batch_split_line(line, argv + 1, BATCH_MAX_ARGS);
+		if (argc < 0) {
+			ERROR("%s:%u: Unterminated quote or too many arguments\n",
+			      filename, line_num);
+			ret = 1;
+			break;
+		}
+		if (!argc)
+			continue;
+
+		for (i = 0; i < ARRAY_SIZE(commands); i++)
+			if (!strcmp(argv[1], commands[i].name))
+				break;
+		if (i == ARRAY_SIZE(commands) ||
+		    commands[i].function == cbfs_create ||
+		    commands[i].function == cbfs_batch) {
+			ERROR("%s:%u: Command '%s' can't be used in a batch\n",
+			      filename, line_num, argv[1]);
+			ret = 1;
+			break;
+		}
+
+		/* Drop the command name so that the options start at argv[1]. */
+		argv[1] = argv[0];
+		param = *param_defaults;
+		param.image_file = image_file;
+		cbfs_placement = CBFS_PLACEMENT_FIRST_FIT;
+		optind = 0;
+		if (parse_command_options(i, argc, argv + 1) ||
+		    run_command(i)) {
+			ERROR("%s:%u: Command '%s' failed\n", filename,
+			      line_num, commands[i].name);
+			ret = 1;
+			break;
+		}
+
+		/* The command may have added or moved the bootblock, so look for
+		   the metadata hash anchor again, just like the next invocation
+		   would outside of a batch. */
+		if (commands[i].modifies_region)
+			mh_cache.initialized = false;
+
+		/* Let the next command reuse the index of empty entries, as long
+		   as files were only added or removed through cbfs_image. */
+		if (commands[i].modifies_region &&
+		    !batch_keeps_indexes(commands[i].function))
+			cbfs_image_release_indexes();
+	}
+	batch.active = false;
+	cbfs_image_release_indexes();
+
+	if (!ret && ferror(file)) {
+		ERROR("Failed to read '%s'\n", filename);
+		ret = 1;
+	}
+
+	param = *param_defaults;
+	param.image_file = image_file;
+	if (!ret)
+		ret = batch_finish();
+	else
+		ERROR("The image will be left unmodified.\n");
+
+	for (size_t i = 0; i < batch.num_regions; i++)
+		free(batch.regions[i]);
+	free(batch.regions);
+	free(line);
+	if (file != stdin)
+		fclose(file);
+	return ret;
+}
+
+int main(int argc, char **argv)
+{
+	const struct param defaults = param;
+	size_t i;
+
+	if (argc < 3) {
+		usage(argv[0]);
+		return 1;
+	}
+
+	char *image_name = argv[1];
+	char *cmd = argv[2];
+	optind += 2;
+	param_defaults = &defaults;
+
+	for (i = 0; i < ARRAY_SIZE(commands); i++) {
+		if (strcmp(cmd, commands[i].name) != 0)
+			continue;
+
+		if (parse_command_options(i, argc, argv))
+			return 1;
 
 		if (commands[i].function == cbfs_create) {
 			if (param.fmap) {
@@ -2327,72 +2690,14 @@ int main(int argc, char **argv)
 		if (!param.image_file)
 			return 1;
 
-		unsigned num_regions = 1;
-		for (const char *list = strchr(param.region_name, ','); list;
-						list = strchr(list + 1, ','))
-			++num_regions;
-
-		// If the action needs to read an image region, as indicated by
-		// having accesses_region set in its command struct, that
-		// region's buffer struct will be stored here and the client
-		// will receive a pointer to it via param.image_region. It
-		// need not write the buffer back to the image file itself,
-		// since this behavior can be requested via its modifies_region
-		// field. Additionally, it should never free the region buffer,
-		// as that is performed automatically once it completes.
-		struct buffer image_regions[num_regions];
-		memset(image_regions, 0, sizeof(image_regions));
-
-		bool seen_primary_cbfs = false;
-		char region_name_scratch[strlen(param.region_name) + 1];
-		strcpy(region_name_scratch, param.region_name);
-		param.region_name = strtok(region_name_scratch, ",");
-		for (unsigned region = 0; region < num_regions; ++region) {
-			if (!param.region_name) {
-				ERROR("Encountered illegal degenerate region name in -r list\n");
-				ERROR("The image will be left unmodified.\n");
-				partitioned_file_close(param.image_file);
-				return 1;
-			}
-
-			if (strcmp(param.region_name, SECTION_NAME_PRIMARY_CBFS)
-									== 0)
-				seen_primary_cbfs = true;
-
-			param.image_region = image_regions + region;
-			if (dispatch_command(commands[i])) {
-				partitioned_file_close(param.image_file);
-				return 1;
-			}
-
-			param.region_name = strtok(NULL, ",");
-		}
-
-		if (commands[i].function == cbfs_create && !seen_primary_cbfs) {
-			ERROR("The creation -r list must include the mandatory '%s' section.\n",
-						SECTION_NAME_PRIMARY_CBFS);
-			ERROR("The image will be left unmodified.\n");
-			partitioned_file_close(param.image_file);
-			return 1;
-		}
-
-		if (commands[i].modifies_region) {
-			assert(param.image_file);
-			for (unsigned region = 0; region < num_regions;
-								++region) {
-
-				if (!partitioned_file_write_region(
-							param.image_file,
-						image_regions + region)) {
-					partitioned_file_close(
-							param.image_file);
-					return 1;
-				}
-			}
-		}
+		int ret;
+		if (commands[i].function == cbfs_batch)
+			ret = cbfs_batch();
+		else
+			ret = run_command(i);
 
 		partitioned_file_close(param.image_file);
-		return 0;
+		return ret;
 	}
 
 	ERROR("Unknown command '%s'.\n", cmd);
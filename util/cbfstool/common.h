@@ -164,6 +164,25 @@ typedef int (*decomp_func_ptr) (char *in, int in_len, char *out, int out_len,
 comp_func_ptr compression_function(enum cbfs_compression algo);
 decomp_func_ptr decompression_function(enum cbfs_compression algo);
 
+/* One independent input for compress_parallel(). out must hold in_len bytes,
+ * out_len and ret receive what the compression function returned. */
+struct compression_job {
+	char *in;
+	int in_len;
+	char *out;
+	int out_len;
+	int ret;
+};
+
+/* Maximum number of threads compress_parallel() uses (--jobs). */
+extern unsigned int compression_jobs;
+
+/* Compress every job with compress, spreading them over up to
+ * compression_jobs threads. The output is identical to compressing the jobs
+ * one after another. */
+void compress_parallel(comp_func_ptr compress, struct compression_job *jobs,
+		       size_t count);
+
 uint64_t intfiletype(const char *name);
 
 /* cbfs-mkpayload.c */
@@ -1,6 +1,7 @@
 /* compression handling for cbfstool */
 /* SPDX-License-Identifier: GPL-2.0-only */
 
+#include <pthread.h>
 #include <string.h>
 #include <stdio.h>
 #include <stdlib.h>
@@ -108,3 +109,67 @@ decomp_func_ptr decompression_function(enum cbfs_compression algo)
 	}
 	return decompress;
 }
+
+unsigned int compression_jobs = 1;
+
+struct compression_queue {
+	pthread_mutex_t lock;
+	comp_func_ptr compress;
+	struct compression_job *jobs;
+	size_t count;
+	size_t next;
+};
+
+static void *compression_worker(void *arg)
+{
+	struct compression_queue *queue = arg;
+	struct compression_job *job;
+
+	for (;;) {
+		pthread_mutex_lock(&queue->lock);
+		job = queue->next < queue->count ? &queue->jobs[queue->next++] : NULL;
+		pthread_mutex_unlock(&queue->lock);
+
+		if (!job)
+			return NULL;
+
+		job->ret = queue->compress(job->in, job->in_len, job->out,
+					   &job->out_len);
+	}
+}
+
+void compress_parallel(comp_func_ptr compress, struct compression_job *jobs,
+		       size_t count)
+{
+	struct compression_queue queue = {
+		.compress = compress,
+		.jobs = jobs,
+		.count = count,
+	};
+	size_t threads = MIN((size_t)compression_jobs, count);
+	pthread_t *tids = NULL;
+	size_t started = 0;
+
+	/* Every job is independent, so the results don't depend on how many
+	   threads there are. The calling thread always takes part. */
+	if (threads > 1)
+		tids = calloc(threads - 1, sizeof(*tids));
+
+	pthread_mutex_init(&queue.lock, NULL);
+
+	if (tids) {
+		for (; started < threads - 1; started++) {
+			if (pthread_create(&tids[started], NULL, compression_worker,
+					   &queue))
+				break;
+		}
+	}
+
+	compression_worker(&queue);
+
+	for (size_t i = 0; i < started; i++)
+		pthread_join(tids[i], NULL);
+
+	pthread_mutex_destroy(&queue.lock);
+	free(tids);
+}
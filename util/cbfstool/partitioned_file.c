@@ -11,19 +11,130 @@
 #include <stdlib.h>
 #include <string.h>
 #include <sys/file.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+/*
+ * Granularity at which modifications are written back. Writing a region back
+ * compares it against a read-only mapping of the backing file and only writes
+ * the blocks that differ, so small changes to a large image don't rewrite all
+ * of it.
+ */
+#define WRITEBACK_BLOCK_SIZE 4096
 
 struct partitioned_file {
 	struct fmap *fmap;
 	struct buffer buffer;
 	FILE *stream;
+	/* The buffer is a private (copy-on-write) mapping of the file rather
+	   than a copy of it, so only the parts that are used get read. */
+	bool buffer_mapped;
+	/* Read-only view of the backing file's current contents, or NULL to
+	   always write whole regions. */
+	uint8_t *mapping;
 };
 
+/* Sets up the buffer as a private mapping of the whole file. */
+static bool map_file_contents(struct partitioned_file *file,
+						const char *filename)
+{
+	struct stat st;
+	void *data;
+
+	if (fstat(fileno(file->stream), &st) || !S_ISREG(st.st_mode) ||
+							!st.st_size)
+		return false;
+
+	data = mmap(NULL, st.st_size, PROT_READ | PROT_WRITE, MAP_PRIVATE,
+						fileno(file->stream), 0);
+	if (data == MAP_FAILED)
+		return false;
+
+	file->buffer.data = data;
+	file->buffer.size = st.st_size;
+	file->buffer.offset = 0;
+	file->buffer.name = strdup(filename);
+	file->buffer_mapped = true;
+	return true;
+}
+
+/* Maps the backing file, which must be as large as the buffer by now. */
+static void map_backing_file(struct partitioned_file *file)
+{
+	void *mapping;
+
+	if (!file->buffer.size)
+		return;
+
+	mapping = mmap(NULL, file->buffer.size, PROT_READ, MAP_SHARED,
+						fileno(file->stream), 0);
+	if (mapping == MAP_FAILED)
+		return;	/* Fall back to writing whole regions. */
+	file->mapping = mapping;
+}
+
+static bool write_range(struct partitioned_file *file, size_t offset,
+								size_t size)
+{
+	int fd = fileno(file->stream);
+
+	while (size) {
+		ssize_t written = pwrite(fd, file->buffer.data + offset, size,
+									offset);
+		if (written <= 0) {
+			ERROR("Failed to write to image file\n");
+			return false;
+		}
+		offset += written;
+		size -= written;
+	}
+	return true;
+}
+
+/* Writes the parts of [offset, offset + size) that differ from the backing
+   file, in as few writes as possible. */
+static bool write_modified_blocks(struct partitioned_file *file,
+						size_t offset, size_t size)
+{
+	const size_t end = offset + size;
+	size_t start = offset;
+	size_t run_start = 0;
+	bool in_run = false;
+
+	while (start < end) {
+		size_t next = (start / WRITEBACK_BLOCK_SIZE + 1) *
+							WRITEBACK_BLOCK_SIZE;
+		if (next > end)
+			next = end;
+
+		bool modified = memcmp(file->buffer.data + start,
+				       file->mapping + start, next - start);
+		if (modified && !in_run) {
+			run_start = start;
+			in_run = true;
+		} else if (!modified && in_run) {
+			if (!write_range(file, run_start, start - run_start))
+				return false;
+			in_run = false;
+		}
+		start = next;
+	}
+
+	if (in_run && !write_range(file, run_start, end - run_start))
+		return false;
+	return true;
+}
+
 static bool fill_ones_through(struct partitioned_file *file)
 {
 	assert(file);
 
 	memset(file->buffer.data, 0xff, file->buffer.size);
-	return partitioned_file_write_region(file, &file->buffer);
+	if (!partitioned_file_write_region(file, &file->buffer))
+		return false;
+	map_backing_file(file);
+	return true;
 }
 
 static unsigned count_selected_fmap_entries(const struct fmap *fmap,
@@ -52,11 +163,6 @@ static partitioned_file_t *reopen_flat_file(const char *filename,
 		return NULL;
 	}
 
-	if (buffer_from_file(&file->buffer, filename)) {
-		free(file);
-		return NULL;
-	}
-
 	access_mode = write_access ?  "rb+" : "rb";
 	file->stream = fopen(filename, access_mode);
 
@@ -66,6 +172,15 @@ static partitioned_file_t *reopen_flat_file(const char *filename,
 		return NULL;
 	}
 
+	if (!map_file_contents(file, filename) &&
+	    buffer_from_file(&file->buffer, filename)) {
+		partitioned_file_close(file);
+		return NULL;
+	}
+
+	if (write_access)
+		map_backing_file(file);
+
 	return file;
 }
 
@@ -220,15 +335,9 @@ bool partitioned_file_write_region(partitioned_file_t *file,
 		return false;
 	}
 
-	if (fseek(file->stream, buffer->offset, SEEK_SET)) {
-		ERROR("Failed to seek within image file\n");
-		return false;
-	}
-	if (!fwrite(buffer->data, buffer->size, 1, file->stream)) {
-		ERROR("Failed to write to image file\n");
-		return false;
-	}
-	return true;
+	if (file->mapping)
+		return write_modified_blocks(file, buffer->offset, buffer->size);
+	return write_range(file, buffer->offset, buffer->size);
 }
 
 bool partitioned_file_read_region(struct buffer *dest,
@@ -269,7 +378,14 @@ void partitioned_file_close(partitioned_file_t *file)
 		return;
 
 	file->fmap = NULL;
-	buffer_delete(&file->buffer);
+	if (file->mapping)
+		munmap(file->mapping, file->buffer.size);
+	if (file->buffer_mapped) {
+		munmap(file->buffer.data, file->buffer.size);
+		free(file->buffer.name);
+	} else {
+		buffer_delete(&file->buffer);
+	}
 	if (file->stream) {
 		flock(fileno(file->stream), LOCK_UN);
 		fclose(file->stream);
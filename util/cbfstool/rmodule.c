@@ -451,6 +451,54 @@ static int populate_rmodule_info(struct rmod_context *ctx)
 	return 0;
 }
 
+static void put_uleb128(struct buffer *b, uint64_t val)
+{
+	do {
+		uint8_t byte = val & 0x7f;
+
+		val >>= 7;
+		if (val)
+			byte |= 0x80;
+		xdr_le.put8(b, byte);
+	} while (val);
+}
+
+/* Longest encoding of a single relocation: two 64-bit ULEB128 numbers. */
+#define PACKED_RELOC_MAX_SIZE (2 * 10)
+
+/*
+ * Pack the sorted relocations as described for RMODULE_VERSION_2 in
+ * rmodule-defs.h. Runs of three or more relocations at the same distance are
+ * merged into a single entry.
+ */
+static void pack_relocations(const struct rmod_context *ctx,
+			     struct buffer *relocs)
+{
+	Elf64_Addr prev = 0;
+	size_t i = 0;
+
+	while (i < ctx->nrelocs) {
+		const Elf64_Addr delta = ctx->emitted_relocs[i] - prev;
+		size_t run = 0;
+
+		while (delta && i + run + 1 < ctx->nrelocs &&
+		       ctx->emitted_relocs[i + run + 1] -
+		       ctx->emitted_relocs[i + run] == delta)
+			run++;
+
+		if (run >= 2) {
+			put_uleb128(relocs, delta << 1 | RMODULE_RELOC_RUN);
+			put_uleb128(relocs, run);
+		} else {
+			run = 0;
+			put_uleb128(relocs, delta << 1);
+		}
+
+		i += run + 1;
+		prev = ctx->emitted_relocs[i - 1];
+	}
+}
+
 static int
 add_section(struct elf_writer *ew, struct buffer *data, const char *name,
 	    Elf64_Addr addr, Elf64_Word size)
@@ -483,7 +531,6 @@ write_elf(const struct rmod_context *ctx, const struct buffer *in,
 	  struct buffer *out)
 {
 	int ret;
-	int bit64;
 	size_t loc;
 	size_t rmod_data_size;
 	struct elf_writer *ew;
@@ -500,8 +547,6 @@ write_elf(const struct rmod_context *ctx, const struct buffer *in,
 		return -1;
 	}
 
-	bit64 = ctx->pelf.ehdr.e_ident[EI_CLASS] == ELFCLASS64;
-
 	/*
 	 * 3 sections will be added  to the ELF file.
 	 * +------------------+
@@ -513,12 +558,10 @@ write_elf(const struct rmod_context *ctx, const struct buffer *in,
 	 * +------------------+
 	 */
 
-	/* Create buffer for header and relocations. */
+	/* Create buffer for header and relocations, large enough for the
+	   worst case of the packed relocations. */
 	rmod_data_size = sizeof(struct rmodule_header);
-	if (bit64)
-		rmod_data_size += ctx->nrelocs * sizeof(Elf64_Addr);
-	else
-		rmod_data_size += ctx->nrelocs * sizeof(Elf32_Addr);
+	rmod_data_size += ctx->nrelocs * PACKED_RELOC_MAX_SIZE;
 
 	if (buffer_create(&rmod_data, rmod_data_size, "rmod"))
 		return -1;
@@ -532,6 +575,8 @@ write_elf(const struct rmod_context *ctx, const struct buffer *in,
 	buffer_set_size(&rmod_header, 0);
 	buffer_set_size(&relocs, 0);
 
+	pack_relocations(ctx, &relocs);
+
 	/* Program contents. */
 	buffer_splice(&program, in, ctx->phdr->p_offset, ctx->phdr->p_filesz);
 
@@ -548,7 +593,7 @@ write_elf(const struct rmod_context *ctx, const struct buffer *in,
 
 	/* Write out rmodule_header. */
 	ctx->xdr->put16(&rmod_header, RMODULE_MAGIC);
-	ctx->xdr->put8(&rmod_header, RMODULE_VERSION_1);
+	ctx->xdr->put8(&rmod_header, RMODULE_VERSION_2);
 	ctx->xdr->put8(&rmod_header, 0);
 	/* payload_begin_offset */
 	loc = sizeof(struct rmodule_header);
@@ -559,10 +604,7 @@ write_elf(const struct rmod_context *ctx, const struct buffer *in,
 	/* relocations_begin_offset */
 	ctx->xdr->put32(&rmod_header, loc);
 	/* relocations_end_offset */
-	if (bit64)
-		loc += ctx->nrelocs * sizeof(Elf64_Addr);
-	else
-		loc += ctx->nrelocs * sizeof(Elf32_Addr);
+	loc += buffer_size(&relocs);
 	ctx->xdr->put32(&rmod_header, loc);
 	/* module_link_start_address */
 	ctx->xdr->put32(&rmod_header, ctx->phdr->p_vaddr);
@@ -584,14 +626,6 @@ write_elf(const struct rmod_context *ctx, const struct buffer *in,
 	ctx->xdr->put32(&rmod_header, 0);
 	ctx->xdr->put32(&rmod_header, 0);
 
-	/* Write the relocations. */
-	for (unsigned i = 0; i < ctx->nrelocs; i++) {
-		if (bit64)
-			ctx->xdr->put64(&relocs, ctx->emitted_relocs[i]);
-		else
-			ctx->xdr->put32(&relocs, ctx->emitted_relocs[i]);
-	}
-
 	total_size = 0;
 	addr = 0;
 
@@ -773,6 +807,86 @@ static void rmod_deserialize(struct rmodule_header *rmod, struct buffer *buff,
 	rmod->padding[3] = xdr->get32(buff);
 }
 
+static int add_reloc(struct elf_writer *ew, const char *section_name,
+		     const struct rmodule_header *rmod, Elf64_Addr addr)
+{
+	/* Skip any relocations that are below the link address. */
+	if (addr < rmod->module_link_start_address)
+		return 0;
+
+	if (elf_writer_add_rel(ew, section_name, addr)) {
+		ERROR("Relocation addition failure.\n");
+		return -1;
+	}
+	return 0;
+}
+
+static int add_flat_relocs(struct elf_writer *ew, const char *section_name,
+			   struct buffer *reader,
+			   const struct rmodule_header *rmod, struct xdr *xdr,
+			   int bit64)
+{
+	while (buffer_size(reader) > 0) {
+		Elf64_Addr addr;
+
+		if (bit64)
+			addr = xdr->get64(reader);
+		else
+			addr = xdr->get32(reader);
+
+		if (add_reloc(ew, section_name, rmod, addr))
+			return -1;
+	}
+	return 0;
+}
+
+static int get_uleb128(struct buffer *reader, uint64_t *val)
+{
+	unsigned int shift = 0;
+	uint8_t byte;
+
+	*val = 0;
+	do {
+		if (!buffer_size(reader) || shift >= 64) {
+			ERROR("Truncated relocation table.\n");
+			return -1;
+		}
+		byte = xdr_le.get8(reader);
+		*val |= (uint64_t)(byte & 0x7f) << shift;
+		shift += 7;
+	} while (byte & 0x80);
+
+	return 0;
+}
+
+static int add_packed_relocs(struct elf_writer *ew, const char *section_name,
+			     struct buffer *reader,
+			     const struct rmodule_header *rmod)
+{
+	Elf64_Addr addr = 0;
+
+	while (buffer_size(reader) > 0) {
+		uint64_t entry, count = 0;
+
+		if (get_uleb128(reader, &entry))
+			return -1;
+		if ((entry & RMODULE_RELOC_RUN) && get_uleb128(reader, &count))
+			return -1;
+
+		if (count > rmod->module_program_size) {
+			ERROR("Invalid relocation run length.\n");
+			return -1;
+		}
+
+		do {
+			addr += entry >> 1;
+			if (add_reloc(ew, section_name, rmod, addr))
+				return -1;
+		} while (count--);
+	}
+	return 0;
+}
+
 int rmodule_stage_to_elf(Elf64_Ehdr *ehdr, struct buffer *buff)
 {
 	struct buffer reader;
@@ -782,6 +896,7 @@ int rmodule_stage_to_elf(Elf64_Ehdr *ehdr, struct buffer *buff)
 	struct elf_writer *ew;
 	Elf64_Shdr shdr;
 	int bit64;
+	int err;
 	size_t payload_sz;
 	const char *section_name = ".program";
 	const size_t input_sz = buffer_size(buff);
@@ -796,7 +911,8 @@ int rmodule_stage_to_elf(Elf64_Ehdr *ehdr, struct buffer *buff)
 	/* Indicate that file is not an rmodule if initial checks fail. */
 	if (rmod.magic != RMODULE_MAGIC)
 		return 1;
-	if (rmod.version != RMODULE_VERSION_1)
+	if (rmod.version != RMODULE_VERSION_1 &&
+	    rmod.version != RMODULE_VERSION_2)
 		return 1;
 
 	if (rmod.payload_begin_offset > input_sz ||
@@ -883,26 +999,14 @@ int rmodule_stage_to_elf(Elf64_Ehdr *ehdr, struct buffer *buff)
 	ssize_t relocs_sz = rmod.relocations_end_offset;
 	relocs_sz -= rmod.relocations_begin_offset;
 	buffer_splice(&reader, buff, rmod.relocations_begin_offset, relocs_sz);
-	while (relocs_sz > 0) {
-		Elf64_Addr addr;
-
-		if (bit64) {
-			relocs_sz -= sizeof(Elf64_Addr);
-			addr = xdr->get64(&reader);
-		} else {
-			relocs_sz -= sizeof(Elf32_Addr);
-			addr = xdr->get32(&reader);
-		}
-
-		/* Skip any relocations that are below the link address. */
-		if (addr < rmod.module_link_start_address)
-			continue;
-
-		if (elf_writer_add_rel(ew, section_name, addr)) {
-			ERROR("Relocation addition failure.\n");
-			elf_writer_destroy(ew);
-			return -1;
-		}
+	if (rmod.version == RMODULE_VERSION_2)
+		err = add_packed_relocs(ew, section_name, &reader, &rmod);
+	else
+		err = add_flat_relocs(ew, section_name, &reader, &rmod, xdr,
+				      bit64);
+	if (err) {
+		elf_writer_destroy(ew);
+		return -1;
 	}
 
 	if (elf_writer_serialize(ew, &elf_out)) {
@@ -0,0 +1,95 @@
+#!/usr/bin/python3
+# SPDX-License-Identifier: BSD-3-Clause
+
+import os
+import pytest
+import subprocess
+
+# Defined in include/commonlib/bsd/metadata_hash.h
+METADATA_HASH_ANCHOR_MAGIC = b"\xadMdtHsh\x15"
+VB2_HASH_SHA256 = 2
+
+FMD = """FLASH 0x40000 {
+	FMAP 0x1000
+	COREBOOT(CBFS) 0x3f000
+}
+"""
+
+
+@pytest.fixture(scope="session")
+def cbfstool_path(request):
+    exe = request.config.option.cbfstool_path
+    assert os.path.exists(exe)
+    return exe
+
+
+@pytest.fixture(scope="session")
+def fmaptool_path(request):
+    exe = request.config.option.fmaptool_path
+    assert os.path.exists(exe)
+    return exe
+
+
+@pytest.fixture(scope="function")
+def workdir(tmp_path, fmaptool_path):
+    (tmp_path / "layout.fmd").write_text(FMD)
+    subprocess.run([fmaptool_path, "layout.fmd", "layout.fmap"],
+                   cwd=tmp_path, capture_output=True, check=True)
+
+    # A bootblock with an empty SHA256 metadata hash anchor, which turns on
+    # CBFS verification for the image once it is added.
+    anchor = METADATA_HASH_ANCHOR_MAGIC + bytes([VB2_HASH_SHA256, 0, 0, 0])
+    anchor += bytes(64 + 64)
+    (tmp_path / "bootblock.bin").write_bytes(bytes(64) + anchor + bytes(64))
+
+    for i, size in enumerate([1000, 3000, 200, 70000]):
+        (tmp_path / f"file{i}.bin").write_bytes(bytes([0x41 + i]) * size)
+
+    return tmp_path
+
+
+def build_image(cbfstool_path, workdir, name: str, commands: list,
+                batch: bool) -> bytes:
+    subprocess.run([cbfstool_path, name, "create", "-M", "layout.fmap"],
+                   cwd=workdir, capture_output=True, check=True)
+    if batch:
+        (workdir / "commands.txt").write_text(
+            "".join(" ".join(cmd) + "\n" for cmd in commands))
+        subprocess.run([cbfstool_path, name, "batch", "-f", "commands.txt"],
+                       cwd=workdir, capture_output=True, check=True)
+    else:
+        for cmd in commands:
+            subprocess.run([cbfstool_path, name] + cmd,
+                           cwd=workdir, capture_output=True, check=True)
+    return (workdir / name).read_bytes()
+
+
+def add(name: str, filename: str, *args) -> list:
+    return ["add", "-f", filename, "-n", name, "-t", "raw"] + list(args)
+
+
+@pytest.mark.parametrize("commands", [
+    # Plain adds and removes.
+    [add("f0", "file0.bin"), add("f1", "file1.bin"), ["remove", "-n", "f0"],
+     add("f2", "file2.bin"), add("f3", "file3.bin", "-a", "0x1000")],
+    # Files added after the bootblock must be hashed, files before it are
+    # hashed once the metadata hash is updated.
+    [add("f0", "file0.bin"),
+     ["add", "-f", "bootblock.bin", "-n", "bootblock", "-t", "bootblock"],
+     add("f1", "file1.bin"), add("f2", "file2.bin", "-c", "lzma")],
+    # Best-fit and fixed offset placement into the holes left by removals.
+    [add("f0", "file0.bin"), add("f1", "file1.bin"), add("f2", "file2.bin"),
+     add("f3", "file3.bin"), ["remove", "-n", "f0"], ["remove", "-n", "f2"],
+     add("g2", "file2.bin", "--best-fit"), add("g0", "file0.bin"),
+     ["remove", "-n", "f1"], add("g1", "file1.bin", "-b", "0x480"),
+     add("h0", "file0.bin", "--best-fit")],
+    # Same, with the bootblock removed again halfway through.
+    [["add", "-f", "bootblock.bin", "-n", "bootblock", "-t", "bootblock"],
+     add("f0", "file0.bin"), ["remove", "-n", "bootblock"],
+     add("f1", "file1.bin"), add("f3", "file3.bin")],
+])
+def test_batch_matches_sequential(cbfstool_path, workdir, commands):
+    sequential = build_image(cbfstool_path, workdir, "sequential.rom",
+                             commands, False)
+    batch = build_image(cbfstool_path, workdir, "batch.rom", commands, True)
+    assert batch == sequential
@@ -18,8 +18,10 @@
 #include <libgen.h>
 #include <assert.h>
 #include <regex.h>
+#include <commonlib/bs_profile_serialized.h>
 #include <commonlib/bsd/cbmem_id.h>
 #include <commonlib/bsd/tpm_log_defs.h>
+#include <commonlib/imd_serialized.h>
 #include <commonlib/loglevel.h>
 #include <commonlib/timestamp_serialized.h>
 #include <commonlib/tpm_log_serialized.h>
@@ -48,6 +50,8 @@ struct mapping {
 	size_t virt_size;
 	unsigned long long phys;
 	size_t size;
+	/* Points into cbmem_mapping instead of having a mapping of its own. */
+	bool borrowed;
 };
 
 #define CBMEM_VERSION "1.1"
@@ -59,6 +63,8 @@ static int verbose = 0;
 /* File handle used to access /dev/mem */
 static int mem_fd;
 static struct mapping lbtable_mapping;
+/* All of CBMEM, with --map-cbmem. */
+static struct mapping cbmem_mapping;
 
 /* TSC frequency from the LB_TAG_TSC_INFO record. 0 if not present. */
 static uint32_t tsc_freq_khz = 0;
@@ -103,9 +109,24 @@ static void *map_memory_with_prot(struct mapping *mapping,
 	void *v;
 	unsigned long long page_size;
 
+	/* Read-only requests within CBMEM don't need a mapping of their own. */
+	if (prot == PROT_READ && cbmem_mapping.virt != NULL && phys >= cbmem_mapping.phys &&
+	    phys - cbmem_mapping.phys <= cbmem_mapping.size &&
+	    sz <= cbmem_mapping.size - (phys - cbmem_mapping.phys)) {
+		mapping->virt = (char *)mapping_virt(&cbmem_mapping) +
+				(phys - cbmem_mapping.phys);
+		mapping->offset = 0;
+		mapping->virt_size = sz;
+		mapping->size = sz;
+		mapping->phys = phys;
+		mapping->borrowed = true;
+		return mapping->virt;
+	}
+
 	page_size = system_page_size();
 
 	mapping->virt = NULL;
+	mapping->borrowed = false;
 	mapping->offset = phys % page_size;
 	mapping->virt_size = sz + mapping->offset;
 	mapping->size = sz;
@@ -152,7 +173,8 @@ static int unmap_memory(struct mapping *mapping)
 	if (mapping->virt == NULL)
 		return -1;
 
-	munmap(mapping->virt, mapping->virt_size);
+	if (!mapping->borrowed)
+		munmap(mapping->virt, mapping->virt_size);
 	mapping->virt = NULL;
 	mapping->offset = 0;
 	mapping->virt_size = 0;
@@ -218,6 +240,15 @@ static u16 ipchcksum(const void *addr, unsigned size)
 	return (u16) sum;
 }
 
+/* CBMEM entries found in the imd with --map-cbmem, in the order of the imd cursor. */
+struct imd_entry_info {
+	uint32_t id;
+	uint64_t address;
+	uint32_t size;
+};
+static struct imd_entry_info *imd_entries;
+static size_t imd_num_entries;
+
 /* Find the first cbmem entry filling in the details. */
 static int find_cbmem_entry(uint32_t id, uint64_t *addr, size_t *size)
 {
@@ -225,6 +256,18 @@ static int find_cbmem_entry(uint32_t id, uint64_t *addr, size_t *size)
 	size_t offset;
 	int ret = -1;
 
+	/* The imd also has the entries that were added after the coreboot table was written. */
+	if (imd_entries) {
+		for (size_t i = 0; i < imd_num_entries; i++) {
+			if (imd_entries[i].id != id)
+				continue;
+			*addr = imd_entries[i].address;
+			*size = imd_entries[i].size;
+			return 0;
+		}
+		return -1;
+	}
+
 	table = mapping_virt(&lbtable_mapping);
 
 	if (table == NULL)
@@ -448,6 +491,105 @@ static int parse_cbtable(u64 address, size_t table_size)
 	return -1;
 }
 
+/* Returns a pointer to |size| bytes of CBMEM at |phys| or NULL if they aren't all mapped. */
+static const void *cbmem_virt(uint64_t phys, size_t size)
+{
+	if (phys < cbmem_mapping.phys || phys - cbmem_mapping.phys > cbmem_mapping.size ||
+	    size > cbmem_mapping.size - (phys - cbmem_mapping.phys))
+		return NULL;
+
+	return (const u8 *)mapping_virt(&cbmem_mapping) + (phys - cbmem_mapping.phys);
+}
+
+/* Add the entries of the imd with upper limit |limit| to imd_entries. Return < 0 on error. */
+static int collect_imd_entries(uint64_t limit)
+{
+	const struct imd_root_pointer *rp_p;
+	const struct imd_root *r_p;
+	struct imd_root_pointer rp;
+	struct imd_root r;
+	struct imd_entry_info *entries;
+	uint64_t root;
+
+	rp_p = cbmem_virt(limit - sizeof(rp), sizeof(rp));
+	if (!rp_p)
+		return -1;
+	aligned_memcpy(&rp, rp_p, sizeof(rp));
+	if (rp.magic != IMD_ROOT_PTR_MAGIC)
+		return -1;
+
+	root = limit - sizeof(rp) + rp.root_offset;
+	r_p = cbmem_virt(root, sizeof(r));
+	if (!r_p)
+		return -1;
+	aligned_memcpy(&r, r_p, sizeof(r));
+	if (r.num_entries > r.max_entries ||
+	    !cbmem_virt(root, sizeof(r) + r.num_entries * sizeof(r.entries[0])))
+		return -1;
+
+	entries = realloc(imd_entries, (imd_num_entries + r.num_entries) * sizeof(*entries));
+	if (!entries)
+		die("Not enough memory for CBMEM entries.\n");
+	imd_entries = entries;
+
+	for (uint32_t i = 0; i < r.num_entries; i++) {
+		struct imd_entry e;
+
+		aligned_memcpy(&e, &r_p->entries[i], sizeof(e));
+		if (e.magic != IMD_ENTRY_MAGIC)
+			continue;
+
+		entries[imd_num_entries].id = e.id;
+		entries[imd_num_entries].address = root + e.start_offset;
+		entries[imd_num_entries].size = e.size;
+		imd_num_entries++;
+	}
+
+	return 0;
+}
+
+/*
+ * Map all of CBMEM at once and take its table of contents from the imd at the top. Memory
+ * within CBMEM is then read through this mapping, which saves an mmap() and munmap() for every
+ * object that is looked at. Return < 0 on error.
+ */
+static int map_cbmem(void)
+{
+	uint64_t limit, small_limit = 0;
+
+	if (cbmem.type != LB_MEM_TABLE)
+		return -1;
+
+	limit = (cbmem.start + cbmem.size) & ~(uint64_t)(IMD_LIMIT_ALIGN - 1);
+	if (limit <= cbmem.start)
+		return -1;
+
+	if (!map_memory(&cbmem_mapping, cbmem.start, limit - cbmem.start))
+		return -1;
+
+	if (collect_imd_entries(limit) < 0)
+		goto fail;
+
+	/* Small entries live in an imd of their own, within an entry of the large one. */
+	for (size_t i = 0; i < imd_num_entries; i++) {
+		if (imd_entries[i].id == CBMEM_ID_IMD_SMALL)
+			small_limit = imd_entries[i].address + imd_entries[i].size;
+	}
+	if (small_limit && collect_imd_entries(small_limit) < 0)
+		goto fail;
+
+	debug("Found %zu entries in the CBMEM imd.\n", imd_num_entries);
+	return 0;
+
+fail:
+	debug("No valid imd at the top of CBMEM.\n");
+	free(imd_entries);
+	imd_entries = NULL;
+	imd_num_entries = 0;
+	unmap_memory(&cbmem_mapping);
+	return -1;
+}
+
 #if defined(linux) && (defined(__i386__) || defined(__x86_64__))
 /*
  * read CPU frequency from a sysfs file, return an frequency in Megahertz as
@@ -692,51 +834,367 @@ enum timestamps_print_type {
 	TIMESTAMPS_PRINT_NORMAL,
 	TIMESTAMPS_PRINT_MACHINE_READABLE,
 	TIMESTAMPS_PRINT_STACKED,
+	TIMESTAMPS_PRINT_JSON,
+	TIMESTAMPS_PRINT_TRACE,
+};
+
+/* A start timestamp and its matching end, as indices into the sorted table. */
+struct ts_range {
+	uint32_t start;
+	uint32_t end;
+	int parent;		/* Index of the enclosing range, -1 at the top level */
+};
+
+/*
+ * Pair start and end timestamps the same way the stacked output does: a range has to end
+ * before the range it started in. Returns the number of ranges written to |ranges|, which
+ * needs room for one per entry.
+ */
+static size_t find_timestamp_ranges(struct timestamp_table *sorted_tst_p,
+				    struct ts_range *ranges)
+{
+	int stack[20];
+	int stacklvl = 0;
+	size_t count = 0;
+
+	for (uint32_t i = 0; i < sorted_tst_p->num_entries; i++) {
+		while (stacklvl > 0 && ranges[stack[stacklvl]].end <= i)
+			stacklvl--;
+
+		const uint32_t end = stacklvl ? ranges[stack[stacklvl]].end
+					      : sorted_tst_p->num_entries;
+		const int match = find_matching_end(sorted_tst_p, i, end);
+
+		if (match == -1 || stacklvl + 1 >= (int)ARRAY_SIZE(stack))
+			continue;
+
+		ranges[count].start = i;
+		ranges[count].end = match;
+		ranges[count].parent = stacklvl ? stack[stacklvl] : -1;
+		stack[++stacklvl] = count++;
+	}
+
+	return count;
+}
+
+/* Timestamps that mark the start of a stage, for the per-stage totals. */
+static const struct {
+	uint32_t id;
+	const char *name;
+} timestamp_stages[] = {
+	{ TS_BOOTBLOCK_START, "bootblock" },
+	{ TS_ROMSTAGE_START, "romstage" },
+	{ TS_POSTCAR_START, "postcar" },
+	{ TS_RAMSTAGE_START, "ramstage" },
+	{ TS_SELFBOOT_JUMP, "payload" },
+	{ TS_ACPI_WAKE_JUMP, "os resume" },
+};
+
+struct ts_stage {
+	const char *name;
+	uint64_t start;
+	uint64_t duration;
 };
 
+static const char *timestamp_stage_name(uint32_t id)
+{
+	for (size_t i = 0; i < ARRAY_SIZE(timestamp_stages); i++)
+		if (timestamp_stages[i].id == id)
+			return timestamp_stages[i].name;
+
+	return NULL;
+}
+
+/* Absolute time of entry |i| of a sorted table, in microseconds. */
+static uint64_t sorted_stamp_us(const struct timestamp_table *sorted_tst_p, uint32_t i)
+{
+	return arch_convert_raw_ts_entry(sorted_tst_p->entries[i].entry_stamp +
+					 sorted_tst_p->base_time);
+}
+
+/*
+ * A stage lasts from its start timestamp until the next stage starts, the last one until the
+ * last timestamp. Returns the number of stages written to |stages|, which needs room for one
+ * per entry.
+ */
+static size_t find_timestamp_stages(const struct timestamp_table *sorted_tst_p,
+				    struct ts_stage *stages)
+{
+	const uint32_t n = sorted_tst_p->num_entries;
+	size_t count = 0;
+
+	for (uint32_t i = 0; i < n; i++) {
+		const char *name = timestamp_stage_name(sorted_tst_p->entries[i].entry_id);
+
+		if (!name)
+			continue;
+
+		stages[count].name = name;
+		stages[count].start = sorted_stamp_us(sorted_tst_p, i);
+		if (count)
+			stages[count - 1].duration = stages[count].start - stages[count - 1].start;
+		count++;
+	}
+
+	if (count)
+		stages[count - 1].duration = sorted_stamp_us(sorted_tst_p, n - 1) -
+					     stages[count - 1].start;
+
+	return count;
+}
+
+static void print_json_string(const char *s)
+{
+	putchar('"');
+	for (; *s; s++) {
+		if (*s == '"' || *s == '\\')
+			printf("\\%c", *s);
+		else if ((unsigned char)*s < 0x20)
+			printf("\\u%04x", *s);
+		else
+			putchar(*s);
+	}
+	putchar('"');
+}
+
+static void print_json_ranges(const struct timestamp_table *sorted_tst_p,
+			      const struct ts_range *ranges, size_t count, int parent,
+			      int indent)
+{
+	const char *sep = "";
+
+	for (size_t r = 0; r < count; r++) {
+		const struct ts_range *range = &ranges[r];
+		uint64_t start, end;
+
+		if (range->parent != parent)
+			continue;
+
+		start = sorted_stamp_us(sorted_tst_p, range->start);
+		end = sorted_stamp_us(sorted_tst_p, range->end);
+
+		printf("%s\n%*s{ \"name\": ", sep, indent, "");
+		print_json_string(get_timestamp_name(sorted_tst_p->entries[range->start].entry_id));
+		printf(", \"end_name\": ");
+		print_json_string(get_timestamp_name(sorted_tst_p->entries[range->end].entry_id));
+		printf(", \"start_us\": %" PRIu64 ", \"duration_us\": %" PRIu64
+		       ", \"children\": [", start, end - start);
+		print_json_ranges(sorted_tst_p, ranges, count, r, indent + 2);
+		printf("] }");
+		sep = ",";
+	}
+}
+
+/* One JSON document with the timestamps, the nested ranges and the per-stage totals. */
+static void print_timestamps_json(const struct timestamp_table *sorted_tst_p,
+				  const struct ts_range *ranges, size_t num_ranges,
+				  const struct ts_stage *stages, size_t num_stages,
+				  uint64_t dropped)
+{
+	const uint32_t n = sorted_tst_p->num_entries;
+	uint64_t prev = sorted_stamp_us(sorted_tst_p, 0);
+
+	printf("{\n  \"tick_freq_mhz\": %lu,\n  \"dropped\": %" PRIu64 ",\n", tick_freq_mhz,
+	       dropped);
+	printf("  \"total_us\": %" PRIu64 ",\n", sorted_stamp_us(sorted_tst_p, n - 1) - prev);
+
+	printf("  \"timestamps\": [");
+	for (uint32_t i = 0; i < n; i++) {
+		const uint32_t id = sorted_tst_p->entries[i].entry_id;
+		const uint64_t stamp = sorted_stamp_us(sorted_tst_p, i);
+
+		printf("%s\n    { \"id\": %u, \"name\": ", i ? "," : "", id);
+		print_json_string(id ? get_timestamp_name(id) : "TS_START");
+		printf(", \"description\": ");
+		print_json_string(timestamp_name(id));
+		printf(", \"time_us\": %" PRIu64 ", \"delta_us\": %" PRIu64 " }", stamp,
+		       stamp - prev);
+		prev = stamp;
+	}
+	printf("\n  ],\n");
+
+	printf("  \"ranges\": [");
+	print_json_ranges(sorted_tst_p, ranges, num_ranges, -1, 4);
+	printf("\n  ],\n");
+
+	printf("  \"stages\": [");
+	for (size_t s = 0; s < num_stages; s++) {
+		printf("%s\n    { \"name\": ", s ? "," : "");
+		print_json_string(stages[s].name);
+		printf(", \"start_us\": %" PRIu64 ", \"duration_us\": %" PRIu64 " }",
+		       stages[s].start, stages[s].duration);
+	}
+	printf("\n  ]\n}\n");
+}
+
+/*
+ * Chrome trace event format, for chrome://tracing and Perfetto. Stages go on one track and
+ * the ranges on another, where the viewer nests them by time. Single timestamps become
+ * instant events.
+ */
+static void print_timestamps_trace(const struct timestamp_table *sorted_tst_p,
+				   const struct ts_range *ranges, size_t num_ranges,
+				   const struct ts_stage *stages, size_t num_stages)
+{
+	const char *sep = "";
+
+	printf("{\"displayTimeUnit\": \"ms\", \"traceEvents\": [");
+
+	for (size_t s = 0; s < num_stages; s++) {
+		printf("%s\n{\"name\": ", sep);
+		print_json_string(stages[s].name);
+		printf(", \"cat\": \"stage\", \"ph\": \"X\", \"pid\": 0, \"tid\": 0, "
+		       "\"ts\": %" PRIu64 ", \"dur\": %" PRIu64 "}", stages[s].start,
+		       stages[s].duration);
+		sep = ",";
+	}
+
+	for (size_t r = 0; r < num_ranges; r++) {
+		const uint64_t start = sorted_stamp_us(sorted_tst_p, ranges[r].start);
+		const uint64_t end = sorted_stamp_us(sorted_tst_p, ranges[r].end);
+
+		printf("%s\n{\"name\": ", sep);
+		print_json_string(timestamp_name(sorted_tst_p->entries[ranges[r].start].entry_id));
+		printf(", \"cat\": \"range\", \"ph\": \"X\", \"pid\": 0, \"tid\": 1, "
+		       "\"ts\": %" PRIu64 ", \"dur\": %" PRIu64 "}", start, end - start);
+		sep = ",";
+	}
+
+	for (uint32_t i = 0; i < sorted_tst_p->num_entries; i++) {
+		printf("%s\n{\"name\": ", sep);
+		print_json_string(timestamp_name(sorted_tst_p->entries[i].entry_id));
+		printf(", \"cat\": \"timestamp\", \"ph\": \"i\", \"s\": \"g\", \"pid\": 0, "
+		       "\"tid\": 1, \"ts\": %" PRIu64 "}", sorted_stamp_us(sorted_tst_p, i));
+		sep = ",";
+	}
+
+	printf("\n]}\n");
+}
+
+static void print_timestamps_structured(enum timestamps_print_type output_type,
+					struct timestamp_table *sorted_tst_p, uint64_t dropped)
+{
+	struct ts_range *ranges;
+	struct ts_stage *stages;
+	size_t num_ranges, num_stages;
+
+	ranges = malloc(sorted_tst_p->num_entries * sizeof(*ranges));
+	stages = malloc(sorted_tst_p->num_entries * sizeof(*stages));
+	if (!ranges || !stages)
+		die("Failed to allocate memory");
+
+	num_ranges = find_timestamp_ranges(sorted_tst_p, ranges);
+	num_stages = find_timestamp_stages(sorted_tst_p, stages);
+
+	if (output_type == TIMESTAMPS_PRINT_JSON)
+		print_timestamps_json(sorted_tst_p, ranges, num_ranges, stages, num_stages,
+				      dropped);
+	else
+		print_timestamps_trace(sorted_tst_p, ranges, num_ranges, stages, num_stages);
+
+	free(ranges);
+	free(stages);
+}
+
+/*
+ * Read the timestamp table at |addr| and all the chunks it continues in into one table, with
+ * room for |extra| more entries. The number of timestamps coreboot dropped goes to |dropped|.
+ */
+static struct timestamp_table *read_timestamp_table(uint64_t addr, size_t extra,
+						    uint64_t *dropped)
+{
+	struct timestamp_table *all = NULL;
+	uint32_t count = 0;
+	unsigned int chunks = 0;
+
+	*dropped = 0;
+
+	while (addr) {
+		const struct timestamp_table *tst_p;
+		struct timestamp_table *chunk;
+		struct mapping timestamp_mapping;
+		size_t size;
+
+		if (++chunks > 1024)
+			die("Timestamp table chunks form a loop\n");
+
+		size = sizeof(*tst_p);
+		tst_p = map_memory(&timestamp_mapping, addr, size);
+		if (!tst_p)
+			die("Unable to map timestamp header\n");
+		size += tst_p->num_entries * sizeof(tst_p->entries[0]);
+		unmap_memory(&timestamp_mapping);
+
+		tst_p = map_memory(&timestamp_mapping, addr, size);
+		if (!tst_p)
+			die("Unable to map full timestamp table\n");
+		chunk = malloc(size);
+		if (!chunk)
+			die("Failed to allocate memory");
+		aligned_memcpy(chunk, tst_p, size);
+		unmap_memory(&timestamp_mapping);
+
+		if (!all) {
+			all = malloc(sizeof(*all));
+			if (!all)
+				die("Failed to allocate memory");
+			*all = *chunk;
+		}
+		all = realloc(all, sizeof(*all) +
+			      (count + chunk->num_entries + extra) * sizeof(all->entries[0]));
+		if (!all)
+			die("Failed to allocate memory");
+
+		addr = 0;
+		for (uint32_t i = 0; i < chunk->num_entries; i++) {
+			const struct timestamp_entry *tse = &chunk->entries[i];
+
+			if (tse->entry_id == TS_TABLE_CONTINUATION)
+				addr = tse->entry_stamp;
+			else if (tse->entry_id == TS_TABLE_DROPPED)
+				*dropped += tse->entry_stamp;
+			else
+				all->entries[count++] = *tse;
+		}
+		free(chunk);
+	}
+
+	all->num_entries = count;
+	return all;
+}
+
 /* dump the timestamp table */
 static void dump_timestamps(enum timestamps_print_type output_type)
 {
-	const struct timestamp_table *tst_p;
 	struct timestamp_table *sorted_tst_p;
-	size_t size;
 	uint64_t prev_stamp = 0;
 	uint64_t total_time = 0;
-	struct mapping timestamp_mapping;
+	uint64_t dropped;
 
 	if (timestamps.tag != LB_TAG_TIMESTAMPS) {
 		fprintf(stderr, "No timestamps found in coreboot table.\n");
 		return;
 	}
 
-	size = sizeof(*tst_p);
-	tst_p = map_memory(&timestamp_mapping, timestamps.cbmem_addr, size);
-	if (!tst_p)
-		die("Unable to map timestamp header\n");
-
-	timestamp_set_tick_freq(tst_p->tick_freq_mhz);
+	/* One more entry for the base time below. */
+	sorted_tst_p = read_timestamp_table(timestamps.cbmem_addr, 1, &dropped);
 
-	if (output_type == TIMESTAMPS_PRINT_NORMAL)
-		printf("%d entries total:\n\n", tst_p->num_entries);
-	size += tst_p->num_entries * sizeof(tst_p->entries[0]);
+	timestamp_set_tick_freq(sorted_tst_p->tick_freq_mhz);
 
-	unmap_memory(&timestamp_mapping);
-
-	tst_p = map_memory(&timestamp_mapping, timestamps.cbmem_addr, size);
-	if (!tst_p)
-		die("Unable to map full timestamp table\n");
-
-	sorted_tst_p = malloc(size + sizeof(struct timestamp_entry));
-	if (!sorted_tst_p)
-		die("Failed to allocate memory");
-	aligned_memcpy(sorted_tst_p, tst_p, size);
+	if (output_type == TIMESTAMPS_PRINT_NORMAL && dropped)
+		printf("%d entries total, %" PRIu64 " dropped:\n\n", sorted_tst_p->num_entries,
+		       dropped);
+	else if (output_type == TIMESTAMPS_PRINT_NORMAL)
+		printf("%d entries total:\n\n", sorted_tst_p->num_entries);
+	else if (dropped && output_type != TIMESTAMPS_PRINT_JSON)
+		fprintf(stderr, "Warning: %" PRIu64 " timestamps were dropped.\n", dropped);
 
 	/*
 	 * Insert a timestamp to represent the base time (start of coreboot),
 	 * in case we have to rebase for negative timestamps below.
 	 */
-	sorted_tst_p->entries[tst_p->num_entries].entry_id = 0;
-	sorted_tst_p->entries[tst_p->num_entries].entry_stamp = 0;
+	sorted_tst_p->entries[sorted_tst_p->num_entries].entry_id = 0;
+	sorted_tst_p->entries[sorted_tst_p->num_entries].entry_stamp = 0;
 	sorted_tst_p->num_entries += 1;
 
 	qsort(&sorted_tst_p->entries[0], sorted_tst_p->num_entries,
@@ -750,7 +1208,13 @@ static void dump_timestamps(enum timestamps_print_type output_type)
 		sorted_tst_p->base_time = -sorted_tst_p->entries[0].entry_stamp;
 		prev_stamp = 0;
 	} else {
-		prev_stamp = tst_p->base_time;
+		prev_stamp = sorted_tst_p->base_time;
+	}
+
+	if (output_type == TIMESTAMPS_PRINT_JSON || output_type == TIMESTAMPS_PRINT_TRACE) {
+		print_timestamps_structured(output_type, sorted_tst_p, dropped);
+		free(sorted_tst_p);
+		return;
 	}
 
 	struct ts_range_stack range_stack[20];
@@ -806,24 +1270,218 @@ static void dump_timestamps(enum timestamps_print_type output_type)
 		printf("\n");
 	}
 
-	unmap_memory(&timestamp_mapping);
 	free(sorted_tst_p);
 }
 
+/* Read a dump captured with `cbmem -T`. The stamps of the table are in microseconds. */
+static struct timestamp_table *read_parseable_timestamps(const char *path)
+{
+	struct timestamp_table *tst_p;
+	uint32_t capacity = 64;
+	char line[256];
+	FILE *f;
+
+	f = fopen(path, "r");
+	if (!f) {
+		fprintf(stderr, "Could not open %s: %s\n", path, strerror(errno));
+		exit(1);
+	}
+
+	tst_p = calloc(1, sizeof(*tst_p) + capacity * sizeof(tst_p->entries[0]));
+	if (!tst_p)
+		die("Failed to allocate memory");
+
+	while (fgets(line, sizeof(line), f)) {
+		unsigned long long stamp, step;
+		unsigned int id;
+
+		if (sscanf(line, "%u\t%llu\t%llu", &id, &stamp, &step) != 3)
+			continue;
+
+		if (tst_p->num_entries == capacity) {
+			capacity *= 2;
+			tst_p = realloc(tst_p, sizeof(*tst_p) +
+					capacity * sizeof(tst_p->entries[0]));
+			if (!tst_p)
+				die("Failed to allocate memory");
+		}
+		tst_p->entries[tst_p->num_entries].entry_id = id;
+		tst_p->entries[tst_p->num_entries].entry_stamp = stamp;
+		tst_p->num_entries++;
+	}
+	fclose(f);
+
+	if (!tst_p->num_entries) {
+		fprintf(stderr, "No timestamps found in %s.\n", path);
+		exit(1);
+	}
+
+	return tst_p;
+}
+
+static const char *timestamp_diff_name(uint32_t id)
+{
+	return id ? get_timestamp_name(id) : "TS_START";
+}
+
+static void print_timestamp_diff(const char *name, const uint64_t *old, const uint64_t *new)
+{
+	printf("%-40s", name);
+	if (old)
+		printf(" %12" PRIu64, *old);
+	else
+		printf(" %12s", "-");
+	if (new)
+		printf(" %12" PRIu64, *new);
+	else
+		printf(" %12s", "-");
+	if (old && new)
+		printf(" %+12" PRId64 "\n", (int64_t)(*new - *old));
+	else
+		printf(" %12s\n", old ? "missing" : "new");
+}
+
+/*
+ * Compare two dumps captured with `cbmem -T`, step by step and per stage. A timestamp that
+ * shows up several times is matched with the same occurrence in the other dump.
+ */
+static void diff_timestamps(const char *old_path, const char *new_path)
+{
+	struct timestamp_table *old = read_parseable_timestamps(old_path);
+	struct timestamp_table *new = read_parseable_timestamps(new_path);
+	struct ts_stage *old_stages, *new_stages;
+	size_t num_old_stages, num_new_stages;
+	bool *matched;
+
+	/* The dumps are in microseconds already. */
+	tick_freq_mhz = 1;
+
+	matched = calloc(old->num_entries, sizeof(*matched));
+	old_stages = malloc(old->num_entries * sizeof(*old_stages));
+	new_stages = malloc(new->num_entries * sizeof(*new_stages));
+	if (!matched || !old_stages || !new_stages)
+		die("Failed to allocate memory");
+
+	printf("%-40s %12s %12s %12s\n", "step (usecs since previous)", "old", "new",
+	       "change");
+
+	for (uint32_t i = 0; i < new->num_entries; i++) {
+		const uint32_t id = new->entries[i].entry_id;
+		const uint64_t new_step = i ? new->entries[i].entry_stamp -
+					      new->entries[i - 1].entry_stamp : 0;
+		uint32_t j;
+
+		for (j = 0; j < old->num_entries; j++)
+			if (!matched[j] && old->entries[j].entry_id == id)
+				break;
+
+		if (j == old->num_entries) {
+			print_timestamp_diff(timestamp_diff_name(id), NULL, &new_step);
+			continue;
+		}
+
+		const uint64_t old_step = j ? old->entries[j].entry_stamp -
+					      old->entries[j - 1].entry_stamp : 0;
+
+		matched[j] = true;
+		print_timestamp_diff(timestamp_diff_name(id), &old_step, &new_step);
+	}
+
+	for (uint32_t j = 0; j < old->num_entries; j++) {
+		const uint64_t old_step = j ? old->entries[j].entry_stamp -
+					      old->entries[j - 1].entry_stamp : 0;
+
+		if (!matched[j])
+			print_timestamp_diff(timestamp_diff_name(old->entries[j].entry_id),
+					     &old_step, NULL);
+	}
+
+	num_old_stages = find_timestamp_stages(old, old_stages);
+	num_new_stages = find_timestamp_stages(new, new_stages);
+
+	printf("\n%-40s %12s %12s %12s\n", "stage (usecs)", "old", "new", "change");
+	memset(matched, 0, old->num_entries * sizeof(*matched));
+	for (size_t s = 0; s < num_new_stages; s++) {
+		size_t t;
+
+		for (t = 0; t < num_old_stages; t++)
+			if (!matched[t] && !strcmp(old_stages[t].name, new_stages[s].name))
+				break;
+
+		if (t < num_old_stages)
+			matched[t] = true;
+		print_timestamp_diff(new_stages[s].name,
+				     t < num_old_stages ? &old_stages[t].duration : NULL,
+				     &new_stages[s].duration);
+	}
+	for (size_t t = 0; t < num_old_stages; t++)
+		if (!matched[t])
+			print_timestamp_diff(old_stages[t].name, &old_stages[t].duration, NULL);
+
+	const uint64_t old_total = sorted_stamp_us(old, old->num_entries - 1) -
+				   sorted_stamp_us(old, 0);
+	const uint64_t new_total = sorted_stamp_us(new, new->num_entries - 1) -
+				   sorted_stamp_us(new, 0);
+	printf("\n");
+	print_timestamp_diff("total", &old_total, &new_total);
+
+	free(matched);
+	free(old_stages);
+	free(new_stages);
+	free(old);
+	free(new);
+}
+
+/* Map the whole timestamp table chunk at |addr|, including its unused entries. */
+static struct timestamp_table *map_timestamp_chunk(struct mapping *mapping, uint64_t addr)
+{
+	const struct timestamp_table *header;
+	struct timestamp_table *tst_p;
+	size_t size;
+
+	header = map_memory(mapping, addr, sizeof(*header));
+	if (!header)
+		die("Unable to map timestamp header\n");
+	size = sizeof(*header) + header->max_entries * sizeof(header->entries[0]);
+	unmap_memory(mapping);
+
+	tst_p = map_memory_with_prot(mapping, addr, size, PROT_READ | PROT_WRITE);
+	if (!tst_p)
+		die("Unable to map timestamp table\n");
+	if (tst_p->num_entries > tst_p->max_entries)
+		die("Timestamp table is corrupted\n");
+
+	return tst_p;
+}
+
 /* add a timestamp entry */
 static void timestamp_add_now(uint32_t timestamp_id)
 {
 	struct timestamp_table *tst_p;
 	struct mapping timestamp_mapping;
+	uint64_t addr = timestamps.cbmem_addr;
+	unsigned int chunks = 0;
 
 	if (timestamps.tag != LB_TAG_TIMESTAMPS) {
 		die("No timestamps found in coreboot table.\n");
 	}
 
-	tst_p = map_memory_with_prot(&timestamp_mapping, timestamps.cbmem_addr,
-				     timestamps.size, PROT_READ | PROT_WRITE);
-	if (!tst_p)
-		die("Unable to map timestamp table\n");
+	/* A table that coreboot had to grow continues in other chunks. Only the last one can
+	   take more entries. */
+	for (;;) {
+		const struct timestamp_entry *last;
+
+		tst_p = map_timestamp_chunk(&timestamp_mapping, addr);
+		if (!tst_p->num_entries)
+			break;
+		last = &tst_p->entries[tst_p->num_entries - 1];
+		if (last->entry_id != TS_TABLE_CONTINUATION)
+			break;
+		if (++chunks > 1024)
+			die("Timestamp table chunks form a loop\n");
+		addr = last->entry_stamp;
+		unmap_memory(&timestamp_mapping);
+	}
 
 	/*
 	 * Note that coreboot sizes the cbmem entry in the table according to
@@ -1113,6 +1771,168 @@ static void dump_tpm_log(void)
 		dump_tpm_cb_log();
 }
 
+enum bs_profile_print_type {
+	BS_PROFILE_PRINT_NONE,
+	BS_PROFILE_PRINT_SORTED,
+	BS_PROFILE_PRINT_FOLDED,
+};
+
+static const char *const bs_profile_state_names[] = { BS_PROFILE_STATE_NAMES };
+static const char *const bs_profile_phase_names[] = { "entry", "run", "exit" };
+static const char *const bs_profile_kind_names[] = {
+	[BS_PROFILE_STATE] = "state",
+	[BS_PROFILE_CALLBACK] = "callback",
+	[BS_PROFILE_DEV_INIT] = "init",
+	[BS_PROFILE_DEV_FINAL] = "final",
+};
+
+static const char *bs_profile_lookup(const char *const *names, size_t count, unsigned int i)
+{
+	if (i >= count || !names[i])
+		return "unknown";
+	return names[i];
+}
+
+#define bs_profile_lookup_name(names, i) bs_profile_lookup(names, ARRAY_SIZE(names), i)
+
+static bool bs_profile_is_dev_op(const struct bs_profile_entry *e)
+{
+	return e->kind == BS_PROFILE_DEV_INIT || e->kind == BS_PROFILE_DEV_FINAL;
+}
+
+/* Device operations run inside a state function or a callback. Returns true if |inner| did. */
+static bool bs_profile_contains(const struct bs_profile_entry *outer,
+				const struct bs_profile_entry *inner)
+{
+	if (outer == inner || bs_profile_is_dev_op(outer) || !bs_profile_is_dev_op(inner))
+		return false;
+
+	return outer->state == inner->state && outer->phase == inner->phase &&
+	       outer->start_us <= inner->start_us &&
+	       inner->start_us + inner->duration_us <= outer->start_us + outer->duration_us;
+}
+
+/* Print one flame graph frame. Semicolons separate frames, so they can't be part of one. */
+static void bs_profile_print_frame(const struct bs_profile_entry *e)
+{
+	char name[BS_PROFILE_NAME_LEN + 1];
+
+	memcpy(name, e->name, BS_PROFILE_NAME_LEN);
+	name[BS_PROFILE_NAME_LEN] = '\0';
+	for (char *p = name; *p; p++)
+		if (*p == ';')
+			*p = ':';
+
+	if (bs_profile_is_dev_op(e))
+		printf(";%s %s", name, bs_profile_lookup_name(bs_profile_kind_names, e->kind));
+	else if (e->kind == BS_PROFILE_CALLBACK && name[0])
+		printf(";%s", name);
+	else if (e->kind == BS_PROFILE_CALLBACK)
+		printf(";0x%llx", (unsigned long long)e->func);
+}
+
+/* Collapsed stacks, "state;phase;callback;device op self-time", for flamegraph.pl. */
+static void bs_profile_print_folded(const struct bs_profile_table *t)
+{
+	for (uint32_t i = 0; i < t->num_entries; i++) {
+		const struct bs_profile_entry *e = &t->entries[i];
+		const struct bs_profile_entry *parent = NULL;
+		uint64_t children = 0;
+
+		for (uint32_t j = 0; j < t->num_entries; j++) {
+			if (bs_profile_contains(e, &t->entries[j]))
+				children += t->entries[j].duration_us;
+			if (!parent && bs_profile_contains(&t->entries[j], e))
+				parent = &t->entries[j];
+		}
+
+		printf("ramstage;%s;%s",
+		       bs_profile_lookup_name(bs_profile_state_names, e->state),
+		       bs_profile_lookup_name(bs_profile_phase_names, e->phase));
+		if (parent)
+			bs_profile_print_frame(parent);
+		bs_profile_print_frame(e);
+		printf(" %llu\n", (unsigned long long)(e->duration_us > children ?
+						       e->duration_us - children : 0));
+	}
+}
+
+static int compare_bs_profile_entries(const void *a, const void *b)
+{
+	const struct bs_profile_entry *ea = a;
+	const struct bs_profile_entry *eb = b;
+
+	if (ea->duration_us != eb->duration_us)
+		return ea->duration_us < eb->duration_us ? 1 : -1;
+	return ea->start_us < eb->start_us ? -1 : ea->start_us > eb->start_us;
+}
+
+static void bs_profile_print_sorted(const struct bs_profile_table *t)
+{
+	struct bs_profile_entry *sorted;
+	uint64_t total = 0;
+
+	sorted = malloc(t->num_entries * sizeof(*sorted));
+	if (!sorted)
+		die("Out of memory.\n");
+	memcpy(sorted, t->entries, t->num_entries * sizeof(*sorted));
+	qsort(sorted, t->num_entries, sizeof(*sorted), compare_bs_profile_entries);
+
+	printf("%u entries, %u dropped\n\n", t->num_entries, t->dropped);
+	printf("%12s  %-18s %-5s %-8s %-18s %s\n", "usecs", "state", "phase", "kind",
+	       "function", "name");
+
+	for (uint32_t i = 0; i < t->num_entries; i++) {
+		const struct bs_profile_entry *e = &sorted[i];
+
+		if (!bs_profile_is_dev_op(e))
+			total += e->duration_us;
+
+		printf("%12llu  %-18s %-5s %-8s 0x%016llx %.*s\n",
+		       (unsigned long long)e->duration_us,
+		       bs_profile_lookup_name(bs_profile_state_names, e->state),
+		       bs_profile_lookup_name(bs_profile_phase_names, e->phase),
+		       bs_profile_lookup_name(bs_profile_kind_names, e->kind),
+		       (unsigned long long)e->func, BS_PROFILE_NAME_LEN, e->name);
+	}
+
+	/* Device operations are already part of the state function or callback they ran in. */
+	printf("\nTotal in state functions and callbacks: %llu usecs\n",
+	       (unsigned long long)total);
+
+	free(sorted);
+}
+
+static void dump_bs_profile(enum bs_profile_print_type type)
+{
+	const struct bs_profile_table *t;
+	struct mapping profile_mapping;
+	uint64_t start;
+	size_t size;
+
+	if (find_cbmem_entry(CBMEM_ID_BS_PROFILE, &start, &size)) {
+		fprintf(stderr, "No boot state profile found\n");
+		return;
+	}
+
+	if (size < sizeof(*t))
+		die("Boot state profile too small.\n");
+
+	t = map_memory(&profile_mapping, start, size);
+	if (!t)
+		die("Unable to map boot state profile.\n");
+
+	if (t->num_entries > (size - sizeof(*t)) / sizeof(t->entries[0]))
+		die("Boot state profile is corrupted.\n");
+
+	if (type == BS_PROFILE_PRINT_FOLDED)
+		bs_profile_print_folded(t);
+	else
+		bs_profile_print_sorted(t);
+
+	unmap_memory(&profile_mapping);
+}
+
 struct cbmem_console {
 	u32 size;
 	u32 cursor;
@@ -1151,6 +1971,46 @@ static int parse_loglevel(char *arg, int *print_unknown_logs)
 	return BIOS_NEVER;
 }
 
+/* Slight memory corruption may occur between reboots and give us a few unprintable characters
+   like '\0'. Replace them with '?' on output. */
+static void sanitize_console(char *console_c, size_t size)
+{
+	for (size_t i = 0; i < size; i++)
+		if (!isprint(console_c[i]) && !isspace(console_c[i])
+		    && !BIOS_LOG_IS_MARKER(console_c[i]))
+			console_c[i] = '?';
+}
+
+static void print_console(const char *console_c, int max_loglevel, int print_unknown_logs)
+{
+	char c;
+	int suppressed = 0;
+	int tty = isatty(fileno(stdout));
+	while ((c = *console_c++)) {
+		if (BIOS_LOG_IS_MARKER(c)) {
+			int lvl = BIOS_LOG_MARKER_TO_LEVEL(c);
+			if (lvl > max_loglevel) {
+				suppressed = 1;
+				continue;
+			}
+			suppressed = 0;
+			if (tty)
+				printf(BIOS_LOG_ESCAPE_PATTERN, bios_log_escape[lvl]);
+			printf(BIOS_LOG_PREFIX_PATTERN, bios_log_prefix[lvl]);
+		} else {
+			if (!suppressed)
+				putchar(c);
+			if (c == '\n') {
+				if (tty && !suppressed)
+					printf(BIOS_LOG_ESCAPE_RESET);
+				suppressed = !print_unknown_logs;
+			}
+		}
+	}
+	if (tty)
+		printf(BIOS_LOG_ESCAPE_RESET);
+}
+
 /* dump the cbmem console */
 static void dump_console(enum console_print_type type, int max_loglevel, int print_unknown_logs)
 {
@@ -1203,12 +2063,7 @@ static void dump_console(enum console_print_type type, int max_loglevel, int pri
 		aligned_memcpy(console_c, console_p->body, size);
 	}
 
-	/* Slight memory corruption may occur between reboots and give us a few
-	   unprintable characters like '\0'. Replace them with '?' on output. */
-	for (cursor = 0; cursor < size; cursor++)
-		if (!isprint(console_c[cursor]) && !isspace(console_c[cursor])
-		    && !BIOS_LOG_IS_MARKER(console_c[cursor]))
-			console_c[cursor] = '?';
+	sanitize_console(console_c, size);
 
 	/* We detect the reboot cutoff by looking for a bootblock, romstage or
 	   ramstage banner, in that order (to account for platforms without
@@ -1247,37 +2102,103 @@ static void dump_console(enum console_print_type type, int max_loglevel, int pri
 		cursor = previous;
 	}
 
-	char c;
-	int suppressed = 0;
-	int tty = isatty(fileno(stdout));
-	while ((c = console_c[cursor++])) {
-		if (BIOS_LOG_IS_MARKER(c)) {
-			int lvl = BIOS_LOG_MARKER_TO_LEVEL(c);
-			if (lvl > max_loglevel) {
-				suppressed = 1;
-				continue;
-			}
-			suppressed = 0;
-			if (tty)
-				printf(BIOS_LOG_ESCAPE_PATTERN, bios_log_escape[lvl]);
-			printf(BIOS_LOG_PREFIX_PATTERN, bios_log_prefix[lvl]);
-		} else {
-			if (!suppressed)
-				putchar(c);
-			if (c == '\n') {
-				if (tty && !suppressed)
-					printf(BIOS_LOG_ESCAPE_RESET);
-				suppressed = !print_unknown_logs;
-			}
-		}
-	}
-	if (tty)
-		printf(BIOS_LOG_ESCAPE_RESET);
+	print_console(console_c + cursor, max_loglevel, print_unknown_logs);
 
 	free(console_c);
 	unmap_memory(&console_mapping);
 }
 
+/*
+ * Print only the console output that was added since the last run with the same state file,
+ * which keeps the address and cursor of the console. The first run prints all of it. Output is
+ * lost if the console wrapped around more than once in between.
+ */
+static void dump_console_since(const char *state_path, int max_loglevel,
+			       int print_unknown_logs)
+{
+	const struct cbmem_console *console_p;
+	struct mapping console_mapping;
+	unsigned long long old_addr = 0;
+	uint32_t old_raw = 0, raw, size, cursor, from, len, first;
+	bool fresh, lapped = false;
+	char *console_c;
+	FILE *f;
+
+	if (console.tag != LB_TAG_CBMEM_CONSOLE) {
+		fprintf(stderr, "No console found in coreboot table.\n");
+		return;
+	}
+
+	f = fopen(state_path, "r");
+	if (f) {
+		if (fscanf(f, "%llx %" SCNx32, &old_addr, &old_raw) != 2)
+			old_addr = 0;
+		fclose(f);
+	}
+
+	console_p = map_memory(&console_mapping, console.cbmem_addr, sizeof(*console_p));
+	if (!console_p)
+		die("Unable to map console object.\n");
+	size = console_p->size;
+	unmap_memory(&console_mapping);
+	if (!size)
+		return;
+
+	console_p = map_memory(&console_mapping, console.cbmem_addr, size + sizeof(*console_p));
+	if (!console_p)
+		die("Unable to map full console object.\n");
+
+	/* Everything below works on this one snapshot of the cursor. */
+	raw = console_p->cursor;
+	cursor = MIN(raw & CBMC_CURSOR_MASK, size);
+	if ((raw & CBMC_OVERFLOW) && cursor == size)
+		cursor = 0;
+	from = old_raw & CBMC_CURSOR_MASK;
+
+	/* Start over if the console moved or was reset, e.g. by a reboot. */
+	fresh = old_addr != console.cbmem_addr || from > size ||
+		(!(raw & CBMC_OVERFLOW) && ((old_raw & CBMC_OVERFLOW) || from > cursor));
+
+	if (fresh) {
+		from = (raw & CBMC_OVERFLOW) ? cursor : 0;
+		len = (raw & CBMC_OVERFLOW) ? size : cursor;
+	} else if (!(raw & CBMC_OVERFLOW)) {
+		len = cursor - from;
+	} else if (!(old_raw & CBMC_OVERFLOW) && from <= cursor) {
+		/* Wrapped around and went past the old cursor again. */
+		lapped = true;
+		from = cursor;
+		len = size;
+	} else {
+		len = (cursor + size - from) % size;
+	}
+
+	console_c = malloc(len + 1);
+	if (!console_c)
+		die("Not enough memory for console.\n");
+
+	first = MIN(len, size - from);
+	aligned_memcpy(console_c, console_p->body + from, first);
+	aligned_memcpy(console_c + first, console_p->body, len - first);
+	console_c[len] = '\0';
+	unmap_memory(&console_mapping);
+
+	if (lapped)
+		fprintf(stderr, "cbmem: console wrapped around, some output was lost.\n");
+
+	sanitize_console(console_c, len);
+	print_console(console_c, max_loglevel, print_unknown_logs);
+	free(console_c);
+
+	f = fopen(state_path, "w");
+	if (!f || fprintf(f, "%llx %" PRIx32 "\n",
+			  (unsigned long long)console.cbmem_addr, raw) < 0 || fclose(f)) {
+		fprintf(stderr, "Unable to save console state to %s: %s\n", state_path,
+			strerror(errno));
+		exit(1);
+	}
+}
+
 static void hexdump(unsigned long memory, int length)
 {
 	int i;
@@ -1343,41 +2264,16 @@ static void rawdump(uint64_t base, uint64_t size)
 
 static void dump_cbmem_raw(unsigned int id)
 {
-	const uint8_t *table;
-	size_t offset;
-	uint64_t base = 0;
-	uint64_t size = 0;
-
-	table = mapping_virt(&lbtable_mapping);
+	uint64_t base;
+	size_t size;
 
-	if (table == NULL)
+	if (find_cbmem_entry(id, &base, &size) || !base) {
+		fprintf(stderr, "id %0x not found in cbtable\n", id);
 		return;
-
-	offset = 0;
-
-	while (offset < mapping_size(&lbtable_mapping)) {
-		const struct lb_record *lbr;
-		struct lb_cbmem_entry lbe;
-
-		lbr = (const void *)(table + offset);
-		offset += lbr->size;
-
-		if (lbr->tag != LB_TAG_CBMEM_ENTRY)
-			continue;
-
-		aligned_memcpy(&lbe, lbr, sizeof(lbe));
-		if (lbe.id == id) {
-			debug("found id for raw dump %0x", lbe.id);
-			base = lbe.address;
-			size = lbe.entry_size;
-			break;
-		}
 	}
 
-	if (!base)
-		fprintf(stderr, "id %0x not found in cbtable\n", id);
-	else
-		rawdump(base, size);
+	debug("found id for raw dump %0x", id);
+	rawdump(base, size);
 }
 
 struct cbmem_id_to_name {
@@ -1435,6 +2331,13 @@ static void dump_cbmem_toc(void)
 	printf("    %-20s  %-8s  %-8s  %-8s\n", "NAME", "ID", "START",
 			"LENGTH");
 
+	if (imd_entries) {
+		for (size_t n = 0; n < imd_num_entries; n++)
+			cbmem_print_entry(n, imd_entries[n].id, imd_entries[n].address,
+					  imd_entries[n].size);
+		return;
+	}
+
 	i = 0;
 	offset = 0;
 
@@ -1554,11 +2457,12 @@ static void print_version(void)
 
 static void print_usage(const char *name, int exit_code)
 {
-	printf("usage: %s [-cCltTLxVvh?]\n", name);
+	printf("usage: %s [-cnCltTjEDLPFMxVvh?]\n", name);
 	printf("\n"
 	     "   -c | --console:                   print cbmem console\n"
 	     "   -1 | --oneboot:                   print cbmem console for last boot only\n"
 	     "   -2 | --2ndtolast:                 print cbmem console for the boot that came before the last one only\n"
+	     "   -n | --console-since FILE:        print cbmem console output added since the cursor saved in FILE, then update FILE\n"
 	     "   -B | --loglevel:                  maximum loglevel to print; prefix `+` (e.g. -B +INFO) to also print lines that have no level\n"
 	     "   -C | --coverage:                  dump coverage information\n"
 	     "   -l | --list:                      print cbmem table of contents\n"
@@ -1567,8 +2471,14 @@ static void print_usage(const char *name, int exit_code)
 	     "   -t | --timestamps:                print timestamp information\n"
 	     "   -T | --parseable-timestamps:      print parseable timestamps\n"
 	     "   -S | --stacked-timestamps:        print stacked timestamps (e.g. for flame graph tools)\n"
+	     "   -j | --json-timestamps:           print timestamps, nested ranges and stage totals as JSON\n"
+	     "   -E | --trace-timestamps:          print timestamps in Chrome trace event format\n"
+	     "   -D | --diff-timestamps OLD NEW:   compare two timestamp dumps captured with -T\n"
 	     "   -a | --add-timestamp ID:          append timestamp with ID\n"
 	     "   -L | --tcpa-log                   print TPM log\n"
+	     "   -P | --bootstate-profile:         print boot state profile, most expensive first\n"
+	     "   -F | --bootstate-flamegraph:      print boot state profile as folded stacks (e.g. for flame graph tools)\n"
+	     "   -M | --map-cbmem:                 map all of CBMEM once and list its entries from the imd at its top\n"
 	     "   -V | --verbose:                   verbose (debugging) output\n"
 	     "   -v | --version:                   print the version\n"
 	     "   -h | --help:                      print this help\n"
@@ -1701,33 +2611,44 @@ int main(int argc, char** argv)
 	int print_rawdump = 0;
 	int print_tcpa_log = 0;
 	enum timestamps_print_type timestamp_type = TIMESTAMPS_PRINT_NONE;
+	enum bs_profile_print_type bs_profile_type = BS_PROFILE_PRINT_NONE;
 	enum console_print_type console_type = CONSOLE_PRINT_FULL;
 	unsigned int rawdump_id = 0;
 	int max_loglevel = BIOS_NEVER;
 	int print_unknown_logs = 1;
 	uint32_t timestamp_id = 0;
+	const char *diff_old = NULL;
+	const char *console_state = NULL;
+	int map_all = 0;
 
 	int opt, option_index = 0;
 	static struct option long_options[] = {
 		{"console", 0, 0, 'c'},
 		{"oneboot", 0, 0, '1'},
 		{"2ndtolast", 0, 0, '2'},
+		{"console-since", required_argument, 0, 'n'},
 		{"loglevel", required_argument, 0, 'B'},
 		{"coverage", 0, 0, 'C'},
 		{"list", 0, 0, 'l'},
 		{"tcpa-log", 0, 0, 'L'},
+		{"bootstate-profile", 0, 0, 'P'},
+		{"bootstate-flamegraph", 0, 0, 'F'},
 		{"timestamps", 0, 0, 't'},
 		{"parseable-timestamps", 0, 0, 'T'},
 		{"stacked-timestamps", 0, 0, 'S'},
+		{"json-timestamps", 0, 0, 'j'},
+		{"trace-timestamps", 0, 0, 'E'},
+		{"diff-timestamps", required_argument, 0, 'D'},
 		{"add-timestamp", required_argument, 0, 'a'},
 		{"hexdump", 0, 0, 'x'},
 		{"rawdump", required_argument, 0, 'r'},
+		{"map-cbmem", 0, 0, 'M'},
 		{"verbose", 0, 0, 'V'},
 		{"version", 0, 0, 'v'},
 		{"help", 0, 0, 'h'},
 		{0, 0, 0, 0}
 	};
-	while ((opt = getopt_long(argc, argv, "c12B:CltTSa:LxVvh?r:",
+	while ((opt = getopt_long(argc, argv, "c12n:B:CltTSjED:a:LPFMxVvh?r:",
 				  long_options, &option_index)) != EOF) {
 		switch (opt) {
 		case 'c':
@@ -1744,6 +2665,10 @@ int main(int argc, char** argv)
 			console_type = CONSOLE_PRINT_PREVIOUS;
 			print_defaults = 0;
 			break;
+		case 'n':
+			console_state = optarg;
+			print_defaults = 0;
+			break;
 		case 'B':
 			max_loglevel = parse_loglevel(optarg, &print_unknown_logs);
 			break;
@@ -1759,6 +2684,14 @@ int main(int argc, char** argv)
 			print_tcpa_log = 1;
 			print_defaults = 0;
 			break;
+		case 'P':
+			bs_profile_type = BS_PROFILE_PRINT_SORTED;
+			print_defaults = 0;
+			break;
+		case 'F':
+			bs_profile_type = BS_PROFILE_PRINT_FOLDED;
+			print_defaults = 0;
+			break;
 		case 'x':
 			print_hexdump = 1;
 			print_defaults = 0;
@@ -1780,6 +2713,17 @@ int main(int argc, char** argv)
 			timestamp_type = TIMESTAMPS_PRINT_STACKED;
 			print_defaults = 0;
 			break;
+		case 'j':
+			timestamp_type = TIMESTAMPS_PRINT_JSON;
+			print_defaults = 0;
+			break;
+		case 'E':
+			timestamp_type = TIMESTAMPS_PRINT_TRACE;
+			print_defaults = 0;
+			break;
+		case 'D':
+			diff_old = optarg;
+			break;
 		case 'a':
 			print_defaults = 0;
 			timestamp_id = timestamp_enum_name_to_id(optarg);
@@ -1787,6 +2731,9 @@ int main(int argc, char** argv)
 			if (timestamp_id == 0)
 				timestamp_id = strtoul(optarg, NULL, 0);
 			break;
+		case 'M':
+			map_all = 1;
+			break;
 		case 'V':
 			verbose = 1;
 			break;
@@ -1804,6 +2751,16 @@ int main(int argc, char** argv)
 		}
 	}
 
+	/* Comparing dumps doesn't need access to memory. */
+	if (diff_old) {
+		if (optind != argc - 1) {
+			fprintf(stderr, "Error: --diff-timestamps needs two files.\n");
+			print_usage(argv[0], 1);
+		}
+		diff_timestamps(diff_old, argv[optind]);
+		return 0;
+	}
+
 	if (optind < argc) {
 		fprintf(stderr, "Error: Extra parameter found.\n");
 		print_usage(argv[0], 1);
@@ -1881,9 +2838,15 @@ int main(int argc, char** argv)
 	if (mapping_virt(&lbtable_mapping) == NULL)
 		die("Table not found.\n");
 
+	if (map_all && map_cbmem() < 0)
+		fprintf(stderr, "Unable to map CBMEM, using the coreboot table.\n");
+
 	if (print_console)
 		dump_console(console_type, max_loglevel, print_unknown_logs);
 
+	if (console_state)
+		dump_console_since(console_state, max_loglevel, print_unknown_logs);
+
 	if (print_coverage)
 		dump_coverage();
 
@@ -1908,7 +2871,12 @@ int main(int argc, char** argv)
 	if (print_tcpa_log)
 		dump_tpm_log();
 
+	if (bs_profile_type != BS_PROFILE_PRINT_NONE)
+		dump_bs_profile(bs_profile_type);
+
 	unmap_memory(&lbtable_mapping);
+	free(imd_entries);
+	unmap_memory(&cbmem_mapping);
 
 	close(mem_fd);
 	return 0;